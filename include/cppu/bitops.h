@@ -30,6 +30,9 @@ namespace cppu
 
 	inline uint32 bsf(uint32 value, uint offset)
 	{
+		if (offset >= 32)
+			return 32;
+
 		value = value >> offset;
 
 #ifdef WIN32
@@ -58,6 +61,9 @@ namespace cppu
 
 	inline uint32 bsr(uint32 value, uint offset)
 	{
+		if (offset >= 32)
+			return 32;
+
 		value = value << offset;
 
 #ifdef WIN32
@@ -71,6 +77,66 @@ namespace cppu
 #endif
 	}
 
+	inline uint32 bsf(uint64 value)
+	{
+#ifdef _WIN64
+		unsigned long index = 0;
+		unsigned char det = _BitScanForward64(&index, value);
+		return det ? index : 64;
+#elif WIN32
+		uint32 index = bsf(uint32(value));
+		return index < 32 ? index : bsf(uint32(value >> 32)) + 32;
+#elif __GNUC__
+		return value == 0 ? 64 : __builtin_ctzll(value);
+#else
+#error "Not implemented"
+#endif
+	}
+
+	inline uint32 bsf(uint64 value, uint offset)
+	{
+		if (offset >= 64)
+			return 64;
+
+		uint32 index = bsf(uint64(value >> offset));
+		return index < 64 ? index + offset : 64;
+	}
+
+	inline uint32 bsr(uint64 value)
+	{
+#ifdef _WIN64
+		unsigned long index = 0;
+		unsigned char det = _BitScanReverse64(&index, value);
+		return det ? 63 - index : 64;
+#elif WIN32
+		uint32 index = bsr(uint32(value >> 32));
+		return index < 32 ? index : bsr(uint32(value)) + 32;
+#elif __GNUC__
+		return value == 0 ? 64 : __builtin_clzll(value);
+#else
+#error "Not implemented"
+#endif
+	}
+
+	inline uint32 bsr(uint64 value, uint offset)
+	{
+		if (offset >= 64)
+			return 64;
+
+		uint32 index = bsr(uint64(value << offset));
+		return index < 64 ? index + offset : 64;
+	}
+
+	// smaller types are scanned as 32 bit values, keeps the overloads unambiguous
+	inline uint32 bsf(uint8 value) { return bsf(uint32(value)); }
+	inline uint32 bsf(uint16 value) { return bsf(uint32(value)); }
+	inline uint32 bsf(uint8 value, uint offset) { return bsf(uint32(value), offset); }
+	inline uint32 bsf(uint16 value, uint offset) { return bsf(uint32(value), offset); }
+	inline uint32 bsr(uint8 value) { return bsr(uint32(value)); }
+	inline uint32 bsr(uint16 value) { return bsr(uint32(value)); }
+	inline uint32 bsr(uint8 value, uint offset) { return bsr(uint32(value), offset); }
+	inline uint32 bsr(uint16 value, uint offset) { return bsr(uint32(value), offset); }
+
 	// helper functions
 	inline uint bs_ltor(uint32 value)
 	{
@@ -91,29 +157,46 @@ namespace cppu
 	{
 		return bsf(value, offset);
 	}
+
+	inline uint bs_ltor(uint64 value)
+	{
+		return bsr(value);
+	}
+
+	inline uint bs_ltor(uint64 value, uint offset)
+	{
+		return bsr(value, offset);
+	}
+
+	inline uint bs_rtol(uint64 value)
+	{
+		return bsf(value);
+	}
+
+	inline uint bs_rtol(uint64 value, uint offset)
+	{
+		return bsf(value, offset);
+	}
+
+	inline uint bs_ltor(uint8 value) { return bsr(value); }
+	inline uint bs_ltor(uint16 value) { return bsr(value); }
+	inline uint bs_ltor(uint8 value, uint offset) { return bsr(value, offset); }
+	inline uint bs_ltor(uint16 value, uint offset) { return bsr(value, offset); }
+	inline uint bs_rtol(uint8 value) { return bsf(value); }
+	inline uint bs_rtol(uint16 value) { return bsf(value); }
+	inline uint bs_rtol(uint8 value, uint offset) { return bsf(value, offset); }
+	inline uint bs_rtol(uint16 value, uint offset) { return bsf(value, offset); }
 	
 	template<typename T>
 	T set_bit(std::atomic<T> &a, T bit)
 	{
-		T val = a.load();
-		T setValue = val | bit;
-		
-		while (!a.compare_exchange_weak(val, setValue))
-			setValue = val | bit;
-
-		return val;
+		return a.fetch_or(bit);
 	}
 	
 	template<typename T>
 	T clr_bit(std::atomic<T> &a, T bit)
 	{
-		T val = a.load();
-		T setValue = val & ~bit;
-		
-		while (!a.compare_exchange_weak(val, setValue))
-			setValue = val & ~bit;
-
-		return val;
+		return a.fetch_and(~bit);
 	}
 
 	template<typename T>
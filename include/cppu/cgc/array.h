@@ -7,9 +7,17 @@
 #include <cassert>
 
 #include "pointers.h"
-#include "details/container_counter.h"
+#include "details/base_counter.h"
 #include "details/icontainer.h"
 #include "details/garbage_cleaner.h"
+#include "details/free_bitmap.h"
+#include "details/slot_mask.h"
+#include "details/epoch.h"
+#include "details/slot_batch.h"
+#include "details/stats.h"
+#include "handle.h"
+#include "soa.h"
+#include "relocatable.h"
 #include "constructor.h"
 
 #include "../bitops.h"
@@ -24,16 +32,30 @@ namespace cppu
 		typedef uint16_t SIZE_16;
 		typedef uint32_t SIZE_32;
 		typedef uint64_t SIZE_64;
+
+		// wide blocks, slot masks are stored as multiple 64 bit words
+		typedef details::wide_bits<128> SIZE_128;
+		typedef details::wide_bits<256> SIZE_256;
+		typedef details::wide_bits<512> SIZE_512;
+		typedef details::wide_bits<1024> SIZE_1024;
+		typedef details::wide_bits<2048> SIZE_2048;
+		typedef details::wide_bits<4096> SIZE_4096;
 		
-		template<class T, class S = SIZE_32, CLEAN_PROC clean_proc = CLEAN_PROC::DIRECT>
-		class array : public details::icontainer
+		template<class T, class S = SIZE_32, CLEAN_PROC clean_proc = CLEAN_PROC::DIRECT, class policy = thread_policy::shared>
+		class array : public details::icontainer, private details::column_store<T, details::slot_mask<S>::digits>
 		{
-			template<typename, typename, CLEAN_PROC> friend class m_array;
+			template<typename, typename, CLEAN_PROC, typename> friend class m_array;
+			template<typename, typename> friend class details::slot_batch;
+			static_assert(policy::atomic || clean_proc == CLEAN_PROC::DIRECT || clean_proc == CLEAN_PROC::MANUAL, "thread_policy::local arrays can't be cleaned by other threads");
+			static_assert(details::slot_mask<S>::digits <= (size_t(1) << handle<T>::slot_bits), "slot index doesn't fit in a handle");
 		public:
-			static constexpr size_t size() { return std::numeric_limits<S>::digits; }
+			typedef details::slot_batch<T, cgc::array<T, S, clean_proc, policy>> batch;
+			typedef cgc::chunk<T, S> chunk;
+
+			static constexpr size_t size() { return details::slot_mask<S>::digits; }
 
 		private:
-			static constexpr size_t const npos = std::numeric_limits<S>::digits;
+			static constexpr size_t const npos = details::slot_mask<S>::npos;
 
 			// Disable RAII by using a union as this should only reserve/allocate memory for the types later on
 			union
@@ -41,88 +63,194 @@ namespace cppu
 				T slots[size()];
 			};
 
-			std::atomic<S> freeSlots;
-			std::atomic<S> initSlots;
-			std::atomic<S> garbage;
-
-			inline static size_t first_free(const S& freeSlots)
+			// Reference counters live next to the slots (same index), no allocation per object
+			union
 			{
-				return bs_rtol(freeSlots); // bit scan
-			}
+				details::base_counter counters[size()];
+			};
+
+			// only kept when the element type uses handles, see cgc::uses_handles
+			std::conditional_t<uses_handles_v<T>, details::slot_generations<size(), policy::atomic>, details::no_generations> generations;
+
+			details::slot_mask<S, policy::atomic> freeSlots;
+			details::slot_mask<S, policy::atomic> initSlots;
+			// EPOCH keeps one mask per epoch bucket
+			std::conditional_t<clean_proc == CLEAN_PROC::EPOCH, details::retire_masks<S>, details::slot_mask<S, policy::atomic>> garbage;
+
+			// set by m_array, gets notified when this block goes from full to having a free slot
+			details::free_bitmap* freeBitmap;
+			size_t blockIndex;
+
+			// emplace / release totals, see CPPU_CGC_STATS
+			details::stat_counters<policy::atomic> counts;
 
 			inline size_t reserve_spot()
 			{
 				// Find first available spot, in a thread safe & lock free approach
-				S freeSlotsCheck = freeSlots.load();
-				S freeSlotsCopy = freeSlotsCheck;
-				size_t freeSpot;
+				return freeSlots.reserve();
+			}
 
-				while ((freeSpot = first_free(freeSlotsCheck)) < npos)
-				{
-					S newValue = freeSlotsCheck & ~(1 << freeSpot);
-					if (!freeSlots.compare_exchange_weak(freeSlotsCheck, newValue))
-					{
-						// CAS weak can fail on non x86 chipsets, 
-						// memory can be set with the new value anyhow (success), so check the value
-						if (freeSlotsCheck != freeSlotsCopy)
-						{
-							freeSlotsCopy = freeSlotsCheck;
-							continue;
-						}
-					}
+			typedef details::column_store<T, details::slot_mask<S>::digits> COLUMNS;
 
-					return freeSpot;
-				}
+			// plain objects are constructed in the slot, soa<T> objects in the columns
+			template<class... _Args>
+			inline void construct_object_at(size_t slot, _Args&&... arguments)
+			{
+				COLUMNS::construct(slots + slot, slot, std::forward<_Args>(arguments)...);
+			}
 
-				return npos;
+			inline void destroy_object_at(size_t slot)
+			{
+				COLUMNS::destroy(slots + slot, slot);
 			}
 
 			template<class... _Args>
-			inline strong_ptr<T> emplace_at(size_t slot, _Args&&... arguments)
+			inline strong_ptr<T, policy::atomic> emplace_at(size_t slot, _Args&&... arguments)
 			{
 				assert(slot < npos);
+				assert(owned_by_current_thread());
 
 				// Construct object
 				T* object = slots + slot;
-				constructor::construct_object<T>(object, std::forward<_Args>(arguments)...);
-				
-				// note the
-				S oldValue, newValue;
-				do
+				construct_object_at(slot, std::forward<_Args>(arguments)...);
+
+				// the counter goes first, for_each() pins any slot it finds initialized
+				details::base_counter* counter = counters + slot;
+				counter->reset();
+
+				// note the slot as initialized
+				initSlots.set(slot);
+				counts.add_emplaced(1);
+
+				return constructor::construct_pointer<T, policy::atomic>(object, counter);
+			}
+
+			// claims up to count free slots with one CAS per mask word, construct(array, slot) builds the objects, returns the amount added
+			template<class _Construct>
+			size_t emplace_runs(batch& result, size_t count, _Construct&& construct)
+			{
+				assert(owned_by_current_thread());
+
+				const size_t added = freeSlots.reserve_many(count, [&](size_t word, uint64 bits)
 				{
-					oldValue = initSlots;
-					newValue = oldValue | (1 << slot);
-				} while (!initSlots.compare_exchange_weak(oldValue, newValue));
+					for (uint64 b = bits; b != 0; b &= b - 1)
+					{
+						const size_t slot = word * 64 + bsf(b);
+						construct(*this, slot);
+
+						// 2: the base count plus the reference the batch holds
+						counters[slot].reset(2);
+					}
 
-				return constructor::construct_pointer(object, new details::container_counter(this, details::destructor::create_destructor<T>()));
+					initSlots.set_word(word, bits);
+					result.add(this, word, bits);
+				});
+
+				counts.add_emplaced(added);
+				return added;
 			}
 
-			inline void clean_and_destruct_slot(size_t offset)
+			// drops the batch reference of every slot in bits, masks are updated once for all objects that became garbage
+			void release_run(size_t word, uint64 bits)
 			{
-				S oldValue, newValue;
-				T& item = slots[offset];
-				item.~T();
+				uint64 dead = 0;
+				for (uint64 b = bits; b != 0; b &= b - 1)
+				{
+					if (counters[word * 64 + bsf(b)].template sub_strong<policy::atomic>() == 2)
+						dead |= b & (~b + 1);
+				}
 
-				// reset slot value as uninitialized
-				do
+				if (dead == 0)
+					return;
+
+				for (uint64 b = dead; b != 0; b &= b - 1)
+					end_generation(word * 64 + bsf(b));
+
+				counts.add_released(std::bitset<64>(dead).count());
+
+				uint64 freed = 0;
+				if constexpr (clean_proc == CLEAN_PROC::DIRECT)
+				{
+					for (uint64 b = dead; b != 0; b &= b - 1)
+						destroy_object_at(word * 64 + bsf(b));
+
+					initSlots.reset_word(word, dead);
+
+					for (uint64 b = dead; b != 0; b &= b - 1)
+					{
+						if (counters[word * 64 + bsf(b)].template sub_strong_and_weak<policy::atomic>())
+							freed |= b & (~b + 1);
+					}
+				}
+				else
 				{
-					oldValue = initSlots;
-					newValue = oldValue & ~(1 << offset);
-				} while (!initSlots.compare_exchange_weak(oldValue, newValue));
+					// the weak reference the strong ones held stays as the garbage hold (add_as_garbage() adds one instead),
+					// so the counts have to be final before a cleaner can see the slots
+					for (uint64 b = dead; b != 0; b &= b - 1)
+						counters[word * 64 + bsf(b)].template sub_strong<policy::atomic>();
+
+					if constexpr (clean_proc == CLEAN_PROC::EPOCH)
+					{
+						epoch_guard guard;
+						initSlots.reset_word(word, dead);
+						garbage.retire_word(guard.epoch(), word, dead);
+					}
+					else
+					{
+						garbage.set_word(word, dead);
+
+						if constexpr (clean_proc == CLEAN_PROC::THREAD)
+							details::garbage_cleaner::add_to_clean(this);
+					}
+				}
+
+				if (freed != 0 && freeSlots.set_word(word, freed) && freeBitmap)
+					freeBitmap->set(blockIndex);
+			}
 
-				// reset slot value as free
-				do
+			// handles of the object in this slot go stale, before the object is destructed
+			inline void end_generation(size_t slot)
+			{
+				generations.end(slot);
+			}
+
+			inline strong_ptr<T, policy::atomic> share(size_t slot)
+			{
+				return constructor::construct_pointer<T, policy::atomic>(slots + slot, counters + slot);
+			}
+
+			// drops a reference taken by try_add_strong(), same as a strong_ptr letting go
+			inline void release_pin(size_t slot)
+			{
+				if (counters[slot].template sub_strong<policy::atomic>() == 2)
 				{
-					oldValue = freeSlots;
-					newValue = oldValue ^ (1 << offset);
-				} while (!freeSlots.compare_exchange_weak(oldValue, newValue));
+					add_as_garbage(slots + slot, counters + slot);
+					if (counters[slot].template sub_strong_and_weak<policy::atomic>())
+						release(counters + slot);
+				}
+			}
+
+			inline void destruct_slot(size_t offset)
+			{
+				destroy_object_at(offset);
+
+				// reset slot value as uninitialized
+				initSlots.reset(offset);
+			}
+
+			// the slot can only be reused once no weak pointer refers to its counter anymore
+			inline void free_slot(size_t offset)
+			{
+				// reset slot value as free, a full block becomes available again
+				if (freeSlots.set(offset) && freeBitmap)
+					freeBitmap->set(blockIndex);
 			}
 
 		public:
 			struct iterator
 			{
-				template<class, class, CLEAN_PROC> friend class cgc::array;
-				friend struct cgc::m_array<T, S, clean_proc>::iterator;
+				template<class, class, CLEAN_PROC, class> friend class cgc::array;
+				friend struct cgc::m_array<T, S, clean_proc, policy>::iterator;
 
 				using iterator_category = std::random_access_iterator_tag;
 				using difference_type = std::ptrdiff_t;
@@ -131,10 +259,10 @@ namespace cppu
 				using reference = T&;
 
 			private:
-				S offset;
-				cgc::array<T, S, clean_proc>* arr;
+				size_t offset;
+				cgc::array<T, S, clean_proc, policy>* arr;
 
-				iterator(cgc::array<T, S, clean_proc>* arr, S offset)
+				iterator(cgc::array<T, S, clean_proc, policy>* arr, size_t offset)
 					: arr(arr)
 					, offset(offset)
 				{ }
@@ -164,7 +292,7 @@ namespace cppu
 
 				iterator operator++(int)
 				{
-					S offs = this->offset;
+					size_t offs = this->offset;
 					this->offset = arr->next_index(this->offset + 1);
 					return iterator(arr, offs);
 				}
@@ -182,14 +310,14 @@ namespace cppu
 
 				iterator& operator--()
 				{
-					this->offset = arr->next_index(this->offset - 1);
+					this->offset = arr->prev_index(this->offset - 1);
 					return *this;
 				}
 
 				iterator operator--(int)
 				{
-					S offs = offset;
-					this->offset = arr->next_index(this->offset - 1);
+					size_t offs = offset;
+					this->offset = arr->prev_index(this->offset - 1);
 					return iterator(arr, offs);
 				}
 
@@ -215,26 +343,46 @@ namespace cppu
 			};
 
 			array()
-				: freeSlots(~0)
-				, initSlots(0)
-				, garbage(0)
-			{ }
+				: freeSlots(true)
+				, initSlots(false)
+				, garbage(false)
+				, freeBitmap(nullptr)
+				, blockIndex(0)
+			{
+				// counters are constructed once and reset per object, for_each() may still look at the counter of a released slot
+				for (size_t i = 0; i < size(); ++i)
+					new (counters + i) details::base_counter(this);
+
+#ifndef NDEBUG
+				if constexpr (!policy::atomic)
+					owner = std::this_thread::get_id();
+#endif
+			}
 
 			// This one shouldn't be called unless all of the members are not being used anymore anywhere.
 			~array()
 			{
-				S takenSpots = ~freeSlots;
-				for (S i = bs_rtol(takenSpots); i < npos; i = bs_rtol(takenSpots, ++i))
-					slots[i].~T();
+				for (size_t i = initSlots.front(); i < npos; i = initSlots.next(i + 1))
+					destroy_object_at(i);
+
+				// retired objects aren't listed as initialized anymore
+				if constexpr (clean_proc == CLEAN_PROC::EPOCH)
+				{
+					for (size_t b = 0; b < details::epoch::buckets; ++b)
+					{
+						for (size_t i = garbage[b].front(); i < npos; i = garbage[b].next(i + 1))
+							destroy_object_at(i);
+					}
+				}
 			}
 
 			template<class... _Args>
-			strong_ptr<T> emplace(_Args&&... arguments)
+			strong_ptr<T, policy::atomic> emplace(_Args&&... arguments)
 			{
-				strong_ptr<T> pointer;
+				strong_ptr<T, policy::atomic> pointer;
 
 				// Find first available spot, in a thread safe & lock free approach
-				S freeSpot = reserve_spot();
+				size_t freeSpot = reserve_spot();
 				if (freeSpot < npos)
 					pointer = emplace_at(freeSpot, std::forward<_Args>(arguments)...);
 
@@ -242,46 +390,115 @@ namespace cppu
 				return pointer;
 			}
 
+			// count objects constructed from the same arguments, fewer if the array runs out of free slots
+			template<class... _Args>
+			batch emplace_n(size_t count, const _Args&... arguments)
+			{
+				batch result;
+				emplace_runs(result, count, [&](array& arr, size_t slot) { arr.construct_object_at(slot, arguments...); });
+				return result;
+			}
+
+			// an object per element, constructed from *it, stops early if the array runs out of free slots
+			template<class _It>
+			batch emplace_range(_It first, _It last)
+			{
+				batch result;
+				emplace_runs(result, size_t(std::distance(first, last)), [&first](array& arr, size_t slot) { arr.construct_object_at(slot, *first++); });
+				return result;
+			}
+
+			// same as letting go of every object's strong_ptr, batch is empty afterwards
+			inline void release_all(batch& objects)
+			{
+				objects.release();
+			}
+
 			bool add_as_garbage(void* ptr, const details::base_counter* c) override
 			{
+				size_t offset = c - counters;
+				end_generation(offset);
+				counts.add_released(1);
+
 				if constexpr (clean_proc == CLEAN_PROC::DIRECT)
-					clean_and_destruct_slot((reinterpret_cast<uintptr_t>(ptr) - reinterpret_cast<uintptr_t>(slots)) / sizeof(T));
+					destruct_slot(offset);
+				else if constexpr (clean_proc == CLEAN_PROC::EPOCH)
+				{
+					// retired into the bucket of the epoch this thread is pinned at, see details::epoch::grace
+					epoch_guard guard;
+
+					counters[offset].template add_weak<policy::atomic>();
+
+					// unlink first: readers that still find it are pinned one epoch past this guard at most
+					initSlots.reset(offset);
+					garbage.retire(guard.epoch(), offset);
+				}
 				else
 				{
-					size_t offset = (reinterpret_cast<uintptr_t>(ptr) - reinterpret_cast<uintptr_t>(slots)) / sizeof(T);
-					S oldValue, newValue;
-					do
-					{
-						oldValue = garbage;
-						newValue = oldValue | (1 << offset);
-					} while (!garbage.compare_exchange_weak(oldValue, newValue));
+					// hold on to the slot until the object is cleaned up
+					counters[offset].template add_weak<policy::atomic>();
+					garbage.set(offset);
 
+					// coalesced by the cleaner, only the first call while dirty lists this container
 					if constexpr (clean_proc == CLEAN_PROC::THREAD)
-					{
-						if (oldValue == 0)
-							details::garbage_cleaner::add_to_clean(this);
-					}
+						details::garbage_cleaner::add_to_clean(this);
 				}
 
 				return true;
 			}
 
+			void release(const details::base_counter* c) override
+			{
+				free_slot(c - counters);
+			}
+
 			size_t clean_garbage(size_t max = std::numeric_limits<size_t>::max()) override
 			{
-				if constexpr (clean_proc == CLEAN_PROC::MANUAL)
+				assert(owned_by_current_thread());
+				details::trace_scope trace("cgc::clean_garbage", this);
+
+				if constexpr (clean_proc == CLEAN_PROC::EPOCH)
 				{
+					// every pass reclaims one bucket and moves the epoch forward (if no reader holds it back),
+					// without readers the objects retired before this call are all gone afterwards
 					size_t i = 0;
-					for (size_t offset = bs_rtol(garbage); offset < npos; offset = bs_rtol(garbage, offset))
+					for (size_t pass = 0; pass < details::epoch::buckets && i < max; ++pass)
 					{
-						clean_and_destruct_slot(offset);
-
-						S oldValue, newValue;
-						// set garbage slot value as free
-						do
 						{
-							oldValue = garbage;
-							newValue = oldValue & ~(1 << offset);
-						} while (!garbage.compare_exchange_weak(oldValue, newValue));
+							epoch_guard guard;
+							details::slot_mask<S>& bucket = garbage.reclaimable(guard.epoch());
+							for (size_t offset = bucket.front(); offset < npos && i < max; offset = bucket.next(offset))
+							{
+								if (!bucket.reset(offset))
+									continue;
+
+								destruct_slot(offset);
+
+								if (counters[offset].template sub_weak<policy::atomic>())
+									free_slot(offset);
+
+								++i;
+							}
+						}
+
+						details::epoch::try_advance();
+					}
+
+					return i;
+				}
+				else if constexpr (clean_proc != CLEAN_PROC::DIRECT)
+				{
+					size_t i = 0;
+					for (size_t offset = garbage.front(); offset < npos && i < max; offset = garbage.next(offset))
+					{
+						// claim the slot, another cleaner may be visiting this array as well
+						if (!garbage.reset(offset))
+							continue;
+
+						destruct_slot(offset);
+
+						if (counters[offset].template sub_weak<policy::atomic>())
+							free_slot(offset);
 
 						++i;
 					}
@@ -307,47 +524,47 @@ namespace cppu
 
 			inline T& front()
 			{
-				return slots[bs_rtol(initSlots.load())];
+				return slots[initSlots.front()];
 			}
 
 			inline T& back()
 			{
-				return slots[bs_ltor(initSlots.load())];
+				return slots[initSlots.back()];
 			}
 
-			inline T& next(S pos)
+			inline T& next(size_t pos)
 			{
 				return slots[next_index(pos)];
 			}
 
-			inline T& prev(S pos)
+			inline T& prev(size_t pos)
 			{
 				return slots[prev_index(pos)];
 			}
 
-			inline S front_index()
+			inline size_t front_index()
 			{
-				return bs_rtol(initSlots.load());
+				return initSlots.front();
 			}
 
-			inline S back_index()
+			inline size_t back_index()
 			{
-				return bs_ltor(initSlots.load());
+				return initSlots.back();
 			}
 
-			inline S next_index(S pos)
+			inline size_t next_index(size_t pos)
 			{
-				return bs_rtol(initSlots.load(), pos);
+				return initSlots.next(pos);
 			}
 
-			inline S prev_index(S pos)
+			inline size_t prev_index(size_t pos)
 			{
-				return bs_ltor(initSlots.load(), pos);
+				return initSlots.prev(pos);
 			}
 
 			iterator begin()
 			{
-				return iterator(this, bs_rtol(initSlots));
+				return iterator(this, initSlots.front());
 			}
 
 			iterator end()
@@ -355,10 +572,99 @@ namespace cppu
 				return iterator(this, npos);
 			}
 
+			// fn(chunk&) once, unless the array is empty
+			template<class _Func>
+			void for_each_chunk(_Func&& fn)
+			{
+				chunk c(slots, COLUMNS::columns());
+				bool any = false;
+				for (size_t w = 0; w < chunk::word_count; ++w)
+				{
+					c.occupancy[w] = initSlots.load_word(w);
+					any |= c.occupancy[w] != 0;
+				}
+
+				if (any)
+					fn(c);
+			}
+
+			// fn(T&) for every object, safe while other threads release objects: EPOCH reads within an epoch,
+			// other modes hold a strong reference during the call and skip objects that are already on their way out
+			template<class _Func>
+			void for_each(_Func&& fn)
+			{
+				if constexpr (clean_proc == CLEAN_PROC::EPOCH)
+				{
+					epoch_guard guard;
+					for (size_t i = initSlots.front(); i < npos; i = initSlots.next(i + 1))
+						fn(slots[i]);
+				}
+				else
+				{
+					for (size_t i = initSlots.front(); i < npos; i = initSlots.next(i + 1))
+					{
+						if (!counters[i].try_add_strong())
+							continue;
+
+						fn(slots[i]);
+						release_pin(i);
+					}
+				}
+			}
+
+			inline bool empty() const
+			{
+				return initSlots.empty();
+			}
+
+			handle<T> handle_of(const strong_ptr<T, policy::atomic>& object) const
+			{
+				static_assert(uses_handles_v<T>, "handles need cgc::uses_handles<T> set for the element type");
+
+				const details::base_counter* counter = constructor::counter_of(object);
+				if (counter == nullptr)
+					return {};
+
+				const size_t slot = counter - counters;
+				return handle<T>(blockIndex, slot, generations.load(slot, std::memory_order_relaxed));
+			}
+
+			// the object, or nullptr if it died. Doesn't keep it alive: only use it while another reference
+			// (or an epoch_guard) keeps it around, or when no other thread releases objects of this array
+			inline T* get(handle<T> h)
+			{
+				static_assert(uses_handles_v<T>, "handles need cgc::uses_handles<T> set for the element type");
+
+				const size_t slot = h.slot();
+				return slot < size() && generations.load(slot, std::memory_order_acquire) == h.generation() ? slots + slot : nullptr;
+			}
+
+			// a strong_ptr to the object, empty if it died
+			strong_ptr<T, policy::atomic> share(handle<T> h)
+			{
+				static_assert(uses_handles_v<T>, "handles need cgc::uses_handles<T> set for the element type");
+
+				const size_t slot = h.slot();
+				if (slot >= size() || generations.load(slot) != h.generation() || !counters[slot].try_add_strong())
+					return {};
+
+				// the slot may have been reused before the pin
+				strong_ptr<T, policy::atomic> pointer;
+				if (generations.load(slot) == h.generation())
+					pointer = constructor::construct_pointer<T, policy::atomic>(slots + slot, counters + slot);
+
+				release_pin(slot);
+				return pointer;
+			}
+
+			inline bool has_free() const
+			{
+				return !freeSlots.empty();
+			}
+
 			bool exists(T& object)
 			{
-				S takenSpots = ~freeSlots;
-				for (size_t i = bs_rtol(takenSpots); i < npos; i = bs_rtol(takenSpots, i))
+				for (size_t i = initSlots.front(); i < npos; i = initSlots.next(i + 1))
 				{
 					if (slots[i] == object)
 						return true;
@@ -369,19 +675,16 @@ namespace cppu
 			
 			bool exists(T* object)
 			{
-				// to be implemented
+				uintptr_t offset = reinterpret_cast<uintptr_t>(object) - reinterpret_cast<uintptr_t>(slots);
+				return offset < sizeof(T) * size() && initSlots.test(offset / sizeof(T));
 			}
 
 			size_t indexof(T& object)
 			{
-				S takenSpots = ~freeSlots;
-				for (size_t i = bs_rtol(freeSlots); i < npos; i = bs_rtol(freeSlots, i))
+				for (size_t i = initSlots.front(); i < npos; i = initSlots.next(i + 1))
 				{
-					for (size_t s = i; s < i; ++s)
-					{
-						if (slots[s] == object)
-							return s;
-					}
+					if (slots[i] == object)
+						return i;
 				}
 
 				return npos;
@@ -389,20 +692,41 @@ namespace cppu
 
 			size_t indexof(T* object)
 			{
-				size_t index = (static_cast<uintptr_t>(object) - static_cast<uintptr_t>(slots)) / sizeof(T);
+				size_t index = (reinterpret_cast<uintptr_t>(object) - reinterpret_cast<uintptr_t>(slots)) / sizeof(T);
 				assert(index >= 0 && index < npos);
 				return index;
 			}
 
 			inline size_t garbage_size()
 			{
-				return garbage.size();
+				return garbage.count();
 			}
 
 			inline bool garbage_empty()
 			{
 				return garbage.empty();
 			}
+
+			// live and free slots, objects waiting for a clean up, emplace / release totals (CPPU_CGC_STATS)
+			container_stats stats() const
+			{
+				container_stats s;
+				fill_stats(s);
+				s.blocks = 1;
+				s.time = details::stats_now();
+				return s;
+			}
+
+		private:
+			// adds this block's numbers, m_array sums its blocks with it
+			void fill_stats(container_stats& s) const
+			{
+				s.live += initSlots.count();
+				s.free += freeSlots.count();
+				s.garbage += garbage.count();
+
+				counts.fill(s);
+			}
 		};
 	}
 }
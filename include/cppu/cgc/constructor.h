@@ -3,20 +3,18 @@
 #include <type_traits>
 #include "details/types.h"
 #include "details/base_counter.h"
-#include "details/destructors.h"
+#include "details/heap_container.h"
 
 namespace cppu
 {
 	namespace cgc
 	{
-		template<typename> class strong_ptr;
-		template<typename> class weak_ptr;
-
-		template<typename, typename, CLEAN_PROC> class array;
+		template<typename, typename, CLEAN_PROC, typename> class array;
+		template<typename, typename, CLEAN_PROC, typename> class m_array;
 		template<typename, typename, bool> class deque;
 		template<typename, typename, bool> class queue;
 		template<typename, typename, bool> class map;
-		template<typename, typename, CLEAN_PROC> class unordered_map;
+		template<typename, typename, CLEAN_PROC, typename> class unordered_map;
 
 		namespace ref
 		{
@@ -24,33 +22,36 @@ namespace cppu
 			template<typename, typename, bool> class deque;
 			template<typename, typename, bool> class queue;
 			template<typename, typename, bool> class map;
-			template<typename, typename, CLEAN_PROC> class unordered_map;
+			template<typename, typename, CLEAN_PROC, typename> class unordered_map;
 		}
 
 		namespace details
 		{
 			template<typename> struct counter_value_pair;
-			template<typename, typename> class base_unordered_map;
+			template<typename, size_t> struct column_store;
+			template<typename, typename, typename> class base_unordered_map;
 			struct base_counter;
 		}
 
 		class constructor
 		{
 			// friends
-			template<typename, typename, CLEAN_PROC> friend class array;
+			template<typename, typename, CLEAN_PROC, typename> friend class array;
+			template<typename, typename, CLEAN_PROC, typename> friend class m_array;
 			template<typename, typename, bool> friend class deque;
 			template<typename, typename, bool> friend class queue;
 			template<typename, typename, bool> friend class map;
-			template<typename, typename, CLEAN_PROC> friend class unordered_map;
+			template<typename, typename, CLEAN_PROC, typename> friend class unordered_map;
 
 			template<typename, typename, CLEAN_PROC> friend class ref::array;
 			template<typename, typename, bool> friend class ref::deque;
 			template<typename, typename, bool> friend class ref::queue;
 			template<typename, typename, bool> friend class ref::map;
-			template<typename, typename, CLEAN_PROC> friend class ref::unordered_map;
+			template<typename, typename, CLEAN_PROC, typename> friend class ref::unordered_map;
 
-			template<typename, typename> friend class details::base_unordered_map;
+			template<typename, typename, typename> friend class details::base_unordered_map;
 			template<typename> friend struct details::counter_value_pair;
+			template<typename, size_t> friend struct details::column_store;
 			template<typename T, typename... Args> friend strong_ptr<T> construct_new(Args&&...);
 			template<typename T, typename... Args> friend strong_ptr<T> gcnew(Args&& ...);
 
@@ -61,10 +62,23 @@ namespace cppu
 				new(pointer) T(std::forward<Args>(arguments)...);
 			}
 
-			template<class T>
-			inline static strong_ptr<T> construct_pointer(T* pointer, details::base_counter* count)
+			template<class T, bool _Atomic = true>
+			inline static strong_ptr<T, _Atomic> construct_pointer(T* pointer, details::base_counter* count)
+			{
+				return strong_ptr<T, _Atomic>(pointer, count);
+			}
+
+			// count already has the strong reference the pointer gets, nothing is added
+			template<class T, bool _Atomic = true>
+			inline static strong_ptr<T, _Atomic> adopt_pointer(T* pointer, details::base_counter* count)
+			{
+				return strong_ptr<T, _Atomic>(pointer, count, std::false_type());
+			}
+
+			template<class T, bool _Atomic>
+			inline static details::base_counter* counter_of(const strong_ptr<T, _Atomic>& pointer)
 			{
-				return strong_ptr<T>(pointer, count);
+				return pointer.refCounter;
 			}
 
 			template<class T, class... Args>
@@ -78,14 +92,14 @@ namespace cppu
 		inline strong_ptr<T> construct_new(Args&&... arguments)
 		{
 			T* object = new T(std::forward<Args>(arguments)...);
-			return constructor::construct_pointer(object, new details::base_counter(details::destructor::create_destructor<T>()));
+			return constructor::construct_pointer(object, new details::base_counter(&details::heap_container<T>::instance()));
 		}
 
 		template<class T, class... Args>
 		inline strong_ptr<T> gcnew(Args&&... arguments)
 		{
 			T* object = new T(std::forward<Args>(arguments)...);
-			return constructor::construct_pointer(object, new details::base_counter(details::destructor::create_destructor<T>()));
+			return constructor::construct_pointer(object, new details::base_counter(&details::heap_container<T>::instance()));
 		}
 	}
 }
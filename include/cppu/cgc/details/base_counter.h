@@ -1,43 +1,261 @@
 #pragma once
 
 #include <atomic>
+#include <cassert>
+#include <limits>
 #include "icontainer.h"
-#include "destructors.h"
+#include "../../dtypes.h"
+
+// Reference count width in bits: 16, 32 (default) or 64
+#ifndef CPPU_CGC_REFCOUNT_BITS
+#define CPPU_CGC_REFCOUNT_BITS 32
+#endif
+
+// Define CPPU_CGC_REFCOUNT_PACKED to keep strong and weak counts in one atomic word (16 or 32 bit counts only),
+// dropping the last strong reference and its weak reference is then a single atomic operation.
+// Define CPPU_CGC_REFCOUNT_PADDED to give every counter its own cache line (and the weak count another one when not packed),
+// for hot objects shared between cores, at the cost of a lot more memory per object.
 
 namespace cppu
 {
 	namespace cgc
 	{
-		template<class T>
-		class strong_ptr;
-
 		namespace details
 		{
-			typedef unsigned short RefCount;
+#if CPPU_CGC_REFCOUNT_BITS == 16
+			typedef uint16 RefCount;
+#elif CPPU_CGC_REFCOUNT_BITS == 32
+			typedef uint32 RefCount;
+#elif CPPU_CGC_REFCOUNT_BITS == 64
+			typedef uint64 RefCount;
+#else
+#error "CPPU_CGC_REFCOUNT_BITS should be 16, 32 or 64"
+#endif
 
-			struct base_counter
+#ifdef CPPU_CGC_REFCOUNT_PADDED
+#define CPPU_CGC_COUNTER_ALIGN alignas(64)
+#else
+#define CPPU_CGC_COUNTER_ALIGN
+#endif
+
+			// Read-modify-write operations on reference counts, the non atomic version does a plain load and store (thread_policy::local)
+			template<bool _Atomic>
+			struct count_ops
 			{
-				template<typename> friend class ::cppu::cgc::strong_ptr;
-			protected:
+				template<class T>
+				static inline T add(std::atomic<T>& a, T value) { return a.fetch_add(value); }
+
+				template<class T>
+				static inline T sub(std::atomic<T>& a, T value) { return a.fetch_sub(value); }
+			};
 
-				// by default
-				virtual void add_as_garbage(void* ptr) const
+			template<>
+			struct count_ops<false>
+			{
+				template<class T>
+				static inline T add(std::atomic<T>& a, T value)
 				{
-					destruct(ptr);
-					free(ptr);
+					T old = a.load(std::memory_order_relaxed);
+					a.store(T(old + value), std::memory_order_relaxed);
+					return old;
 				}
 
-			public:
+				template<class T>
+				static inline T sub(std::atomic<T>& a, T value)
+				{
+					T old = a.load(std::memory_order_relaxed);
+					a.store(T(old - value), std::memory_order_relaxed);
+					return old;
+				}
+			};
+
+			// Plain (non virtual) counter, the container it points to knows the real types and decides what happens on release.
+			// All strong references together hold 1 weak reference, so the counter is released exactly once: when weak hits 0.
+			// The count operations take the thread policy's atomic flag, pointers and containers know it at compile time.
+			struct CPPU_CGC_COUNTER_ALIGN base_counter
+			{
+			private:
+				icontainer* container;
+
+#ifdef CPPU_CGC_REFCOUNT_PACKED
+				static_assert(CPPU_CGC_REFCOUNT_BITS <= 32, "packed reference counts need 2 counts in one 64 bit word");
+
+				// strong count in the lower half, weak count in the upper half
+				typedef std::conditional_t<CPPU_CGC_REFCOUNT_BITS == 16, uint32, uint64> word;
+				static constexpr word strong_one = 1;
+				static constexpr word weak_one = word(1) << CPPU_CGC_REFCOUNT_BITS;
+
+				std::atomic<word> references;
+#else
 				std::atomic<RefCount> strongReferences;
-				std::atomic<RefCount> weakReferences;
-				destructor destruct;
+				CPPU_CGC_COUNTER_ALIGN std::atomic<RefCount> weakReferences;
+#endif
 
-				base_counter(destructor&& destructor)
-					: strongReferences(1)
-					, weakReferences(0)
-					, destruct(std::move(destructor))
+				// thread local counters use a plain load and store instead of an atomic read-modify-write
+				template<bool _Atomic, class T>
+				inline T add(std::atomic<T>& a, T value)
+				{
+					if constexpr (!_Atomic)
+						assert(container->owned_by_current_thread() && "thread_policy::local pointer used on another thread");
+
+					return count_ops<_Atomic>::add(a, value);
+				}
+
+				template<bool _Atomic, class T>
+				inline T sub(std::atomic<T>& a, T value)
+				{
+					if constexpr (!_Atomic)
+						assert(container->owned_by_current_thread() && "thread_policy::local pointer used on another thread");
+
+					return count_ops<_Atomic>::sub(a, value);
+				}
+
+			public:
+				// strong > 1 hands out references right away (batches), without atomic increments afterwards
+				base_counter(icontainer* container, RefCount strong = 1)
+					: container(container)
+#ifdef CPPU_CGC_REFCOUNT_PACKED
+					, references(strong * strong_one | weak_one)
+#else
+					, strongReferences(strong)
+					, weakReferences(1)
+#endif
 				{ }
+
+				// brings a released counter (no references left) back for a new object, with atomic stores so a concurrent
+				// try_add_strong() on the old object sees a valid count
+				inline void reset(RefCount strong = 1)
+				{
+#ifdef CPPU_CGC_REFCOUNT_PACKED
+					references.store(strong * strong_one | weak_one);
+#else
+					weakReferences.store(1);
+					strongReferences.store(strong);
+#endif
+				}
+
+				inline icontainer* get_container() const
+				{
+					return container;
+				}
+
+#ifdef CPPU_CGC_REFCOUNT_PACKED
+				template<bool _Atomic = true>
+				inline void add_strong()
+				{
+					[[maybe_unused]] word old = add<_Atomic>(references, strong_one);
+					assert(RefCount(old) != std::numeric_limits<RefCount>::max() && "strong reference count overflow");
+				}
+
+				// returns the strong count before decrementing
+				template<bool _Atomic = true>
+				inline RefCount sub_strong()
+				{
+					return RefCount(sub<_Atomic>(references, strong_one));
+				}
+
+				template<bool _Atomic = true>
+				inline void add_weak()
+				{
+					[[maybe_unused]] word old = add<_Atomic>(references, weak_one);
+					assert(RefCount(old >> CPPU_CGC_REFCOUNT_BITS) != std::numeric_limits<RefCount>::max() && "weak reference count overflow");
+				}
+
+				// returns true if this was the last weak reference
+				template<bool _Atomic = true>
+				inline bool sub_weak()
+				{
+					return (sub<_Atomic>(references, weak_one) >> CPPU_CGC_REFCOUNT_BITS) == 1;
+				}
+
+				// drops the final strong reference together with the weak reference all strong references held
+				template<bool _Atomic = true>
+				inline bool sub_strong_and_weak()
+				{
+					return (sub<_Atomic>(references, strong_one | weak_one) >> CPPU_CGC_REFCOUNT_BITS) == 1;
+				}
+
+				// adds a strong reference unless only the base count is left (the object is on its way out), for lookups by key
+				inline bool try_add_strong()
+				{
+					word old = references.load();
+					do
+					{
+						if (RefCount(old) < 2)
+							return false;
+					} while (!references.compare_exchange_weak(old, old + strong_one));
+
+					return true;
+				}
+
+				inline RefCount strong_count() const
+				{
+					return RefCount(references.load());
+				}
+
+				inline RefCount weak_count() const
+				{
+					return RefCount(references.load() >> CPPU_CGC_REFCOUNT_BITS);
+				}
+#else
+				template<bool _Atomic = true>
+				inline void add_strong()
+				{
+					[[maybe_unused]] RefCount old = add<_Atomic>(strongReferences, RefCount(1));
+					assert(old != std::numeric_limits<RefCount>::max() && "strong reference count overflow");
+				}
+
+				template<bool _Atomic = true>
+				inline RefCount sub_strong()
+				{
+					return sub<_Atomic>(strongReferences, RefCount(1));
+				}
+
+				template<bool _Atomic = true>
+				inline void add_weak()
+				{
+					[[maybe_unused]] RefCount old = add<_Atomic>(weakReferences, RefCount(1));
+					assert(old != std::numeric_limits<RefCount>::max() && "weak reference count overflow");
+				}
+
+				template<bool _Atomic = true>
+				inline bool sub_weak()
+				{
+					return sub<_Atomic>(weakReferences, RefCount(1)) == 1;
+				}
+
+				template<bool _Atomic = true>
+				inline bool sub_strong_and_weak()
+				{
+					sub<_Atomic>(strongReferences, RefCount(1));
+					return sub<_Atomic>(weakReferences, RefCount(1)) == 1;
+				}
+
+				inline bool try_add_strong()
+				{
+					RefCount old = strongReferences.load();
+					do
+					{
+						if (old < 2)
+							return false;
+					} while (!strongReferences.compare_exchange_weak(old, RefCount(old + 1)));
+
+					return true;
+				}
+
+				inline RefCount strong_count() const
+				{
+					return strongReferences.load();
+				}
+
+				inline RefCount weak_count() const
+				{
+					return weakReferences.load();
+				}
+#endif
 			};
+
+#undef CPPU_CGC_COUNTER_ALIGN
 		}
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <limits>
+
+#include "../../bitops.h"
+
+namespace cppu
+{
+	namespace cgc
+	{
+		namespace details
+		{
+			// Never reallocating list of block pointers, segment 0 and 1 hold 64 entries and every next segment doubles in size.
+			// Segments and entries are published before the size is increased, so readers only need size() to index safely.
+			// Adding blocks has to be serialized by the caller, reading and iterating can happen concurrently without locks.
+			template<class B, size_t _Capacity>
+			class block_directory
+			{
+			private:
+				static constexpr size_t first_size = 64;
+				static constexpr size_t segment_count = [] {
+					size_t count = 1, total = first_size;
+					while (total < _Capacity)
+					{
+						total <<= 1;
+						++count;
+					}
+					return count;
+				}();
+
+				std::atomic<B**> segments[segment_count];
+				std::atomic<size_t> count;
+
+				// segment k > 0 starts at first_size << (k - 1) and holds that same amount of entries
+				inline static size_t segment_of(size_t index)
+				{
+					return index < first_size ? 0 : size_t(64 - bs_ltor(uint64(index / first_size)));
+				}
+
+				inline static size_t segment_start(size_t segment)
+				{
+					return segment == 0 ? 0 : first_size << (segment - 1);
+				}
+
+				inline static size_t segment_size(size_t segment)
+				{
+					return segment == 0 ? first_size : first_size << (segment - 1);
+				}
+
+			public:
+				block_directory()
+					: count(0)
+				{
+					for (size_t i = 0; i < segment_count; ++i)
+						segments[i].store(nullptr, std::memory_order_relaxed);
+				}
+
+				// only releases the segments, the blocks are owned by the user of the directory
+				~block_directory()
+				{
+					for (size_t i = 0; i < segment_count; ++i)
+						delete[] segments[i].load();
+				}
+
+				block_directory(const block_directory&) = delete;
+				block_directory& operator=(const block_directory&) = delete;
+
+				static constexpr size_t capacity() { return _Capacity; }
+
+				inline size_t size() const
+				{
+					return count.load(std::memory_order_acquire);
+				}
+
+				inline bool empty() const
+				{
+					return size() == 0;
+				}
+
+				inline B* operator[](size_t index) const
+				{
+					const size_t segment = segment_of(index);
+					return segments[segment].load(std::memory_order_acquire)[index - segment_start(segment)];
+				}
+
+				inline B* front() const
+				{
+					return operator[](0);
+				}
+
+				inline B* back() const
+				{
+					return operator[](size() - 1);
+				}
+
+				// serialized by the caller, returns the index of the added block
+				size_t push_back(B* block)
+				{
+					const size_t index = count.load(std::memory_order_relaxed);
+					const size_t segment = segment_of(index);
+
+					B** entries = segments[segment].load(std::memory_order_relaxed);
+					if (entries == nullptr)
+					{
+						entries = new B*[segment_size(segment)];
+						segments[segment].store(entries, std::memory_order_release);
+					}
+
+					entries[index - segment_start(segment)] = block;
+					count.store(index + 1, std::memory_order_release);
+
+					return index;
+				}
+			};
+		}
+	}
+}
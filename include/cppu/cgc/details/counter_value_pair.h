@@ -13,8 +13,8 @@ namespace cppu
 			template<class V>
 			struct counter_value_pair
 			{
-				friend class constructor;
-				template<class K, class V, CLEAN_PROC> friend class cppu::cgc::ref::unordered_map;
+				friend class cgc::constructor;
+				template<class, class, CLEAN_PROC, class> friend class cppu::cgc::ref::unordered_map;
 			private:
 				byte value[sizeof(V)];
 				base_counter* counter;
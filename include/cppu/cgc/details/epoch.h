@@ -0,0 +1,149 @@
+#pragma once
+
+#include <atomic>
+#include <memory_resource>
+#include <vector>
+
+#include "slot_mask.h"
+#include "../../details/epoch.h"
+#include "../../dtypes.h"
+
+namespace cppu
+{
+	namespace cgc
+	{
+		namespace details
+		{
+			// the epoch lives outside of cgc, delegates and the unbounded queues retire into it as well
+			using ::cppu::details::epoch;
+
+			// Retired slots of an array, one mask per epoch bucket
+			template<class S>
+			class retire_masks
+			{
+			private:
+				slot_mask<S> masks[epoch::buckets];
+
+			public:
+				retire_masks(bool full)
+					: masks{ full, full, full, full, full }
+				{
+					static_assert(epoch::buckets == 5, "retire_masks initializes 5 buckets");
+				}
+
+				// expects the caller to be pinned at `pinned` and the slot unreachable for new readers
+				inline void retire(uint64 pinned, size_t pos)
+				{
+					masks[epoch::retire_bucket(pinned)].set(pos);
+				}
+
+				inline void retire_word(uint64 pinned, size_t word, uint64 bits)
+				{
+					masks[epoch::retire_bucket(pinned)].set_word(word, bits);
+				}
+
+				// slots that are safe to reclaim for a cleaner pinned at `pinned`
+				inline slot_mask<S>& reclaimable(uint64 pinned)
+				{
+					return masks[epoch::reclaim_bucket(pinned)];
+				}
+
+				inline slot_mask<S>& operator[](size_t bucket)
+				{
+					return masks[bucket];
+				}
+
+				inline size_t count() const
+				{
+					size_t total = 0;
+					for (const slot_mask<S>& m : masks)
+						total += m.count();
+
+					return total;
+				}
+
+				inline bool empty() const
+				{
+					for (const slot_mask<S>& m : masks)
+					{
+						if (!m.empty())
+							return false;
+					}
+
+					return true;
+				}
+			};
+
+			// Forwards to upstream, but a freed block is only given back once no guard pinned before the free can be left.
+			// For tables that readers probe without locking (sharded maps), so a table that grows doesn't free its old index
+			// under them. Not thread safe, the owner serializes the calls (the shard's exclusive lock)
+			class epoch_resource : public std::pmr::memory_resource
+			{
+			private:
+				struct block
+				{
+					uint64 epoch;
+					void* memory;
+					size_t bytes;
+					size_t alignment;
+				};
+
+				std::pmr::memory_resource* upstream;
+				std::vector<block> deferred; // (roughly) in epoch order
+
+			public:
+				explicit epoch_resource(std::pmr::memory_resource* upstream)
+					: upstream(upstream)
+				{ }
+
+				epoch_resource(const epoch_resource&) = delete;
+				epoch_resource& operator=(const epoch_resource&) = delete;
+
+				~epoch_resource()
+				{
+					for (block& b : deferred)
+						upstream->deallocate(b.memory, b.bytes, b.alignment);
+				}
+
+				// gives back the blocks nobody can reach anymore, stops at the first one that's too young
+				void reclaim()
+				{
+					epoch::try_advance();
+
+					const uint64 now = epoch::current();
+					size_t i = 0;
+					for (; i < deferred.size() && deferred[i].epoch + epoch::grace <= now; ++i)
+						upstream->deallocate(deferred[i].memory, deferred[i].bytes, deferred[i].alignment);
+
+					deferred.erase(deferred.begin(), deferred.begin() + i);
+				}
+
+			protected:
+				void* do_allocate(size_t bytes, size_t alignment) override
+				{
+					return upstream->allocate(bytes, alignment);
+				}
+
+				void do_deallocate(void* memory, size_t bytes, size_t alignment) override
+				{
+					{
+						::cppu::details::epoch_guard guard;
+						deferred.push_back({ guard.epoch(), memory, bytes, alignment });
+					}
+
+					reclaim();
+				}
+
+				bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+				{
+					return this == &other;
+				}
+			};
+		}
+
+		// Pins the current epoch, objects of EPOCH containers (arrays, sharded maps) that are reachable in the meantime won't be
+		// destructed until the guard is gone. Within a guard plain references (T&, raw_ptr) are enough, no strong_ptr needed.
+		// Guards are cheap and may be nested.
+		typedef ::cppu::details::epoch_guard epoch_guard;
+	}
+}
@@ -0,0 +1,583 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <limits>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CPPU_FLAT_TABLE_SSE2
+#endif
+
+#include "../../bitops.h"
+#include "memory_resource.h"
+
+namespace cppu
+{
+	namespace cgc
+	{
+		namespace details
+		{
+			// Control byte group of the flat table, one bit per matching byte
+#ifdef CPPU_FLAT_TABLE_SSE2
+			struct ctrl_group
+			{
+				static constexpr size_t width = 16;
+
+				__m128i ctrl;
+
+				explicit ctrl_group(const int8* pos)
+					: ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos)))
+				{ }
+
+				inline uint32 match(int8 h2) const
+				{
+					return uint32(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl)));
+				}
+
+				// empty or deleted, both have the high bit set
+				inline uint32 match_free() const
+				{
+					return uint32(_mm_movemask_epi8(ctrl));
+				}
+
+				inline uint32 match_empty() const
+				{
+					return match(int8(-128));
+				}
+			};
+#else
+			// portable fallback, 8 control bytes at a time
+			struct ctrl_group
+			{
+				static constexpr size_t width = 8;
+
+				uint64 ctrl;
+
+				explicit ctrl_group(const int8* pos)
+				{
+					std::memcpy(&ctrl, pos, sizeof(ctrl));
+				}
+
+				inline uint32 match(int8 h2) const
+				{
+					uint32 mask = 0;
+					for (size_t i = 0; i < width; ++i)
+						mask |= uint32(int8(ctrl >> (i * 8)) == h2) << i;
+
+					return mask;
+				}
+
+				inline uint32 match_free() const
+				{
+					uint32 mask = 0;
+					for (size_t i = 0; i < width; ++i)
+						mask |= uint32((ctrl >> (i * 8 + 7)) & 1) << i;
+
+					return mask;
+				}
+
+				inline uint32 match_empty() const
+				{
+					return match(int8(-128));
+				}
+			};
+#endif
+
+			struct no_meta { };
+
+			// Swiss table style open addressing map.
+			// Values live in chunks that never move (stable addresses, like the cgc arrays), the hashed part is a side index of
+			// control bytes + slot numbers, so growing only rehashes the index. Every slot can carry a Meta object (e.g. a counter).
+			// A slot goes through: insert (linked) + constructing the value -> unlink (no longer found) -> destroy -> release (reusable),
+			// emplace() and erase() do those steps in one go. Not thread safe, like std::unordered_map.
+			template<class K, class V, class Meta = no_meta, class Hash = std::hash<K>, class KeyEqual = std::equal_to<K>>
+			class flat_table
+			{
+			public:
+				typedef K key_type;
+				typedef V mapped_type;
+				typedef std::pair<const K&, V&> reference;
+
+				static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+			private:
+				static constexpr int8 ctrl_empty = -128;
+				static constexpr int8 ctrl_deleted = -2;
+				static constexpr size_t chunk_bits = 6;
+				static constexpr size_t chunk_size = size_t(1) << chunk_bits;
+				static constexpr uint32 unlinked = std::numeric_limits<uint32>::max();
+
+				struct chunk
+				{
+					union { K keys[chunk_size]; };
+					union { V values[chunk_size]; };
+					union { Meta metas[chunk_size]; };
+
+					chunk() { }
+					~chunk() { }
+				};
+
+				std::pmr::memory_resource* resource;
+
+				// side index
+				int8* ctrl = nullptr;
+				uint32* index = nullptr;
+				size_t capacity = 0; // multiple of ctrl_group::width, or 0
+				size_t growthLeft = 0;
+
+				// stable storage
+				std::pmr::vector<chunk*> chunks;
+				std::pmr::vector<uint32> positions; // index position per slot, or unlinked
+				std::pmr::vector<uint64> live; // linked slots, iteration goes over these
+				std::pmr::vector<uint32> freeList;
+				size_t count = 0;
+
+				Hash hasher;
+				KeyEqual equal;
+
+				// std::hash is the identity for integers, spread the bits so sequential keys don't share h1 and probe chains
+				inline size_t hash_of(const K& key) const
+				{
+					const uint64 h = uint64(hasher(key)) * 0x9E3779B97F4A7C15ull;
+					return size_t(h ^ (h >> 32));
+				}
+
+				static inline size_t h1(size_t hash) { return hash >> 7; }
+				static inline int8 h2(size_t hash) { return int8(hash & 0x7F); }
+
+				inline size_t group_count() const { return capacity / ctrl_group::width; }
+
+				// index position of the key, or npos
+				inline size_t find_position(const K& key, size_t hash) const
+				{
+					return probe(ctrl, index, capacity, hash, [&](size_t slot) { return equal(key_ref(slot), key); });
+				}
+
+				// position in the index (control bytes c, slot numbers ix) of the slot that matches, or npos
+				// probes whole groups in triangular steps, which visits every group once for a power of 2 group count
+				template<class _Match>
+				static size_t probe(const int8* c, const uint32* ix, size_t cap, size_t hash, _Match&& match)
+				{
+					const size_t groups = cap / ctrl_group::width;
+					const int8 tag = h2(hash);
+
+					size_t g = h1(hash) & (groups - 1);
+					for (size_t step = 1; step <= groups; ++step)
+					{
+						const size_t base = g * ctrl_group::width;
+						const ctrl_group group(c + base);
+						for (uint32 m = group.match(tag); m != 0; m &= m - 1)
+						{
+							const size_t pos = base + bsf(m);
+							if (match(size_t(ix[pos])))
+								return pos;
+						}
+
+						// an empty byte ends the chain, the key would've been put there
+						if (group.match_empty() != 0)
+							return npos;
+
+						g = (g + step) & (groups - 1);
+					}
+
+					return npos;
+				}
+
+				// expects at least one free position (see reserve_position())
+				size_t free_position(size_t hash) const
+				{
+					const size_t groups = group_count();
+
+					size_t g = h1(hash) & (groups - 1);
+					for (size_t step = 1; ; ++step)
+					{
+						const size_t base = g * ctrl_group::width;
+						const uint32 m = ctrl_group(ctrl + base).match_free();
+						if (m != 0)
+							return base + bsf(m);
+
+						g = (g + step) & (groups - 1);
+					}
+				}
+
+				void link(size_t slot, size_t hash)
+				{
+					const size_t pos = free_position(hash);
+					if (ctrl[pos] == ctrl_empty)
+						--growthLeft;
+
+					ctrl[pos] = h2(hash);
+					index[pos] = uint32(slot);
+					positions[slot] = uint32(pos);
+				}
+
+				// rebuild the index, the values stay where they are
+				void rehash(size_t newCapacity)
+				{
+					free_index();
+					ctrl = resource_allocate<int8>(resource, newCapacity);
+					index = resource_allocate<uint32>(resource, newCapacity);
+					std::memset(ctrl, ctrl_empty, newCapacity);
+					capacity = newCapacity;
+					growthLeft = newCapacity - newCapacity / 8;
+
+					for (size_t slot = next_live(0); slot < slot_count(); slot = next_live(slot + 1))
+						link(slot, hash_of(key_ref(slot)));
+				}
+
+				inline void free_index()
+				{
+					resource_deallocate(resource, ctrl, capacity);
+					resource_deallocate(resource, index, capacity);
+					ctrl = nullptr;
+					index = nullptr;
+				}
+
+				void reserve_position()
+				{
+					if (growthLeft > 0)
+						return;
+
+					// lots of deleted markers: same size is enough, otherwise double
+					if (count < (capacity - capacity / 8) / 2)
+						rehash(capacity);
+					else
+						rehash(capacity == 0 ? ctrl_group::width : capacity * 2);
+				}
+
+				size_t allocate_slot()
+				{
+					if (!freeList.empty())
+					{
+						size_t slot = freeList.back();
+						freeList.pop_back();
+						return slot;
+					}
+
+					const size_t slot = positions.size();
+					if ((slot & (chunk_size - 1)) == 0)
+					{
+						chunks.push_back(resource_new<chunk>(resource));
+						live.push_back(0);
+					}
+
+					positions.push_back(unlinked);
+					return slot;
+				}
+
+				inline K& key_ref(size_t slot) const
+				{
+					return chunks[slot >> chunk_bits]->keys[slot & (chunk_size - 1)];
+				}
+
+				inline void set_live(size_t slot, bool value)
+				{
+					const uint64 bit = uint64(1) << (slot & 63);
+					live[slot >> 6] = value ? live[slot >> 6] | bit : live[slot >> 6] & ~bit;
+				}
+
+			public:
+				struct iterator
+				{
+					friend class flat_table;
+
+					// keys and values are stored apart, dereferencing gives a pair of references
+					struct arrow
+					{
+						flat_table::reference pair;
+						inline const flat_table::reference* operator->() const { return &pair; }
+					};
+
+					using iterator_category = std::forward_iterator_tag;
+					using difference_type = std::ptrdiff_t;
+					using value_type = flat_table::reference;
+					using pointer = arrow;
+					using reference = flat_table::reference;
+
+				private:
+					const flat_table* table;
+					size_t slot;
+
+					iterator(const flat_table* table, size_t slot)
+						: table(table)
+						, slot(slot)
+					{ }
+
+				public:
+					iterator()
+						: table(nullptr)
+						, slot(0)
+					{ }
+
+					iterator& operator++()
+					{
+						slot = table->next_live(slot + 1);
+						return *this;
+					}
+
+					iterator operator++(int)
+					{
+						iterator it = *this;
+						++*this;
+						return it;
+					}
+
+					bool operator==(const iterator& other) const { return slot == other.slot; }
+					bool operator!=(const iterator& other) const { return slot != other.slot; }
+
+					reference operator*() const { return { table->key_ref(slot), *table->value(slot) }; }
+					pointer operator->() const { return { **this }; }
+
+					inline size_t get_slot() const { return slot; }
+				};
+
+				explicit flat_table(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+					: resource(resource)
+					, chunks(resource)
+					, positions(resource)
+					, live(resource)
+					, freeList(resource)
+				{ }
+
+				flat_table(const flat_table&) = delete;
+				flat_table& operator=(const flat_table&) = delete;
+
+				~flat_table()
+				{
+					clear();
+				}
+
+				inline size_t size() const { return count; }
+				inline bool empty() const { return count == 0; }
+
+				// amount of slots ever handed out, slot numbers are below this
+				inline size_t slot_count() const { return positions.size(); }
+
+				// first linked slot at or after `slot`
+				size_t next_live(size_t slot) const
+				{
+					for (size_t w = slot >> 6; w < live.size(); ++w)
+					{
+						const uint64 bits = (slot >> 6) == w ? live[w] & (~uint64(0) << (slot & 63)) : live[w];
+						if (bits != 0)
+							return (w << 6) + bsf(bits);
+					}
+
+					return slot_count();
+				}
+
+				// find or insert the key, a new slot has its key but no value yet: construct it at value(slot) right away
+				std::pair<size_t, bool> insert(const K& key)
+				{
+					const size_t hash = hash_of(key);
+					const size_t pos = find_position(key, hash);
+					if (pos != npos)
+						return { index[pos], false };
+
+					reserve_position();
+
+					const size_t slot = allocate_slot();
+					new (&key_ref(slot)) K(key);
+					link(slot, hash);
+					set_live(slot, true);
+					++count;
+
+					return { slot, true };
+				}
+
+				// find or insert the key, constructs the value from `arguments` when inserted
+				template<class... _Args>
+				std::pair<size_t, bool> emplace(const K& key, _Args&&... arguments)
+				{
+					std::pair<size_t, bool> result = insert(key);
+					if (result.second)
+					{
+						try
+						{
+							new (value(result.first)) V(std::forward<_Args>(arguments)...);
+						}
+						catch (...)
+						{
+							unlink(result.first);
+							key_ref(result.first).~K();
+							release(result.first);
+							throw;
+						}
+					}
+
+					return result;
+				}
+
+				size_t find_slot(const K& key) const
+				{
+					const size_t pos = find_position(key, hash_of(key));
+					return pos != npos ? index[pos] : npos;
+				}
+
+				static constexpr size_t retry = npos - 1;
+
+				// find_slot() for readers that don't lock the table, seqlock style: writers make `version` odd before they change
+				// the table and even again once done, and free its memory through an epoch_resource while the reader holds an
+				// epoch_guard. Whatever is read while a writer is busy is thrown away, retry is returned then.
+				// Keys are compared while they may be overwritten, so they have to be trivially copyable
+				size_t find_slot_optimistic(const K& key, const std::atomic<uint64>& version) const
+				{
+					static_assert(std::is_trivially_copyable_v<K>, "find_slot_optimistic() compares keys that may be overwritten meanwhile");
+
+					const uint64 v = version.load(std::memory_order_acquire);
+					if (v & 1)
+						return retry;
+
+					// the arrays stay allocated while the reader is pinned, bounds are only right if no writer got in between
+					const int8* const c = ctrl;
+					const uint32* const ix = index;
+					const size_t cap = capacity;
+					chunk* const* const ch = chunks.data();
+					const size_t slots = positions.size();
+
+					std::atomic_thread_fence(std::memory_order_acquire);
+					if (version.load(std::memory_order_relaxed) != v)
+						return retry;
+
+					size_t slot = npos;
+					if (cap != 0)
+					{
+						// index entries may be half written, slot numbers past the snapshot are skipped
+						const size_t pos = probe(c, ix, cap, hash_of(key), [&](size_t s)
+						{
+							return s < slots && equal(ch[s >> chunk_bits]->keys[s & (chunk_size - 1)], key);
+						});
+
+						if (pos != npos)
+							slot = ix[pos];
+					}
+
+					std::atomic_thread_fence(std::memory_order_acquire);
+					return version.load(std::memory_order_relaxed) == v ? slot : retry;
+				}
+
+				inline const K& key(size_t slot) const
+				{
+					return key_ref(slot);
+				}
+
+				inline V* value(size_t slot) const
+				{
+					return chunks[slot >> chunk_bits]->values + (slot & (chunk_size - 1));
+				}
+
+				inline Meta* meta(size_t slot)
+				{
+					return chunks[slot >> chunk_bits]->metas + (slot & (chunk_size - 1));
+				}
+
+				inline bool linked(size_t slot) const
+				{
+					return slot < slot_count() && positions[slot] != unlinked;
+				}
+
+				// the key won't be found anymore, the value stays alive (no hashing, the slot knows its position)
+				void unlink(size_t slot)
+				{
+					if (!linked(slot))
+						return;
+
+					const size_t pos = positions[slot];
+
+					// a group without empty bytes may be part of a probe chain, keep the chain intact
+					const size_t base = pos - pos % ctrl_group::width;
+					if (ctrl_group(ctrl + base).match_empty() != 0)
+					{
+						ctrl[pos] = ctrl_empty;
+						++growthLeft;
+					}
+					else
+						ctrl[pos] = ctrl_deleted;
+
+					positions[slot] = unlinked;
+					set_live(slot, false);
+					--count;
+				}
+
+				inline void destroy(size_t slot)
+				{
+					key_ref(slot).~K();
+					value(slot)->~V();
+				}
+
+				// slot number may be handed out again
+				inline void release(size_t slot)
+				{
+					freeList.push_back(uint32(slot));
+				}
+
+				inline void erase_slot(size_t slot)
+				{
+					unlink(slot);
+					destroy(slot);
+					release(slot);
+				}
+
+				size_t erase(const K& key)
+				{
+					const size_t slot = find_slot(key);
+					if (slot == npos)
+						return 0;
+
+					erase_slot(slot);
+					return 1;
+				}
+
+				inline iterator erase(iterator it)
+				{
+					iterator next = it;
+					++next;
+					erase_slot(it.slot);
+					return next;
+				}
+
+				inline size_t count_key(const K& key) const
+				{
+					return find_slot(key) != npos;
+				}
+
+				inline iterator find(const K& key) const
+				{
+					const size_t slot = find_slot(key);
+					return slot != npos ? iterator(this, slot) : end();
+				}
+
+				V& operator[](const K& key)
+				{
+					return *value(emplace(key).first);
+				}
+
+				inline iterator begin() const { return iterator(this, next_live(0)); }
+				inline iterator end() const { return iterator(this, slot_count()); }
+
+				// destroys the linked values, unlinked slots are the owners' responsibility (see destroy())
+				void clear()
+				{
+					for (size_t slot = next_live(0); slot < slot_count(); slot = next_live(slot + 1))
+						destroy(slot);
+
+					for (chunk* c : chunks)
+						resource_delete(resource, c);
+
+					chunks.clear();
+					positions.clear();
+					live.clear();
+					freeList.clear();
+					free_index();
+					capacity = growthLeft = count = 0;
+				}
+			};
+		}
+	}
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <limits>
+
+#include "../../bitops.h"
+
+namespace cppu
+{
+	namespace cgc
+	{
+		namespace details
+		{
+			// Three level summary of which blocks (probably) have a free slot, every level is a set of 64 bit words
+			// so finding a block is 3 bit scans no matter how many blocks there are.
+			// The bits are hints: a set bit may point to a block that just filled up (the caller clears it and retries),
+			// a cleared bit is re-set by whoever frees a slot in a full block.
+			class free_bitmap
+			{
+			private:
+				static constexpr size_t bits = std::numeric_limits<uint64>::digits;
+				static constexpr size_t page_size = bits * bits;
+
+				// top bit n: mid[n] != 0, mid[n] bit m: pages[n][m] != 0, pages[n][m] bit b: block (n * 64 + m) * 64 + b has free slots
+				std::atomic<uint64> top;
+				std::atomic<uint64> mid[bits];
+				std::atomic<std::atomic<uint64>*> pages[bits];
+
+			public:
+				static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+				static constexpr size_t capacity() { return bits * page_size; }
+
+				free_bitmap()
+					: top(0)
+				{
+					for (size_t i = 0; i < bits; ++i)
+					{
+						mid[i].store(0, std::memory_order_relaxed);
+						pages[i].store(nullptr, std::memory_order_relaxed);
+					}
+				}
+
+				~free_bitmap()
+				{
+					for (size_t i = 0; i < bits; ++i)
+						delete[] pages[i].load();
+				}
+
+				free_bitmap(const free_bitmap&) = delete;
+				free_bitmap& operator=(const free_bitmap&) = delete;
+
+				// Make sure the leaf words of the block exist, call this (serialized) before the block is published
+				void reserve(size_t index)
+				{
+					if (pages[index / page_size].load() == nullptr)
+					{
+						std::atomic<uint64>* words = new std::atomic<uint64>[bits];
+						for (size_t i = 0; i < bits; ++i)
+							words[i].store(0, std::memory_order_relaxed);
+
+						pages[index / page_size].store(words);
+					}
+				}
+
+				size_t find() const
+				{
+					size_t n = bs_rtol(top.load());
+					if (n >= bits)
+						return npos;
+
+					size_t m = bs_rtol(mid[n].load());
+					if (m >= bits)
+						return npos;
+
+					size_t b = bs_rtol(pages[n].load()[m].load());
+					if (b >= bits)
+						return npos;
+
+					return (n * bits + m) * bits + b;
+				}
+
+				void set(size_t index)
+				{
+					const size_t n = index / page_size, m = (index / bits) % bits, b = index % bits;
+
+					// only propagate upwards on a 0 -> 1 transition of a word
+					if (set_bit(pages[n].load()[m], uint64(1) << b) == 0)
+					{
+						if (set_bit(mid[n], uint64(1) << m) == 0)
+							set_bit(top, uint64(1) << n);
+					}
+				}
+
+				template<typename _HasFree>
+				void clear(size_t index, _HasFree&& has_free)
+				{
+					const size_t n = index / page_size, m = (index / bits) % bits, b = index % bits;
+					std::atomic<uint64>& leaf = pages[n].load()[m];
+
+					if (clr_bit(leaf, uint64(1) << b) == (uint64(1) << b))
+					{
+						// word became empty, a concurrent set() may have raced us, so recheck after clearing the summary bit
+						if (clr_bit(mid[n], uint64(1) << m) == (uint64(1) << m))
+						{
+							clr_bit(top, uint64(1) << n);
+							if (mid[n].load() != 0)
+								set_bit(top, uint64(1) << n);
+						}
+
+						if (leaf.load() != 0 && (set_bit(mid[n], uint64(1) << m) == 0))
+							set_bit(top, uint64(1) << n);
+					}
+
+					// a slot may have been freed in between checking and clearing
+					if (has_free())
+						set(index);
+				}
+			};
+		}
+	}
+}
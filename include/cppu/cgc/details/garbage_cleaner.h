@@ -1,90 +1,295 @@
 #pragma once
 
 #include <thread>
-#include <queue>
+#include <atomic>
+#include <vector>
+#include <memory>
 #include <mutex>
 #include <condition_variable>
 #include "icontainer.h"
-#include "destructors.h"
-
-#include <iostream>
+#include "stats.h"
+#include "../../exec/scheduler.h"
 
 namespace cppu
 {
 	namespace cgc
 	{
-		void gc_start();
+		void gc_start(size_t threads, size_t batch);
+		void gc_start(exec::scheduler& scheduler, size_t batch);
 		void gc_stop();
+		cleaner_stats gc_stats();
 
 		namespace details
 		{
+			// Background cleaning for CLEAN_PROC::THREAD containers.
+			// Dirty containers go into one of several lock-free lists (picked per producing thread), every cleaner thread owns
+			// a subset of those lists and cleans up to `batch` objects of a container before it moves on to the next one.
+			// A container is only listed once while it's dirty, see icontainer::queued, but may be visited by two cleaners at once.
+			// On a scheduler every list that goes from empty to dirty posts a low priority task that cleans it once, instead.
+			// Call gc_stop() before destroying a THREAD container that might still be listed. It doesn't wait for the scheduler to get to
+			// the posted tasks, what they would have cleaned is cleaned on the calling thread and the tasks do nothing once they run.
 			class garbage_cleaner
 			{
-				friend void cgc::gc_start();
+				friend void cgc::gc_start(size_t, size_t);
+				friend void cgc::gc_start(exec::scheduler&, size_t);
 				friend void cgc::gc_stop();
+				friend cleaner_stats cgc::gc_stats();
 			private:
-				static std::queue<icontainer*>& dirtyContainers() { static std::queue<icontainer*> v; return v; }
-
-				static std::thread& thread() { static std::thread v; return v; }
-				static std::mutex& lock() { static std::mutex v; return v; }
-				static std::condition_variable& wait() { static std::condition_variable v; return v; }
-				static bool& running() { static bool v = false; return v; }
-				
-				static void thread_function()
+				struct alignas(64) shard
 				{
-					icontainer* container;
+					// multi producer, single consumer: producers push onto the head, the owning cleaner takes the whole list
+					std::atomic<icontainer*> head = nullptr;
+				};
 
-					while (running())
+				struct worker
+				{
+					std::thread thread;
+					std::mutex lock;
+					std::condition_variable wait;
+				};
+
+				static constexpr size_t shard_count = 16;
+
+				static shard* shards() { static shard v[shard_count]; return v; }
+				// the cleaner threads, guarded by pool_lock(): producers wake them while gc_stop() takes them down
+				static std::vector<std::unique_ptr<worker>>& workers() { static std::vector<std::unique_ptr<worker>> v; return v; }
+				static std::mutex& pool_lock() { static std::mutex v; return v; }
+				static size_t& batch_size() { static size_t v = 64; return v; }
+				static std::atomic<bool>& running() { static std::atomic<bool> v = false; return v; }
+				static std::atomic<exec::scheduler*>& scheduler() { static std::atomic<exec::scheduler*> v = nullptr; return v; }
+				// posts and cleaning tasks in progress, not the tasks that are still queued on the scheduler
+				static std::atomic<size_t>& busy() { static std::atomic<size_t> v = 0; return v; }
+#ifdef CPPU_CGC_STATS
+				static std::atomic<size_t>& queued() { static std::atomic<size_t> v = 0; return v; }
+				static latency_histogram& latencies() { static latency_histogram v; return v; }
+#endif
+
+				// producers stick to one shard, spreads the pushes without a lookup
+				static size_t shard_index()
+				{
+					static std::atomic<size_t> counter = 0;
+					thread_local size_t index = counter.fetch_add(1);
+					return index % shard_count;
+				}
+
+				// takes the whole list of shard s and visits every container on it once, false if it was empty
+				static bool clean_shard(size_t s)
+				{
+					icontainer* container = shards()[s].head.exchange(nullptr);
+					if (container == nullptr)
+						return false;
+
+					while (container != nullptr)
 					{
+						icontainer* next = container->nextDirty;
+
+						// new garbage from here on lists the container again
+						container->queued.store(false);
+#ifdef CPPU_CGC_STATS
+						queued().fetch_sub(1, std::memory_order_relaxed);
+						const uint64 start = stats_now();
+#endif
+						size_t cleanedObjects;
 						{
-							std::unique_lock<std::mutex> lk(lock());
-							wait().wait(lk);
+							trace_scope trace("cgc::cleaner_visit", container);
+							cleanedObjects = container->clean_garbage(batch_size());
+						}
+#ifdef CPPU_CGC_STATS
+						latencies().record(stats_now() - start, cleanedObjects);
+#endif
+						if (cleanedObjects >= batch_size())
+							add_to_clean(container); // probably more to do, let the others have a go first
+
+						container = next;
+					}
 
-							if (dirtyContainers().empty())
-								continue;
+					return true;
+				}
+
+				// gets its own worker, the list itself may be emptied by disable() meanwhile
+				static void thread_function(worker* self, size_t index, size_t workerCount)
+				{
+					while (running())
+					{
+						bool cleaned = false;
+						for (size_t s = index; s < shard_count; s += workerCount)
+							cleaned |= clean_shard(s);
 
-							container = dirtyContainers().front();
-							dirtyContainers().pop();
+						if (!cleaned)
+						{
+							std::unique_lock<std::mutex> lk(self->lock);
+							if (running() && !has_work(index, workerCount))
+								self->wait.wait(lk);
 						}
+					}
+				}
+
+				// counted before running() is checked, disable() waits for every post and task that saw it true
+				static void post_shard(size_t s)
+				{
+					busy().fetch_add(1);
+					exec::scheduler* target = scheduler().load();
+					if (running() && target != nullptr)
+					{
+						target->post([s]()
+						{
+							// queued before gc_stop(), disable() cleaned the shard already
+							busy().fetch_add(1);
+							if (running())
+								clean_shard(s);
+
+							busy().fetch_sub(1);
+						}, exec::priority::low);
+					}
+
+					busy().fetch_sub(1);
+				}
+
+				static bool has_work(size_t index, size_t workerCount)
+				{
+					for (size_t s = index; s < shard_count; s += workerCount)
+					{
+						if (shards()[s].head.load() != nullptr)
+							return true;
+					}
+
+					return false;
+				}
 
-						container->clean_garbage();
+				static void enable(size_t threads, size_t batch)
+				{
+					if (!running())
+					{
+						// more cleaners than shards would leave some without work
+						threads = threads > 0 ? (threads < shard_count ? threads : shard_count) : 1;
+						batch_size() = batch > 0 ? batch : 1;
+						running() = true;
+
+						std::lock_guard<std::mutex> pool(pool_lock());
+						for (size_t i = 0; i < threads; ++i)
+							workers().emplace_back(new worker());
+
+						for (size_t i = 0; i < threads; ++i)
+							workers()[i]->thread = std::thread(&garbage_cleaner::thread_function, workers()[i].get(), i, threads);
 					}
 				}
 
-				static void enable()
+				static void enable(exec::scheduler& target, size_t batch)
 				{
 					if (!running())
 					{
+						batch_size() = batch > 0 ? batch : 1;
+						scheduler() = &target;
 						running() = true;
-						thread() = std::thread(&garbage_cleaner::thread_function);
+
+						// lists that got dirty before
+						for (size_t s = 0; s < shard_count; ++s)
+						{
+							if (shards()[s].head.load() != nullptr)
+								post_shard(s);
+						}
 					}
 				}
 
 				static void disable()
 				{
 					running() = false;
-					wait().notify_one();
-					thread().join();
+
+					// only posts and tasks that are running right now, they don't depend on the scheduler picking anything up
+					while (busy().load() != 0)
+						std::this_thread::yield();
+
+					// the tasks that are still queued won't clean anymore (the scheduler may never run them), do their work here
+					if (scheduler().exchange(nullptr) != nullptr)
+					{
+						for (size_t s = 0; s < shard_count; ++s)
+							clean_shard(s);
+					}
+
+					std::vector<std::unique_ptr<worker>> stopping;
+					{
+						std::lock_guard<std::mutex> pool(pool_lock());
+						stopping.swap(workers());
+					}
+
+					for (auto& w : stopping)
+					{
+						{
+							std::lock_guard<std::mutex> lk(w->lock);
+							w->wait.notify_one();
+						}
+
+						if (w->thread.joinable())
+							w->thread.join();
+					}
 				}
 
 			public:
 				static bool add_to_clean(icontainer* container)
 				{
-					dirtyContainers().push(container);
-					wait().notify_one();
+					// already listed, the cleaner will see the new garbage as well
+					if (container->queued.exchange(true))
+						return true;
+
+#ifdef CPPU_CGC_STATS
+					queued().fetch_add(1, std::memory_order_relaxed);
+#endif
+
+					const size_t s = shard_index();
+					std::atomic<icontainer*>& head = shards()[s].head;
+
+					icontainer* first = head.load();
+					do
+						container->nextDirty = first;
+					while (!head.compare_exchange_weak(first, container));
+
+					// only wake the cleaner when its list goes from empty to dirty
+					if (first == nullptr && scheduler().load() != nullptr)
+						post_shard(s);
+					else if (first == nullptr && running())
+					{
+						std::lock_guard<std::mutex> pool(pool_lock());
+						std::vector<std::unique_ptr<worker>>& w = workers();
+						if (!w.empty())
+						{
+							worker& owner = *w[s % w.size()];
+							std::lock_guard<std::mutex> lk(owner.lock);
+							owner.wait.notify_one();
+						}
+					}
+
 					return true;
 				}
 			};
 		}
-		
-		inline void gc_start()
+
+		// Start cleaning THREAD containers in the background with `threads` cleaners, each cleaning `batch` objects per container visit
+		inline void gc_start(size_t threads = 1, size_t batch = 64)
 		{
-			details::garbage_cleaner::enable();
+			details::garbage_cleaner::enable(threads, batch);
+		}
+
+		// Same, but cleaning runs as low priority tasks on scheduler (its workers are shared with everything else), gc_stop() before the scheduler goes away
+		inline void gc_start(exec::scheduler& scheduler, size_t batch = 64)
+		{
+			details::garbage_cleaner::enable(scheduler, batch);
 		}
 
 		inline void gc_stop()
 		{
 			details::garbage_cleaner::disable();
 		}
+
+		// containers waiting for a cleaner and the latencies of the cleaners' visits, all 0 without CPPU_CGC_STATS
+		inline cleaner_stats gc_stats()
+		{
+			cleaner_stats s;
+#ifdef CPPU_CGC_STATS
+			s.queued = details::garbage_cleaner::queued().load(std::memory_order_relaxed);
+			details::garbage_cleaner::latencies().fill(s);
+#endif
+			s.time = details::stats_now();
+			return s;
+		}
 	}
-}
\ No newline at end of file
+}
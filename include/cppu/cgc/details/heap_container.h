@@ -0,0 +1,37 @@
+#pragma once
+
+#include "icontainer.h"
+#include "base_counter.h"
+
+namespace cppu
+{
+	namespace cgc
+	{
+		namespace details
+		{
+			// Owner of objects made by gcnew/construct_new, one stateless instance per type so the destructor is known at compile time
+			template<class T>
+			class heap_container final : public icontainer
+			{
+			public:
+				static heap_container& instance() { static heap_container v; return v; }
+
+				bool add_as_garbage(void* ptr, const base_counter*) override
+				{
+					delete static_cast<T*>(ptr);
+					return true;
+				}
+
+				void release(const base_counter* c) override
+				{
+					delete c;
+				}
+
+				size_t clean_garbage(size_t = 4294967295u) override
+				{
+					return 0;
+				}
+			};
+		}
+	}
+}
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <atomic>
 #include <limits>
+#include <thread>
 
 namespace cppu
 {
@@ -9,13 +11,53 @@ namespace cppu
 		namespace details
 		{
 			struct base_counter;
+			class garbage_cleaner;
 
 			class icontainer
 			{
+				friend class garbage_cleaner;
+			private:
+				// garbage_cleaner bookkeeping, a container is listed at most once while it's dirty
+				std::atomic<bool> queued;
+				icontainer* nextDirty;
+
+#ifndef NDEBUG
+			protected:
+				// set by thread_policy::local containers, checked on every counter update
+				std::thread::id owner;
+#endif
+
 			public:
+				icontainer()
+					: queued(false)
+					, nextDirty(nullptr)
+				{ }
+
+				// a copy isn't listed anywhere yet
+				icontainer(const icontainer&)
+					: icontainer()
+				{ }
+
+				icontainer& operator=(const icontainer&)
+				{
+					return *this;
+				}
+
+				// last strong reference is gone, destruct (or queue) the object
 				virtual bool add_as_garbage(void* ptr, const base_counter* c) = 0;
+
+				// last weak reference is gone (strong ones count as one), the counter may be reused or deleted
+				virtual void release(const base_counter* c) = 0;
+
 				virtual size_t clean_garbage(size_t max = 4294967295u) = 0;
+
+#ifndef NDEBUG
+				inline bool owned_by_current_thread() const
+				{
+					return owner == std::thread::id() || owner == std::this_thread::get_id();
+				}
+#endif
 			};
 		}
 	}
-}
\ No newline at end of file
+}
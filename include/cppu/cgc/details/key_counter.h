@@ -1,6 +1,6 @@
 #pragma once
 
-#include "container_counter.h"
+#include "base_counter.h"
 
 namespace cppu
 {
@@ -9,17 +9,14 @@ namespace cppu
 		namespace details
 		{
 			template<class K>
-			struct key_counter : public container_counter
+			struct key_counter : public base_counter
 			{
-				template<typename> friend class strong_ptr;
 			protected:
 				K key;
 
-				//virtual void add_as_garbage(void* ptr) { container->add_as_garbage(ptr, this); }
-
 			public:
-				key_counter(icontainer* container, const K& key, destructor&& destructor)
-					: container_counter(container, std::move(destructor))
+				key_counter(icontainer* container, const K& key)
+					: base_counter(container)
 					, key(key)
 				{ }
 
@@ -30,4 +27,4 @@ namespace cppu
 			};
 		}
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+namespace cppu
+{
+	namespace cgc
+	{
+		namespace details
+		{
+			// new / delete through a memory resource, the containers use these for their blocks, chunks and counters
+			template<class T, class... _Args>
+			inline T* resource_new(std::pmr::memory_resource* resource, _Args&&... arguments)
+			{
+				void* memory = resource->allocate(sizeof(T), alignof(T));
+				try
+				{
+					return new (memory) T(std::forward<_Args>(arguments)...);
+				}
+				catch (...)
+				{
+					resource->deallocate(memory, sizeof(T), alignof(T));
+					throw;
+				}
+			}
+
+			template<class T>
+			inline void resource_delete(std::pmr::memory_resource* resource, T* object)
+			{
+				if (object != nullptr)
+				{
+					object->~T();
+					resource->deallocate(object, sizeof(T), alignof(T));
+				}
+			}
+
+			// uninitialized storage for count trivial values
+			template<class T>
+			inline T* resource_allocate(std::pmr::memory_resource* resource, size_t count)
+			{
+				return static_cast<T*>(resource->allocate(sizeof(T) * count, alignof(T)));
+			}
+
+			template<class T>
+			inline void resource_deallocate(std::pmr::memory_resource* resource, T* values, size_t count)
+			{
+				if (values != nullptr)
+					resource->deallocate(values, sizeof(T) * count, alignof(T));
+			}
+		}
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+
+#include "types.h"
+
+#ifdef WIN32
+#include "windows.h"
+#elif defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace cppu
+{
+	namespace cgc
+	{
+		namespace details
+		{
+			// NUMA node of the processor the calling thread runs on right now, 0 if unknown
+			inline size_t numa_node()
+			{
+#ifdef WIN32
+				PROCESSOR_NUMBER processor;
+				GetCurrentProcessorNumberEx(&processor);
+
+				USHORT node = 0;
+				return GetNumaProcessorNodeEx(&processor, &node) ? size_t(node) : 0;
+#elif defined(__linux__)
+				unsigned int cpu = 0, node = 0;
+				return getcpu(&cpu, &node) == 0 ? size_t(node) : 0;
+#else
+				return 0;
+#endif
+			}
+
+			// threads keep the index they got on first use
+			inline size_t thread_index()
+			{
+				static std::atomic<size_t> counter = 0;
+				thread_local size_t index = counter.fetch_add(1);
+				return index;
+			}
+
+			// block list of the calling thread, 0 .. policy::homes - 1
+			template<class policy>
+			struct placement
+			{
+				static inline size_t current_home() { return 0; }
+			};
+
+			template<size_t Threads>
+			struct placement<thread_policy::per_thread<Threads>>
+			{
+				static inline size_t current_home() { return thread_index() % Threads; }
+			};
+
+			template<size_t Nodes>
+			struct placement<thread_policy::numa<Nodes>>
+			{
+				static inline size_t current_home() { return numa_node() % Nodes; }
+			};
+
+			template<class policy>
+			inline size_t current_home()
+			{
+				return placement<policy>::current_home();
+			}
+		}
+	}
+}
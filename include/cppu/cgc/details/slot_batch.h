@@ -0,0 +1,177 @@
+#pragma once
+
+#include <bitset>
+#include <vector>
+
+#include "../pointers.h"
+#include "../constructor.h"
+#include "../../bitops.h"
+
+namespace cppu
+{
+	namespace cgc
+	{
+		namespace details
+		{
+			// Objects emplaced together (emplace_n(), emplace_range()), holds one strong reference per object like a strong_ptr would.
+			// Slots are kept as runs of bits per mask word instead of a pointer per object,
+			// releasing the batch updates the container masks once per run.
+			template<class T, class A>
+			class slot_batch
+			{
+				template<typename, typename, CLEAN_PROC, typename> friend class cgc::array;
+				template<typename, typename, CLEAN_PROC, typename> friend class cgc::m_array;
+
+			private:
+				struct run
+				{
+					A* arr;
+					size_t word;
+					uint64 bits;
+				};
+
+				std::vector<run> runs;
+				size_t count = 0;
+
+				inline void add(A* arr, size_t word, uint64 bits)
+				{
+					runs.push_back({ arr, word, bits });
+					count += std::bitset<64>(bits).count();
+				}
+
+			public:
+				struct iterator
+				{
+					friend class slot_batch;
+
+					using iterator_category = std::forward_iterator_tag;
+					using difference_type = std::ptrdiff_t;
+					using value_type = T;
+					using pointer = T*;
+					using reference = T&;
+
+				private:
+					const run* current;
+					const run* last;
+					uint64 bits;
+
+					iterator(const run* current, const run* last)
+						: current(current)
+						, last(last)
+						, bits(current != last ? current->bits : 0)
+					{ }
+
+					inline size_t slot() const
+					{
+						return current->word * 64 + bsf(bits);
+					}
+
+				public:
+					iterator& operator++()
+					{
+						bits &= bits - 1;
+						if (bits == 0 && ++current != last)
+							bits = current->bits;
+
+						return *this;
+					}
+
+					iterator operator++(int)
+					{
+						iterator cpy = *this;
+						this->operator++();
+						return cpy;
+					}
+
+					bool operator==(const iterator& other) const
+					{
+						return current == other.current && bits == other.bits;
+					}
+
+					bool operator!=(const iterator& other) const
+					{
+						return !operator==(other);
+					}
+
+					T* operator->() const
+					{
+						return &(*current->arr)[slot()];
+					}
+
+					T& operator*() const
+					{
+						return (*current->arr)[slot()];
+					}
+
+					// a strong_ptr of its own, stays valid after the batch is released
+					auto share() const
+					{
+						return current->arr->share(slot());
+					}
+				};
+
+				slot_batch() = default;
+
+				slot_batch(slot_batch&& move) noexcept
+					: runs(std::move(move.runs))
+					, count(move.count)
+				{
+					move.runs.clear();
+					move.count = 0;
+				}
+
+				slot_batch& operator=(slot_batch&& move) noexcept
+				{
+					if (this != &move)
+					{
+						release();
+						runs = std::move(move.runs);
+						count = move.count;
+						move.runs.clear();
+						move.count = 0;
+					}
+
+					return *this;
+				}
+
+				slot_batch(const slot_batch&) = delete;
+				slot_batch& operator=(const slot_batch&) = delete;
+
+				~slot_batch()
+				{
+					release();
+				}
+
+				// drops the references of all objects, same as letting every strong_ptr go
+				void release()
+				{
+					for (const run& r : runs)
+						r.arr->release_run(r.word, r.bits);
+
+					runs.clear();
+					count = 0;
+				}
+
+				inline size_t size() const
+				{
+					return count;
+				}
+
+				inline bool empty() const
+				{
+					return count == 0;
+				}
+
+				inline iterator begin() const
+				{
+					return iterator(runs.data(), runs.data() + runs.size());
+				}
+
+				inline iterator end() const
+				{
+					return iterator(runs.data() + runs.size(), runs.data() + runs.size());
+				}
+			};
+		}
+	}
+}
@@ -0,0 +1,422 @@
+#pragma once
+
+#include <atomic>
+#include <bitset>
+#include <limits>
+#include <type_traits>
+
+#include "../../bitops.h"
+
+namespace cppu
+{
+	namespace cgc
+	{
+		namespace details
+		{
+			// Size tag for arrays that hold more slots than the largest integer type has bits
+			template<size_t _Bits>
+			struct wide_bits
+			{
+				static_assert(_Bits % 64 == 0 && _Bits >= 128 && _Bits <= 4096, "wide_bits supports 128 up to 4096 bits in steps of 64");
+			};
+
+			// Read-modify-write operations on mask words, the non atomic version does a plain load and store (no locked instructions)
+			template<bool _Atomic>
+			struct mask_ops
+			{
+				template<class T>
+				static inline T fetch_or(std::atomic<T>& a, T value) { return a.fetch_or(value); }
+
+				template<class T>
+				static inline T fetch_and(std::atomic<T>& a, T value) { return a.fetch_and(value); }
+
+				template<class T>
+				static inline bool compare_exchange(std::atomic<T>& a, T& expected, T desired) { return a.compare_exchange_weak(expected, desired); }
+			};
+
+			template<>
+			struct mask_ops<false>
+			{
+				template<class T>
+				static inline T fetch_or(std::atomic<T>& a, T value)
+				{
+					T old = a.load(std::memory_order_relaxed);
+					a.store(T(old | value), std::memory_order_relaxed);
+					return old;
+				}
+
+				template<class T>
+				static inline T fetch_and(std::atomic<T>& a, T value)
+				{
+					T old = a.load(std::memory_order_relaxed);
+					a.store(T(old & value), std::memory_order_relaxed);
+					return old;
+				}
+
+				// expected is always up to date with a single thread
+				template<class T>
+				static inline bool compare_exchange(std::atomic<T>& a, T&, T desired)
+				{
+					a.store(desired, std::memory_order_relaxed);
+					return true;
+				}
+			};
+
+			// the lowest `count` set bits of value
+			inline uint64 lowest_bits(uint64 value, size_t count)
+			{
+				if (std::bitset<64>(value).count() <= count)
+					return value;
+
+				uint64 taken = 0;
+				for (; count > 0; --count)
+				{
+					taken |= value & (~value + 1);
+					value &= value - 1;
+				}
+
+				return taken;
+			}
+
+			// Atomic bit per slot, lock free, all operations are safe to call concurrently.
+			// Batches work per word (see word_count), a whole word of bits is changed with one atomic operation.
+			// With _Atomic = false it's meant for a single thread (see thread_policy::local), same layout but plain loads and stores.
+			template<class S, bool _Atomic = true>
+			class slot_mask
+			{
+			private:
+				typedef mask_ops<_Atomic> ops;
+
+				// smaller types are scanned as 32 bit values
+				typedef std::conditional_t<(std::numeric_limits<S>::digits > 32), uint64, uint32> scan_t;
+
+				std::atomic<S> bits;
+
+			public:
+				static constexpr size_t digits = std::numeric_limits<S>::digits;
+				static constexpr size_t npos = digits;
+				static constexpr size_t word_count = 1;
+
+				slot_mask(bool full)
+					: bits(full ? S(~S(0)) : S(0))
+				{ }
+
+				// claim up to `count` set bits with one CAS, claimed(word, bits) receives them, returns the amount claimed
+				template<class _Func>
+				inline size_t reserve_many(size_t count, _Func&& claimed)
+				{
+					S check = bits.load();
+					while (check != 0 && count != 0)
+					{
+						const S taken = S(lowest_bits(uint64(check), count));
+						if (ops::compare_exchange(bits, check, S(check & ~taken)))
+						{
+							claimed(size_t(0), uint64(taken));
+							return std::bitset<digits>(taken).count();
+						}
+					}
+
+					return 0;
+				}
+
+				// returns true if no bit was set before, like set()
+				inline bool set_word(size_t, uint64 value)
+				{
+					return ops::fetch_or(bits, S(value)) == 0;
+				}
+
+				// returns the bits this call cleared
+				inline uint64 reset_word(size_t, uint64 value)
+				{
+					return uint64(ops::fetch_and(bits, S(~S(value)))) & value;
+				}
+
+				inline uint64 load_word(size_t) const
+				{
+					return uint64(bits.load());
+				}
+
+				// claim the first set bit by clearing it, returns npos if there's none
+				inline size_t reserve()
+				{
+					S check = bits.load();
+					size_t spot;
+
+					// a failed CAS (spurious ones included) stores nothing and reloads check, so retry on every failure
+					while ((spot = bs_rtol(check)) < npos)
+					{
+						if (ops::compare_exchange(bits, check, S(check & ~(S(1) << spot))))
+							return spot;
+					}
+
+					return npos;
+				}
+
+				// returns true if no bit was set before
+				inline bool set(size_t pos)
+				{
+					return ops::fetch_or(bits, S(S(1) << pos)) == 0;
+				}
+
+				// returns true if this call cleared the bit
+				inline bool reset(size_t pos)
+				{
+					return (ops::fetch_and(bits, S(~(S(1) << pos))) >> pos) & 1;
+				}
+
+				inline bool test(size_t pos) const
+				{
+					return (bits.load() >> pos) & 1;
+				}
+
+				inline bool empty() const
+				{
+					return bits.load() == 0;
+				}
+
+				inline size_t count() const
+				{
+					return std::bitset<digits>(bits.load()).count();
+				}
+
+				inline S load() const
+				{
+					return bits.load();
+				}
+
+				// first set bit at or after pos
+				inline size_t next(size_t pos) const
+				{
+					size_t index = bs_rtol(bits.load(), uint(pos));
+					return index < digits ? index : npos;
+				}
+
+				// last set bit at or before pos
+				inline size_t prev(size_t pos) const
+				{
+					if (pos >= digits)
+						return npos;
+
+					scan_t value = scan_t(bits.load()) & (scan_t(~scan_t(0)) >> (std::numeric_limits<scan_t>::digits - 1 - pos));
+					size_t zeros = bs_ltor(value);
+					return zeros < std::numeric_limits<scan_t>::digits ? std::numeric_limits<scan_t>::digits - 1 - zeros : npos;
+				}
+
+				inline size_t front() const
+				{
+					return next(0);
+				}
+
+				inline size_t back() const
+				{
+					return prev(digits - 1);
+				}
+			};
+
+			// Array of 64 bit words plus a summary word of non-empty words, so any lookup is two bit scans.
+			// The summary is a hint while being modified (same rules as free_bitmap), exact once all threads are done.
+			template<size_t _Bits, bool _Atomic>
+			class slot_mask<wide_bits<_Bits>, _Atomic>
+			{
+			private:
+				typedef mask_ops<_Atomic> ops;
+
+				static constexpr size_t word_bits = std::numeric_limits<uint64>::digits;
+
+				std::atomic<uint64> summary;
+				std::atomic<uint64> words[_Bits / word_bits];
+
+				inline void mark(size_t word)
+				{
+					ops::fetch_or(summary, uint64(1) << word);
+				}
+
+				inline void unmark(size_t word)
+				{
+					ops::fetch_and(summary, ~(uint64(1) << word));
+
+					// a concurrent set() may have filled the word in the mean time
+					if (words[word].load() != 0)
+						ops::fetch_or(summary, uint64(1) << word);
+				}
+
+			public:
+				static constexpr size_t digits = _Bits;
+				static constexpr size_t npos = digits;
+				static constexpr size_t word_count = _Bits / word_bits;
+
+				slot_mask(bool full)
+					: summary(full ? (word_count == word_bits ? ~uint64(0) : (uint64(1) << word_count) - 1) : 0)
+				{
+					for (size_t i = 0; i < word_count; ++i)
+						words[i].store(full ? ~uint64(0) : 0, std::memory_order_relaxed);
+				}
+
+				inline size_t reserve()
+				{
+					size_t w;
+					while ((w = bs_rtol(summary.load())) < word_count)
+					{
+						uint64 word = words[w].load();
+						while (word != 0)
+						{
+							const uint64 bit = uint64(1) << bs_rtol(word);
+							if (ops::compare_exchange(words[w], word, word & ~bit))
+							{
+								if (word == bit)
+									unmark(w);
+
+								return w * word_bits + bs_rtol(bit);
+							}
+						}
+
+						// word got emptied by another thread
+						unmark(w);
+					}
+
+					return npos;
+				}
+
+				// one CAS per word it takes bits from
+				template<class _Func>
+				inline size_t reserve_many(size_t count, _Func&& claimed)
+				{
+					size_t total = 0;
+					size_t w;
+					while (total < count && (w = bs_rtol(summary.load())) < word_count)
+					{
+						uint64 word = words[w].load();
+						while (word != 0)
+						{
+							const uint64 taken = lowest_bits(word, count - total);
+							if (ops::compare_exchange(words[w], word, word & ~taken))
+							{
+								if (word == taken)
+									unmark(w);
+
+								claimed(w, taken);
+								total += std::bitset<word_bits>(taken).count();
+								break;
+							}
+						}
+
+						if (word == 0)
+							unmark(w);
+					}
+
+					return total;
+				}
+
+				inline bool set_word(size_t w, uint64 value)
+				{
+					if (ops::fetch_or(words[w], value) == 0)
+						return ops::fetch_or(summary, uint64(1) << w) == 0;
+
+					return false;
+				}
+
+				inline uint64 reset_word(size_t w, uint64 value)
+				{
+					const uint64 old = ops::fetch_and(words[w], ~value);
+					if ((old & ~value) == 0 && old != 0)
+						unmark(w);
+
+					return old & value;
+				}
+
+				inline uint64 load_word(size_t w) const
+				{
+					return words[w].load();
+				}
+
+				inline bool set(size_t pos)
+				{
+					const size_t w = pos / word_bits;
+					if (ops::fetch_or(words[w], uint64(1) << (pos % word_bits)) == 0)
+						return ops::fetch_or(summary, uint64(1) << w) == 0;
+
+					return false;
+				}
+
+				inline bool reset(size_t pos)
+				{
+					const size_t w = pos / word_bits;
+					const uint64 bit = uint64(1) << (pos % word_bits);
+					const uint64 old = ops::fetch_and(words[w], ~bit);
+					if (old == bit)
+						unmark(w);
+
+					return (old & bit) != 0;
+				}
+
+				inline bool test(size_t pos) const
+				{
+					return (words[pos / word_bits].load() >> (pos % word_bits)) & 1;
+				}
+
+				inline bool empty() const
+				{
+					return summary.load() == 0;
+				}
+
+				inline size_t count() const
+				{
+					size_t total = 0;
+					for (size_t i = 0; i < word_count; ++i)
+						total += std::bitset<word_bits>(words[i].load()).count();
+
+					return total;
+				}
+
+				inline size_t next(size_t pos) const
+				{
+					if (pos >= digits)
+						return npos;
+
+					size_t w = pos / word_bits;
+					size_t index = bs_rtol(words[w].load(), uint(pos % word_bits));
+					if (index < word_bits)
+						return w * word_bits + index;
+
+					while ((w = bs_rtol(summary.load(), uint(w + 1))) < word_count)
+					{
+						index = bs_rtol(words[w].load());
+						if (index < word_bits)
+							return w * word_bits + index;
+					}
+
+					return npos;
+				}
+
+				inline size_t prev(size_t pos) const
+				{
+					if (pos >= digits)
+						return npos;
+
+					for (size_t w = pos / word_bits + 1; w-- > 0;)
+					{
+						uint64 word = words[w].load();
+						if (w == pos / word_bits)
+							word &= ~uint64(0) >> (word_bits - 1 - pos % word_bits);
+
+						size_t zeros = bs_ltor(word);
+						if (zeros < word_bits)
+							return w * word_bits + word_bits - 1 - zeros;
+					}
+
+					return npos;
+				}
+
+				inline size_t front() const
+				{
+					return next(0);
+				}
+
+				inline size_t back() const
+				{
+					return prev(digits - 1);
+				}
+			};
+		}
+	}
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+#include "../../bitops.h"
+#include "../../dtypes.h"
+
+// Define to count emplaces / releases per container and time the garbage cleaner, costs a relaxed increment per object.
+// Without it the counters are empty and only the values read from the containers' masks (live, free, garbage, blocks) are filled in.
+//#define CPPU_CGC_STATS
+
+// Trace hooks, define both before including cgc headers to feed begin/end events into a tracer:
+//   #define CPPU_CGC_TRACE_BEGIN(name, container) my_tracer::begin(name)
+//   #define CPPU_CGC_TRACE_END(name, container) my_tracer::end(name)
+// name is a string literal ("cgc::clean_garbage", "cgc::cleaner_visit", "cgc::compact"), container the icontainer* or m_array*.
+#ifndef CPPU_CGC_TRACE_BEGIN
+#define CPPU_CGC_TRACE_BEGIN(name, container) ((void)0)
+#endif
+
+#ifndef CPPU_CGC_TRACE_END
+#define CPPU_CGC_TRACE_END(name, container) ((void)0)
+#endif
+
+// Container Garbage Collection
+
+namespace cppu
+{
+	namespace cgc
+	{
+		// snapshot of a container, emplaced and released are totals since construction (0 without CPPU_CGC_STATS)
+		struct container_stats
+		{
+			size_t live = 0;
+			size_t free = 0;
+			size_t garbage = 0;
+			size_t blocks = 0;
+			uint64 emplaced = 0;
+			uint64 released = 0;
+			// steady clock, nanoseconds, two snapshots give the rates
+			uint64 time = 0;
+		};
+
+		// snapshot of the garbage cleaner, latencies of clean_garbage() calls made by cleaner threads
+		struct cleaner_stats
+		{
+			// bucket i counts calls that took [2^i, 2^(i+1)) nanoseconds, the last one everything longer
+			static constexpr size_t buckets = 32;
+
+			size_t queued = 0;
+			uint64 visits = 0;
+			uint64 cleaned = 0;
+			uint64 totalNanoseconds = 0;
+			uint64 maxNanoseconds = 0;
+			uint64 histogram[buckets] = {};
+			uint64 time = 0;
+		};
+
+		namespace details
+		{
+			inline uint64 stats_now()
+			{
+				return uint64(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+			}
+
+			// emplace / release totals of a container, plain for thread_policy::local
+			template<bool _Atomic = true>
+			struct stat_counters
+			{
+#ifdef CPPU_CGC_STATS
+				std::atomic<uint64> emplaced = 0;
+				std::atomic<uint64> released = 0;
+
+				stat_counters() = default;
+
+				// copies of a container start with the same totals
+				stat_counters(const stat_counters& other)
+					: emplaced(other.emplaced.load(std::memory_order_relaxed))
+					, released(other.released.load(std::memory_order_relaxed))
+				{ }
+
+				stat_counters& operator=(const stat_counters& other)
+				{
+					emplaced.store(other.emplaced.load(std::memory_order_relaxed), std::memory_order_relaxed);
+					released.store(other.released.load(std::memory_order_relaxed), std::memory_order_relaxed);
+					return *this;
+				}
+
+				inline void add_emplaced(uint64 n) { emplaced.fetch_add(n, std::memory_order_relaxed); }
+				inline void add_released(uint64 n) { released.fetch_add(n, std::memory_order_relaxed); }
+
+				inline void fill(container_stats& s) const
+				{
+					s.emplaced += emplaced.load(std::memory_order_relaxed);
+					s.released += released.load(std::memory_order_relaxed);
+				}
+#else
+				inline void add_emplaced(uint64) { }
+				inline void add_released(uint64) { }
+				inline void fill(container_stats&) const { }
+#endif
+			};
+
+#ifdef CPPU_CGC_STATS
+			template<>
+			struct stat_counters<false>
+			{
+				uint64 emplaced = 0;
+				uint64 released = 0;
+
+				inline void add_emplaced(uint64 n) { emplaced += n; }
+				inline void add_released(uint64 n) { released += n; }
+
+				inline void fill(container_stats& s) const
+				{
+					s.emplaced += emplaced;
+					s.released += released;
+				}
+			};
+#endif
+
+			// cleaner visit latencies, one relaxed increment per visit
+			class latency_histogram
+			{
+			private:
+				std::atomic<uint64> counts[cleaner_stats::buckets] = {};
+				std::atomic<uint64> visits = 0;
+				std::atomic<uint64> cleaned = 0;
+				std::atomic<uint64> total = 0;
+				std::atomic<uint64> max = 0;
+
+			public:
+				inline void record(uint64 nanoseconds, size_t objects)
+				{
+					// bsr() counts the leading zeros
+					const size_t bucket = nanoseconds == 0 ? 0 : 63 - bsr(nanoseconds);
+					counts[bucket < cleaner_stats::buckets ? bucket : cleaner_stats::buckets - 1].fetch_add(1, std::memory_order_relaxed);
+					visits.fetch_add(1, std::memory_order_relaxed);
+					cleaned.fetch_add(objects, std::memory_order_relaxed);
+					total.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+					uint64 current = max.load(std::memory_order_relaxed);
+					while (current < nanoseconds && !max.compare_exchange_weak(current, nanoseconds, std::memory_order_relaxed));
+				}
+
+				inline void fill(cleaner_stats& s) const
+				{
+					for (size_t i = 0; i < cleaner_stats::buckets; ++i)
+						s.histogram[i] = counts[i].load(std::memory_order_relaxed);
+
+					s.visits = visits.load(std::memory_order_relaxed);
+					s.cleaned = cleaned.load(std::memory_order_relaxed);
+					s.totalNanoseconds = total.load(std::memory_order_relaxed);
+					s.maxNanoseconds = max.load(std::memory_order_relaxed);
+				}
+			};
+
+			// calls the trace hooks around a scope
+			struct trace_scope
+			{
+				const char* name;
+				const void* container;
+
+				trace_scope(const char* name, const void* container)
+					: name(name)
+					, container(container)
+				{
+					CPPU_CGC_TRACE_BEGIN(name, container);
+				}
+
+				~trace_scope()
+				{
+					CPPU_CGC_TRACE_END(name, container);
+				}
+			};
+		}
+	}
+}
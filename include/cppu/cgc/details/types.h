@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+
 namespace cppu
 {
 	namespace cgc
@@ -8,7 +10,74 @@ namespace cppu
 		{
 			DIRECT = 0,
 			MANUAL = 1,
-			THREAD = 2
+			THREAD = 2,
+			EPOCH = 3 // destructs once no epoch_guard can see the object anymore, see clean_garbage(). Arrays and sharded maps only
 		};
+
+		namespace thread_policy
+		{
+			// reference counts and slot masks use atomic operations, the container may be used from any thread
+			struct shared
+			{
+				static constexpr bool atomic = true;
+				static constexpr size_t homes = 1;
+			};
+
+			// the container and the pointers to its objects are only used by the thread that created it,
+			// plain loads and stores instead of locked instructions (asserted in debug builds), its pointers are strong_ptr<T, false>
+			struct local
+			{
+				static constexpr bool atomic = false;
+				static constexpr size_t homes = 1;
+			};
+
+			// shared, but m_array keeps a list of blocks per thread (threads are spread round robin over the Threads lists),
+			// emplace() only fills blocks of the calling thread's list and new blocks are first touched by that thread
+			template<size_t Threads = 8>
+			struct per_thread
+			{
+				static_assert(Threads != 0, "per_thread needs at least 1 block list");
+				static constexpr bool atomic = true;
+				static constexpr size_t homes = Threads;
+			};
+
+			// shared, but m_array keeps a list of blocks per NUMA node (nodes past Nodes wrap around),
+			// emplace() fills blocks of the node the calling thread runs on, see details::current_home()
+			template<size_t Nodes = 2>
+			struct numa
+			{
+				static_assert(Nodes != 0, "numa needs at least 1 block list");
+				static constexpr bool atomic = true;
+				static constexpr size_t homes = Nodes;
+			};
+		}
+
+		// pointers to objects of thread_policy::local containers use non atomic counts, resolved at compile time
+		template<class T, bool _Atomic = true> class strong_ptr;
+		template<class T, bool _Atomic = true> class weak_ptr;
+
+		namespace map_backend
+		{
+			// std::unordered_map, one allocated node (and key_counter) per element
+			struct node
+			{
+				static constexpr bool concurrent = false;
+			};
+
+			// open addressing table with stable slots, counters stored inline, see details::flat_table
+			struct flat
+			{
+				static constexpr bool concurrent = false;
+			};
+
+			// flat tables in lock striped shards (Shards is a power of 2), emplace, get, erase and cleaning may run on any thread
+			template<size_t Shards = 16>
+			struct sharded
+			{
+				static_assert(Shards != 0 && (Shards & (Shards - 1)) == 0, "shard count should be a power of 2");
+				static constexpr size_t shards = Shards;
+				static constexpr bool concurrent = true;
+			};
+		}
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <type_traits>
+
+#include "constructor.h"
+#include "../dtypes.h"
+
+// Container Garbage Collection
+
+namespace cppu
+{
+	namespace cgc
+	{
+		// Arrays only count slot generations for element types that opt in (4 bytes per slot and a store per released object):
+		//   template<> struct cgc::uses_handles<Transform> : std::true_type {};
+		template<class T>
+		struct uses_handles : std::false_type {};
+
+		template<class T>
+		inline constexpr bool uses_handles_v = uses_handles<T>::value;
+
+		// Non owning reference to an object of a cgc::array or m_array, 64 bits: slot generation, block index and slot.
+		// Every slot counts the objects that died in it, a handle to an object that's gone resolves to nullptr.
+		// Copying or resolving one touches no reference count, share() gives a strong_ptr when ownership is needed.
+		// Only for element types with cgc::uses_handles set.
+		template<class T>
+		class handle
+		{
+			template<typename, typename, CLEAN_PROC, typename> friend class array;
+			template<typename, typename, CLEAN_PROC, typename> friend class m_array;
+
+		public:
+			static constexpr uint64 slot_bits = 12;
+			static constexpr uint64 block_bits = 20;
+
+		private:
+			// generations start at 1, 0 is the null handle
+			uint64 value = 0;
+
+			handle(size_t block, size_t slot, uint32 generation)
+				: value((uint64(generation) << 32) | (uint64(block) << slot_bits) | uint64(slot))
+			{ }
+
+		public:
+			handle() = default;
+
+			inline size_t slot() const
+			{
+				return size_t(value & ((uint64(1) << slot_bits) - 1));
+			}
+
+			inline size_t block() const
+			{
+				return size_t((value >> slot_bits) & ((uint64(1) << block_bits) - 1));
+			}
+
+			inline uint32 generation() const
+			{
+				return uint32(value >> 32);
+			}
+
+			// for storing a handle elsewhere (components, network ids), from_raw() gives it back
+			inline uint64 raw() const
+			{
+				return value;
+			}
+
+			static inline handle from_raw(uint64 raw)
+			{
+				handle h;
+				h.value = raw;
+				return h;
+			}
+
+			explicit operator bool() const
+			{
+				return value != 0;
+			}
+
+			bool operator==(const handle& other) const
+			{
+				return value == other.value;
+			}
+
+			bool operator!=(const handle& other) const
+			{
+				return value != other.value;
+			}
+		};
+
+		namespace details
+		{
+			// objects that died per slot, handles carry the value of the object they were made for
+			template<size_t N, bool _Atomic>
+			struct slot_generations
+			{
+				std::atomic<uint32> values[N];
+
+				slot_generations()
+				{
+					for (size_t i = 0; i < N; ++i)
+						values[i].store(1, std::memory_order_relaxed);
+				}
+
+				inline uint32 load(size_t slot, std::memory_order order = std::memory_order_seq_cst) const
+				{
+					return values[slot].load(order);
+				}
+
+				// only the thread releasing the object in this slot gets here, so no read-modify-write is needed,
+				// the count skips 0 when it wraps (the null handle)
+				inline void end(size_t slot)
+				{
+					uint32 next = values[slot].load(std::memory_order_relaxed) + 1;
+					if (next == 0)
+						next = 1;
+
+					values[slot].store(next, _Atomic ? std::memory_order_release : std::memory_order_relaxed);
+				}
+			};
+
+			// element types without cgc::uses_handles
+			struct no_generations
+			{
+				inline void end(size_t) { }
+			};
+		}
+	}
+}
+
+namespace std
+{
+	template<class T>
+	struct hash<cppu::cgc::handle<T>>
+	{
+		size_t operator()(const cppu::cgc::handle<T>& h) const
+		{
+			return hash<uint64>()(h.raw());
+		}
+	};
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <algorithm>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+#ifdef WIN32
+#include "windows.h"
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include "../dtypes.h"
+
+// Container Garbage Collection
+
+namespace cppu
+{
+	namespace cgc
+	{
+		// Memory resource for large pools (pass it to m_array, unordered_map, ...): memory comes from 2MB aligned regions the OS is
+		// asked to back with huge pages, madvise(MADV_HUGEPAGE) on Linux and large pages on Windows (when the process may lock pages).
+		// Requests of half a region or more get a mapping of their own and are unmapped on release, smaller ones are cut from shared
+		// regions and reused for requests of the same size, those regions only go back to the OS when the resource is destroyed.
+		// Thread safe, has to outlive the containers using it.
+		class huge_page_resource : public std::pmr::memory_resource
+		{
+		public:
+			static constexpr size_t region_size = size_t(2) << 20;
+
+		private:
+			std::mutex lock;
+			std::vector<void*> regions;
+			std::unordered_map<uint64, std::vector<void*>> reusable;
+			char* cursor = nullptr;
+			size_t remaining = 0;
+
+			static inline size_t round_up(size_t value, size_t multiple)
+			{
+				return (value + multiple - 1) / multiple * multiple;
+			}
+
+			// size is a multiple of region_size
+			static void* map(size_t size)
+			{
+#ifdef WIN32
+				const size_t large = GetLargePageMinimum();
+				if (large != 0 && size % large == 0)
+				{
+					if (void* memory = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE))
+						return memory;
+				}
+
+				void* memory = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+				if (memory == nullptr)
+					throw std::bad_alloc();
+
+				return memory;
+#elif defined(__linux__)
+				// over allocate by a region and trim, so the mapping starts on a huge page boundary
+				void* raw = mmap(nullptr, size + region_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+				if (raw == MAP_FAILED)
+					throw std::bad_alloc();
+
+				const uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+				const uintptr_t aligned = round_up(start, region_size);
+				if (aligned != start)
+					munmap(raw, aligned - start);
+
+				if (region_size - (aligned - start) != 0)
+					munmap(reinterpret_cast<void*>(aligned + size), region_size - (aligned - start));
+
+				madvise(reinterpret_cast<void*>(aligned), size, MADV_HUGEPAGE);
+				return reinterpret_cast<void*>(aligned);
+#else
+				return ::operator new(size, std::align_val_t(region_size));
+#endif
+			}
+
+			static void unmap(void* memory, size_t size)
+			{
+#ifdef WIN32
+				VirtualFree(memory, 0, MEM_RELEASE);
+#elif defined(__linux__)
+				munmap(memory, size);
+#else
+				::operator delete(memory, std::align_val_t(region_size));
+#endif
+			}
+
+			static inline uint64 key_of(size_t bytes, size_t alignment)
+			{
+				return (uint64(bytes) << 16) | uint64(alignment);
+			}
+
+		protected:
+			void* do_allocate(size_t bytes, size_t alignment) override
+			{
+				if (alignment > region_size)
+					throw std::bad_alloc();
+
+				bytes = std::max<size_t>(bytes, 1);
+				if (bytes >= region_size / 2)
+					return map(round_up(bytes, region_size));
+
+				std::lock_guard<std::mutex> lk(lock);
+
+				auto it = reusable.find(key_of(bytes, alignment));
+				if (it != reusable.end() && !it->second.empty())
+				{
+					void* memory = it->second.back();
+					it->second.pop_back();
+					return memory;
+				}
+
+				size_t padding = round_up(reinterpret_cast<uintptr_t>(cursor), alignment) - reinterpret_cast<uintptr_t>(cursor);
+				if (cursor == nullptr || padding + bytes > remaining)
+				{
+					// the rest of the current region is left unused
+					cursor = static_cast<char*>(map(region_size));
+					remaining = region_size;
+					padding = 0;
+					regions.push_back(cursor);
+				}
+
+				void* memory = cursor + padding;
+				cursor += padding + bytes;
+				remaining -= padding + bytes;
+				return memory;
+			}
+
+			void do_deallocate(void* memory, size_t bytes, size_t alignment) override
+			{
+				bytes = std::max<size_t>(bytes, 1);
+				if (bytes >= region_size / 2)
+				{
+					unmap(memory, round_up(bytes, region_size));
+					return;
+				}
+
+				std::lock_guard<std::mutex> lk(lock);
+				reusable[key_of(bytes, alignment)].push_back(memory);
+			}
+
+			bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+			{
+				return this == &other;
+			}
+
+		public:
+			huge_page_resource() = default;
+
+			huge_page_resource(const huge_page_resource&) = delete;
+			huge_page_resource& operator=(const huge_page_resource&) = delete;
+
+			~huge_page_resource()
+			{
+				for (void* region : regions)
+					unmap(region, region_size);
+			}
+
+			// shared regions mapped so far
+			size_t region_count()
+			{
+				std::lock_guard<std::mutex> lk(lock);
+				return regions.size();
+			}
+		};
+	}
+}
@@ -1,97 +1,173 @@
 #pragma once
 
 #include <mutex>
+#include <stdexcept>
 
 #include "../misc/move_by_copy_t.h"
 #include "array.h"
+#include "details/block_directory.h"
+#include "details/placement.h"
+#include "details/memory_resource.h"
 
 namespace cppu
 {
 	namespace cgc
 	{
+		// Growing is lock-free for readers, emplacing and iterating can be done while other threads add arrays.
 		// Don't destruct this container when any thread is still accessing it, e.g: emplace()
-		template<class T, class S = SIZE_32, CLEAN_PROC clean_proc = CLEAN_PROC::DIRECT>
+		template<class T, class S = SIZE_32, CLEAN_PROC clean_proc = CLEAN_PROC::DIRECT, class policy = thread_policy::shared>
 		class m_array
 		{
+			static_assert(details::free_bitmap::capacity() <= (size_t(1) << handle<T>::block_bits), "block index doesn't fit in a handle");
+
+		public:
+			typedef details::block_directory<cgc::array<T, S, clean_proc, policy>, details::free_bitmap::capacity()> directory;
+			typedef typename cgc::array<T, S, clean_proc, policy>::batch batch;
+			typedef typename cgc::array<T, S, clean_proc, policy>::chunk chunk;
+
 		private:
-			std::vector<cgc::array<T, S, clean_proc>*> arrays;
+			// blocks (and relocatable<T> objects) are allocated from here
+			std::pmr::memory_resource* resource;
+
+			// relocatable<T> objects of all arrays, declared first so it outlives them
+			typename details::relocation_pool_of<T>::type objects;
+
+			directory arrays;
+			// blocks with free slots, one list per home (thread or node) of the thread policy, blocks belong to the home that added them
+			details::free_bitmap available[policy::homes];
 			move_by_copy_t<std::mutex> lock;
 
+			// expects to be locked (or constructing), allocated and first touched by the calling thread
+			cgc::array<T, S, clean_proc, policy>* add_array(std::size_t home = 0)
+			{
+				std::size_t index = arrays.size();
+				if (index >= directory::capacity())
+					throw std::length_error("cgc::m_array: maximum amount of arrays reached");
+
+				cgc::array<T, S, clean_proc, policy>* arr = details::resource_new<cgc::array<T, S, clean_proc, policy>>(resource);
+				arr->freeBitmap = available + home;
+				arr->blockIndex = index;
+				if constexpr (details::is_relocatable<T>::value)
+					arr->use_pool(&objects);
+
+				available[home].reserve(index);
+				arrays.push_back(arr);
+				available[home].set(index);
+
+				return arr;
+			}
+
+			// same search as emplace(), but every array that's picked gets filled with as much of the batch as it can take
+			template<class _Construct>
+			void emplace_runs(batch& result, std::size_t count, _Construct&& construct)
+			{
+				const std::size_t home = details::current_home<policy>();
+				details::free_bitmap& candidates = available[home];
+				while (count > 0)
+				{
+					std::size_t i;
+					while (count > 0 && (i = candidates.find()) != details::free_bitmap::npos)
+					{
+						cgc::array<T, S, clean_proc, policy>* container = arrays[i];
+						count -= container->emplace_runs(result, count, construct);
+
+						// array is full, remove it from the candidates (unless a slot got freed in the mean time)
+						if (count > 0)
+							candidates.clear(i, [container]() { return container->has_free(); });
+					}
+
+					if (count == 0)
+						return;
+
+					// no suitable spot found in current arrays, build a new one (unless another thread did already),
+					// it gets filled outside of the lock by the loop above
+					std::unique_lock<std::mutex> lk(lock);
+					if (candidates.find() == details::free_bitmap::npos)
+						add_array(home);
+				}
+			}
+
 		public:
 			struct iterator
 			{
-				template<class, class, CLEAN_PROC> friend class cgc::m_array;
+				template<class, class, CLEAN_PROC, class> friend class cgc::m_array;
 
-				using iterator_category = std::random_access_iterator_tag;
+				using iterator_category = std::bidirectional_iterator_tag;
 				using difference_type = std::ptrdiff_t;
 				using value_type = T;
 				using pointer = T*;
 				using reference = T&;
 
 			private:
-				cgc::m_array<T, S, clean_proc>& m_arr;
-				typename cgc::array<T, S, clean_proc>::iterator it;
+				static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+				cgc::m_array<T, S, clean_proc, policy>* m_arr;
+				std::size_t block;
+				typename cgc::array<T, S, clean_proc, policy>::iterator it;
 
-				iterator(cgc::m_array<T, S, clean_proc>& m_arr, typename cgc::array<T, S, clean_proc>::iterator it)
+				iterator(cgc::m_array<T, S, clean_proc, policy>* m_arr, std::size_t block, typename cgc::array<T, S, clean_proc, policy>::iterator it)
 					: m_arr(m_arr)
+					, block(block)
 					, it(it)
 				{ }
 
+				// skip empty arrays, arrays added while iterating are picked up as well
+				void seek_forward()
+				{
+					while (it.offset == cgc::array<T, S, clean_proc, policy>::npos)
+					{
+						if (++block >= m_arr->arrays.size())
+						{
+							block = npos;
+							return;
+						}
+
+						it.arr = m_arr->arrays[block];
+						it.offset = it.arr->front_index();
+					}
+				}
+
 			public:
 				iterator(const iterator& it)
 					: m_arr(it.m_arr)
+					, block(it.block)
 					, it(it.it)
 				{ }
 
-				/*iterator operator+(size_t offset)
+				iterator& operator=(const iterator& it)
 				{
-					return { m_arr, it + offset };
-				}
-
-				iterator& operator+=(size_t offset)
-				{
-					it += offset;
+					m_arr = it.m_arr;
+					block = it.block;
+					this->it = it.it;
 					return *this;
-				}*/
+				}
 
 				iterator& operator++()
 				{
 					++it;
-
-					while (it.offset == cgc::array<T, S, clean_proc>::npos && it.arr != m_arr.arrays.back())
-					{
-						++it.arr;
-						it.offset = it.arr->front_index();
-					}
+					seek_forward();
 
 					return *this;
 				}
 
 				iterator operator++(int)
 				{
-					auto cpy = it;
+					iterator cpy = *this;
 					this->operator++();
-					return { m_arr, cpy };
+					return cpy;
 				}
 
-				/*iterator operator-(size_t offset)
-				{
-					return { m_arr, it - offset };
-				}
-
-				iterator& operator-=(size_t offset)
-				{
-					it -= offset;
-					return *this;
-				}*/
-
 				iterator& operator--()
 				{
-					--it;
+					if (block == npos)
+						block = m_arr->arrays.size();
+					else
+						--it;
 
-					while (it.offset == cgc::array<T, S, clean_proc>::npos && it.arr != m_arr.arrays.front())
+					while ((block == m_arr->arrays.size() || it.offset == cgc::array<T, S, clean_proc, policy>::npos) && block > 0)
 					{
-						--it.arr;
+						--block;
+						it.arr = m_arr->arrays[block];
 						it.offset = it.arr->back_index();
 					}
 
@@ -100,22 +176,22 @@ namespace cppu
 
 				iterator operator--(int)
 				{
-					auto cpy = it;
+					iterator cpy = *this;
 					this->operator--();
-					return { m_arr, cpy };
+					return cpy;
 				}
 
-				bool operator==(const iterator& other)
+				bool operator==(const iterator& other) const
 				{
-					return it == other.it;
+					return block == other.block && (block == npos || it == other.it);
 				}
 
-				bool operator!=(const iterator& other)
+				bool operator!=(const iterator& other) const
 				{
-					return it != other.it;
+					return !operator==(other);
 				}
 
-				T* operator->()
+				T* operator->() const
 				{
 					return it.operator->();
 				}
@@ -126,57 +202,117 @@ namespace cppu
 				}
 			};
 
-			m_array()
+			explicit m_array(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+				: resource(resource)
+				, objects(resource)
 			{
-				cgc::array<T, S, clean_proc>* arr = new cgc::array<T, S, clean_proc>();
-				arrays.push_back(arr);
+				add_array();
 			}
 
 			~m_array()
 			{
 				lock.lock();
 
-				for (uint i = 0; i < arrays.size(); ++i)
+				for (std::size_t i = 0; i < arrays.size(); ++i)
 				{
-					cgc::array<T, S, clean_proc>* arr = arrays[i];
-					delete arr;
+					cgc::array<T, S, clean_proc, policy>* arr = arrays[i];
+					details::resource_delete(resource, arr);
 				}
 
 				lock.unlock();
 			}
 
 			template<class... _Args>
-			strong_ptr<T> emplace(_Args&&... arguments)
+			strong_ptr<T, policy::atomic> emplace(_Args&&... arguments)
 			{
-				cgc::array<T, S, clean_proc>* container = nullptr;
-				uint i = 0;
+				cgc::array<T, S, clean_proc, policy>* container = nullptr;
+				std::size_t slot;
+
+				// only blocks of the calling thread's home are candidates
+				const std::size_t home = details::current_home<policy>();
+				details::free_bitmap& candidates = available[home];
 
 			RETRY_EMPLACE:
-				std::size_t size = arrays.size();
-				for (; i < size; ++i)
+				// pick any array with free slots, a few bit scans instead of walking all arrays
+				std::size_t i;
+				while ((i = candidates.find()) != details::free_bitmap::npos)
 				{
-					uint slot = arrays[i]->reserve_spot();
-					if (slot != cgc::array<T, S, clean_proc>::npos)
-						return arrays[i]->emplace_at(slot, std::forward<_Args>(arguments)...);
+					container = arrays[i];
+					slot = container->reserve_spot();
+					if (slot != cgc::array<T, S, clean_proc, policy>::npos)
+						return container->emplace_at(slot, std::forward<_Args>(arguments)...);
+
+					// array is full, remove it from the candidates (unless a slot got freed in the mean time)
+					candidates.clear(i, [container]() { return container->has_free(); });
 				}
 
-				lock.lock();
+				std::unique_lock<std::mutex> lk(lock);
 
 				// another thread might've created a new array already, retry
-				if (size < arrays.size())
+				if (candidates.find() != details::free_bitmap::npos)
 				{
-					lock.unlock();
+					lk.unlock();
 					goto RETRY_EMPLACE;
 				}
 
 				// no suitable spot found in current arrays, build a new one
-				container = new cgc::array<T, S, clean_proc>();
-				arrays.push_back(container);
+				container = add_array(home);
+				slot = container->reserve_spot();
 
-				lock.unlock();
+				lk.unlock();
+
+				// the new array is visible as soon as it's added, other threads may have filled it already
+				if (slot == cgc::array<T, S, clean_proc, policy>::npos)
+					goto RETRY_EMPLACE;
 
 				// Return object
-				return container->emplace(std::forward<_Args>(arguments)...);
+				return container->emplace_at(slot, std::forward<_Args>(arguments)...);
+			}
+
+			// count objects constructed from the same arguments, spread over as few arrays as possible
+			template<class... _Args>
+			batch emplace_n(std::size_t count, const _Args&... arguments)
+			{
+				batch result;
+				emplace_runs(result, count, [&](cgc::array<T, S, clean_proc, policy>& arr, std::size_t slot) { arr.construct_object_at(slot, arguments...); });
+				return result;
+			}
+
+			// an object per element, constructed from *it
+			template<class _It>
+			batch emplace_range(_It first, _It last)
+			{
+				batch result;
+				emplace_runs(result, std::size_t(std::distance(first, last)), [&first](cgc::array<T, S, clean_proc, policy>& arr, std::size_t slot) { arr.construct_object_at(slot, *first++); });
+				return result;
+			}
+
+			// same as letting go of every object's strong_ptr, batch is empty afterwards
+			inline void release_all(batch& objects)
+			{
+				objects.release();
+			}
+
+			// handle to an object of this container, see cgc::handle
+			inline handle<T> handle_of(const strong_ptr<T, policy::atomic>& object) const
+			{
+				const details::base_counter* counter = constructor::counter_of(object);
+				if (counter == nullptr)
+					return {};
+
+				return static_cast<const cgc::array<T, S, clean_proc, policy>*>(counter->get_container())->handle_of(object);
+			}
+
+			// the object, or nullptr if it died, see array::get()
+			inline T* get(handle<T> h)
+			{
+				return h.block() < arrays.size() ? arrays[h.block()]->get(h) : nullptr;
+			}
+
+			// a strong_ptr to the object, empty if it died
+			inline strong_ptr<T, policy::atomic> share(handle<T> h)
+			{
+				return h.block() < arrays.size() ? arrays[h.block()]->share(h) : strong_ptr<T, policy::atomic>();
 			}
 
 			inline std::mutex& get_lock()
@@ -184,11 +320,17 @@ namespace cppu
 				return lock;
 			}
 
-			inline std::vector<cgc::array<T, S, clean_proc>*>& get_arrays()
+			inline directory& get_arrays()
 			{
 				return arrays;
 			}
 
+			// relocatable<T> only
+			inline typename details::relocation_pool_of<T>::type& get_objects()
+			{
+				return objects;
+			}
+
 			virtual uint clean_garbage(uint max = std::numeric_limits<uint>::max())
 			{
 				uint newMax = max;
@@ -227,14 +369,60 @@ namespace cppu
 				return true;
 			}
 
+			// summed over all blocks, see array::stats(). Blocks are read one after the other, not an atomic snapshot
+			container_stats stats()
+			{
+				container_stats s;
+				for (std::size_t i = 0; i < arrays.size(); ++i)
+					arrays[i]->fill_stats(s);
+
+				s.blocks = arrays.size();
+				s.time = details::stats_now();
+				return s;
+			}
+
+			// relocatable<T> only: packs up to max objects into the front of the object pool and frees the memory of emptied pool blocks,
+			// returns the amount moved (0 once dense), call it a few times per frame to spread the work.
+			// Handles stay put, no other thread may dereference them during the call.
+			// Only the pool shrinks: the slot blocks (arrays) are never freed before the m_array is destructed, emplace() and
+			// iteration read the block list without a lock and cgc::handle keeps block indices, so an emptied block stays allocated
+			// and gets filled again by later emplaces.
+			size_t compact(std::size_t max = std::numeric_limits<std::size_t>::max())
+			{
+				static_assert(details::is_relocatable<T>::value, "compact() needs cgc::relocatable<T> elements");
+				details::trace_scope trace("cgc::compact", this);
+				return objects.compact(max);
+			}
+
+			// fn(T&) for every object, see array::for_each()
+			template<class _Func>
+			void for_each(_Func&& fn)
+			{
+				for (std::size_t i = 0; i < arrays.size(); ++i)
+				{
+					if (!arrays[i]->empty())
+						arrays[i]->for_each(fn);
+				}
+			}
+
+			// fn(chunk&) for every array that holds objects, for loops over whole blocks (or columns with soa<T>)
+			template<class _Func>
+			void for_each_chunk(_Func&& fn)
+			{
+				for (std::size_t i = 0; i < arrays.size(); ++i)
+					arrays[i]->for_each_chunk(fn);
+			}
+
 			inline iterator begin()
 			{
-				return { *this, arrays.front()->begin() };
+				iterator it(this, 0, arrays.front()->begin());
+				it.seek_forward();
+				return it;
 			}
 
 			inline iterator end()
 			{
-				return { *this, arrays.back()->end() };
+				return { this, iterator::npos, arrays.front()->end() };
 			}
 		};
 	}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "m_array.h"
+#include "../exec/scheduler.h"
+
+// Container Garbage Collection
+
+namespace cppu
+{
+	namespace cgc
+	{
+		namespace details
+		{
+			// Block indices [begin, end) packed in one word, the owner takes from the front and thieves split off the back half
+			class alignas(64) steal_range
+			{
+			private:
+				std::atomic<uint64> packed;
+
+				static inline uint64 pack(uint64 begin, uint64 end) { return (begin << 32) | end; }
+
+			public:
+				steal_range()
+					: packed(0)
+				{ }
+
+				inline void assign(size_t begin, size_t end)
+				{
+					packed.store(pack(begin, end));
+				}
+
+				// next index of the owner, or false when the range is empty
+				inline bool take(size_t& index)
+				{
+					uint64 value = packed.load();
+					while ((value >> 32) < (value & 0xFFFFFFFF))
+					{
+						if (packed.compare_exchange_weak(value, value + (uint64(1) << 32)))
+						{
+							index = size_t(value >> 32);
+							return true;
+						}
+					}
+
+					return false;
+				}
+
+				// takes the back half (at least 1) off the victim
+				inline bool steal(size_t& begin, size_t& end)
+				{
+					uint64 value = packed.load();
+					uint64 b, e;
+					while ((b = value >> 32) < (e = value & 0xFFFFFFFF))
+					{
+						const uint64 mid = b + (e - b) / 2;
+						if (packed.compare_exchange_weak(value, pack(b, mid)))
+						{
+							begin = size_t(mid);
+							end = size_t(e);
+							return true;
+						}
+					}
+
+					return false;
+				}
+			};
+
+			// parts the parallel algorithms split their work in: every worker of exec::scheduler::instance(), plus the caller
+			// when it isn't one of them
+			inline size_t parallel_width()
+			{
+				exec::scheduler& scheduler = exec::scheduler::instance();
+				return scheduler.workers() + (scheduler.inside() ? 0 : 1);
+			}
+
+			// calls visit(part, index) for every index in [0, count), spread over `width` parts with work stealing.
+			// The caller runs part 0 and helps the scheduler until the other parts are done, so it also works from inside a task
+			template<class _Visit>
+			void parallel_blocks(size_t width, size_t count, _Visit&& visit)
+			{
+				std::vector<steal_range> ranges(width);
+				for (size_t w = 0; w < width; ++w)
+					ranges[w].assign(count * w / width, count * (w + 1) / width);
+
+				auto part = [&](size_t worker)
+				{
+					size_t index;
+					while (true)
+					{
+						while (ranges[worker].take(index))
+							visit(worker, index);
+
+						// own range is empty, thieves skip it until it gets refilled here
+						size_t begin = 0, end = 0;
+						bool stolen = false;
+						for (size_t v = 1; v < width && !stolen; ++v)
+							stolen = ranges[(worker + v) % width].steal(begin, end);
+
+						if (!stolen)
+							return;
+
+						ranges[worker].assign(begin, end);
+					}
+				};
+
+				exec::scheduler& scheduler = exec::scheduler::instance();
+				std::atomic<size_t> remaining(width - 1);
+				for (size_t w = 1; w < width; ++w)
+				{
+					scheduler.post([&part, &remaining, w]()
+					{
+						part(w);
+						remaining.fetch_sub(1, std::memory_order_release);
+					});
+				}
+
+				part(0);
+				scheduler.help_until([&remaining]() { return remaining.load(std::memory_order_acquire) == 0; });
+			}
+		}
+
+		// fn(T&) for every object, blocks are spread over the workers of exec::scheduler::instance() (see CPPU_EXEC_THREADS).
+		// Empty blocks are skipped, objects are pinned while fn runs (see array::for_each), arrays added in the mean time are skipped
+		template<class T, class S, CLEAN_PROC clean_proc, class policy, class _Func>
+		void parallel_for_each(m_array<T, S, clean_proc, policy>& arr, _Func&& fn)
+		{
+			static_assert(policy::atomic, "thread_policy::local arrays can't be shared with other threads");
+
+			typename m_array<T, S, clean_proc, policy>::directory& arrays = arr.get_arrays();
+			details::parallel_blocks(details::parallel_width(), arrays.size(), [&arrays, &fn](size_t, size_t index)
+			{
+				cgc::array<T, S, clean_proc, policy>* block = arrays[index];
+				if (!block->empty())
+					block->for_each(fn);
+			});
+		}
+
+		// fn(R&, T&) accumulates into a result per worker, combine(R, R) merges those afterwards (order isn't fixed)
+		template<class T, class S, CLEAN_PROC clean_proc, class policy, class R, class _Func, class _Combine>
+		R parallel_reduce(m_array<T, S, clean_proc, policy>& arr, R identity, _Func&& fn, _Combine&& combine)
+		{
+			static_assert(policy::atomic, "thread_policy::local arrays can't be shared with other threads");
+
+			struct alignas(64) partial
+			{
+				R value;
+			};
+
+			const size_t width = details::parallel_width();
+			std::vector<partial> partials(width, partial{ identity });
+
+			typename m_array<T, S, clean_proc, policy>::directory& arrays = arr.get_arrays();
+			details::parallel_blocks(width, arrays.size(), [&arrays, &fn, &partials](size_t worker, size_t index)
+			{
+				cgc::array<T, S, clean_proc, policy>* block = arrays[index];
+				if (!block->empty())
+					block->for_each([&fn, &result = partials[worker].value](T& object) { fn(result, object); });
+			});
+
+			R result = std::move(identity);
+			for (partial& p : partials)
+				result = combine(std::move(result), std::move(p.value));
+
+			return result;
+		}
+	}
+}
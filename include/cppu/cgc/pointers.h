@@ -1,10 +1,11 @@
 #pragma once
 
 #include <cstring>
+#include <type_traits>
 
+#include "details/types.h"
 #include "details/base_counter.h"
 #include "details/garbage_cleaner.h"
-#include "details/destructors.h"
 
 #define GET_NAME(X) #X
 
@@ -13,20 +14,18 @@ namespace cppu
 {
 	namespace cgc
 	{
-		template<class T>
-		class weak_ptr;
-		
-		template<class T>
+		// _Atomic is false for pointers into thread_policy::local containers, their counts don't need atomic operations
+		template<class T, bool _Atomic>
 		class strong_ptr
 		{
 			friend class constructor;
-			template<typename> friend class strong_ptr;
-			template<typename> friend class weak_ptr;
+			template<typename, bool> friend class strong_ptr;
+			template<typename, bool> friend class weak_ptr;
 			template<typename> friend class raw_ptr;
-			template<typename T1, typename T2, typename> friend strong_ptr<T1> static_pointer_cast(const strong_ptr<T2>&) noexcept;
-			template<typename T1, typename T2, typename> friend strong_ptr<T1> dynamic_pointer_cast(const strong_ptr<T2>&) noexcept;
-			template<typename T1, typename T2, typename> friend const strong_ptr<T1>& const_pointer_cast(const strong_ptr<T2>&) noexcept;
-			template<typename T1, typename T2, typename> friend const strong_ptr<T1>& reinterpret_pointer_cast(const strong_ptr<T2>&) noexcept;
+			template<typename T1, typename T2, bool A, typename> friend strong_ptr<T1, A> static_pointer_cast(const strong_ptr<T2, A>&) noexcept;
+			template<typename T1, typename T2, bool A, typename> friend strong_ptr<T1, A> dynamic_pointer_cast(const strong_ptr<T2, A>&) noexcept;
+			template<typename T1, typename T2, bool A, typename> friend const strong_ptr<T1, A>& const_pointer_cast(const strong_ptr<T2, A>&) noexcept;
+			template<typename T1, typename T2, bool A, typename> friend const strong_ptr<T1, A>& reinterpret_pointer_cast(const strong_ptr<T2, A>&) noexcept;
 
 		private:
 			T* pointer;
@@ -39,6 +38,12 @@ namespace cppu
 				IncrementStrongReference();
 			}
 
+			// takes over a strong reference the caller already holds
+			strong_ptr(T* pointer, details::base_counter* refCounter, std::false_type)
+				: pointer(pointer)
+				, refCounter(refCounter)
+			{ }
+
 		public:
 			typedef T element_type;
 
@@ -53,21 +58,21 @@ namespace cppu
 				, refCounter(nullptr)
 			{ }
 						
-			strong_ptr(const strong_ptr<T>& copy)
+			strong_ptr(const strong_ptr<T, _Atomic>& copy)
 				: pointer(copy.pointer)
 				, refCounter(copy.refCounter)
 			{
 				IncrementStrongReference();
 			}
 
-			strong_ptr(const weak_ptr<T>& copy)
+			strong_ptr(const weak_ptr<T, _Atomic>& copy)
 				: pointer(copy.pointer)
 				, refCounter(copy.refCounter)
 			{
 				IncrementStrongReference();
 			}
 
-			strong_ptr(strong_ptr<T>&& move) noexcept
+			strong_ptr(strong_ptr<T, _Atomic>&& move) noexcept
 				: pointer(std::move(move.pointer))
 				, refCounter(std::move(move.refCounter))
 			{
@@ -77,7 +82,7 @@ namespace cppu
 
 			// up cast constructor
 			template <typename TD, typename = typename std::enable_if_t<std::is_base_of_v<T, TD> && std::is_assignable_v<T*&, TD*>>>
-			strong_ptr(const strong_ptr<TD>& copy)
+			strong_ptr(const strong_ptr<TD, _Atomic>& copy)
 				: pointer(copy.pointer)
 				, refCounter(copy.refCounter)
 			{
@@ -86,7 +91,7 @@ namespace cppu
 
 			// up cast move constructor
 			template <typename TD, typename = typename std::enable_if_t<std::is_base_of_v<T, TD> && std::is_assignable_v<T*&, TD*>>>
-			strong_ptr(strong_ptr<TD>&& move) noexcept
+			strong_ptr(strong_ptr<TD, _Atomic>&& move) noexcept
 				: pointer(std::move(move.pointer))
 				, refCounter(std::move(move.refCounter))
 			{
@@ -105,7 +110,7 @@ namespace cppu
 			}
 
 			// copy (copy-and-swap)
-			/*strong_ptr<T>& operator=(strong_ptr<T> copy)
+			/*strong_ptr<T, _Atomic>& operator=(strong_ptr<T, _Atomic> copy)
 			{
 				std::swap(pointer, copy.pointer);
 				std::swap(refCounter, copy.refCounter);
@@ -114,7 +119,7 @@ namespace cppu
 			}*/
 
 			// copy (non-copy-and-swap)
-			strong_ptr<T>& operator=(const strong_ptr<T>& copy)
+			strong_ptr<T, _Atomic>& operator=(const strong_ptr<T, _Atomic>& copy)
 			{
 				if (copy.pointer != this->pointer)
 				{
@@ -128,34 +133,35 @@ namespace cppu
 			}
 
 			// move
-			strong_ptr<T>& operator=(strong_ptr<T>&& move) noexcept
+			strong_ptr<T, _Atomic>& operator=(strong_ptr<T, _Atomic>&& move) noexcept
 			{
 				std::swap(pointer, move.pointer);
 				std::swap(refCounter, move.refCounter);
 				return *this;
 			}
 
-			strong_ptr<T>& operator=(std::nullptr_t) noexcept
+			strong_ptr<T, _Atomic>& operator=(std::nullptr_t) noexcept
 			{
+				DecrementStrongReference();
 				pointer = nullptr;
 				refCounter = nullptr;
 				return *this;
 			}
 			
-			operator strong_ptr<void*>&()
+			operator strong_ptr<void*, _Atomic>&()
 			{
-				return *reinterpret_cast<strong_ptr<void*>*>(this);
+				return *reinterpret_cast<strong_ptr<void*, _Atomic>*>(this);
 			}
 
-			operator weak_ptr<T> ()
+			operator weak_ptr<T, _Atomic> () const
 			{
-				return weak_ptr<T>(*this);
+				return weak_ptr<T, _Atomic>(*this);
 			}
 
 			template <typename TB, typename = typename std::enable_if<std::is_same<TB, T>::value || std::is_base_of<TB, T>::value>::type>
-			inline bool operator==(const strong_ptr<TB>& rhs) const { return pointer == rhs.pointer; }
+			inline bool operator==(const strong_ptr<TB, _Atomic>& rhs) const { return pointer == rhs.pointer; }
 			template <typename TB, typename = typename std::enable_if<std::is_same<TB, T>::value || std::is_base_of<TB, T>::value>::type>
-			inline bool operator!=(const strong_ptr<TB>& rhs) const { return pointer != rhs.pointer; }
+			inline bool operator!=(const strong_ptr<TB, _Atomic>& rhs) const { return pointer != rhs.pointer; }
 
 			inline bool operator==(const T* rhs) const { return pointer == rhs; }
 			inline bool operator!=(const T* rhs) const { return pointer != rhs; }
@@ -170,7 +176,7 @@ namespace cppu
 			inline T* operator->() const { return pointer; }
 			inline T& operator*() const { return *pointer; }
 
-			/*weak_ptr<T> weak_ptr()
+			/*weak_ptr<T, _Atomic> weak_ptr()
 			{
 				return weak_ptr(this);
 			}*/
@@ -179,7 +185,7 @@ namespace cppu
 			inline void IncrementStrongReference()
 			{
 				if (refCounter != nullptr)
- 					refCounter->strongReferences.fetch_add(1);
+					refCounter->add_strong<_Atomic>();
 			}
 
 			// shared pointer mechanics
@@ -192,33 +198,30 @@ namespace cppu
 				{
 					// we'll check if the previous value was 2, if so it will decrement to 0 in this procedure then mark this one as garbage
 					// the last strong value holder is merely a safety measure so weak ptrs won't destroy the ref counter before we do so in here.
-					if (refCounter->strongReferences.fetch_sub(1) == 2)
+					if (refCounter->sub_strong<_Atomic>() == 2)
 					{
 						// add it so the collection can clean it up and give out the free slot again
-						refCounter->add_as_garbage((void*)pointer);
-
-						// after this we've set the actual strong ref count so any weak ptr can delete the ref counter from this point
-						refCounter->strongReferences.fetch_sub(1);
+						refCounter->get_container()->add_as_garbage((void*)pointer, refCounter);
 
-						// strong ref base_counter will be 0, now we only need to check the weak ref base_counter
-						// and remove the tracking object if it's 1
-						if (refCounter->weakReferences.load() == 0)
-							delete refCounter;
+						// after this we've set the actual strong ref count so any weak ptr can delete the ref counter from this point,
+						// together with the weak reference all strong references hold, the last one releases the counter
+						if (refCounter->sub_strong_and_weak<_Atomic>())
+							refCounter->get_container()->release(refCounter);
 					}
 				}
 			}
 		};
 
-		template<class T>
+		template<class T, bool _Atomic>
 		class weak_ptr
 		{
-			template<typename> friend class strong_ptr;
-			template<typename> friend class weak_ptr;
+			template<typename, bool> friend class strong_ptr;
+			template<typename, bool> friend class weak_ptr;
 			template<typename> friend class raw_ptr;
-			template<typename T1, typename T2, typename> friend weak_ptr<T1> static_pointer_cast(const weak_ptr<T2>&) noexcept;
-			template<typename T1, typename T2, typename> friend weak_ptr<T1> dynamic_pointer_cast(const weak_ptr<T2>&) noexcept;
-			template<typename T1, typename T2, typename> friend const weak_ptr<T1>& const_pointer_cast(const weak_ptr<T2>&) noexcept;
-			template<typename T1, typename T2, typename> friend const weak_ptr<T1>& reinterpret_pointer_cast(const weak_ptr<T2>&) noexcept;
+			template<typename T1, typename T2, bool A, typename> friend weak_ptr<T1, A> static_pointer_cast(const weak_ptr<T2, A>&) noexcept;
+			template<typename T1, typename T2, bool A, typename> friend weak_ptr<T1, A> dynamic_pointer_cast(const weak_ptr<T2, A>&) noexcept;
+			template<typename T1, typename T2, bool A, typename> friend const weak_ptr<T1, A>& const_pointer_cast(const weak_ptr<T2, A>&) noexcept;
+			template<typename T1, typename T2, bool A, typename> friend const weak_ptr<T1, A>& reinterpret_pointer_cast(const weak_ptr<T2, A>&) noexcept;
 		private:
 			T* pointer;
 			details::base_counter* refCounter;
@@ -244,35 +247,35 @@ namespace cppu
 				, refCounter(nullptr)
 			{ }
 
-			weak_ptr(weak_ptr<T>* copy)
+			weak_ptr(weak_ptr<T, _Atomic>* copy)
 				: pointer(copy->pointer)
 				, refCounter(copy->refCounter)
 			{
 				IncrementWeakReference();
 			}
 
-			weak_ptr(const weak_ptr<T>* copy)
+			weak_ptr(const weak_ptr<T, _Atomic>* copy)
 				: pointer(copy->pointer)
 				, refCounter(copy->refCounter)
 			{
 				IncrementWeakReference();
 			}
 
-			weak_ptr(const weak_ptr<T>& copy)
+			weak_ptr(const weak_ptr<T, _Atomic>& copy)
 				: pointer(copy.pointer)
 				, refCounter(copy.refCounter)
 			{
 				IncrementWeakReference();
 			}
 
-			/*weak_ptr(const strong_ptr<T>& copy)
+			/*weak_ptr(const strong_ptr<T, _Atomic>& copy)
 				: pointer(copy.pointer)
 				, refCounter(copy.refCounter)
 			{
 				IncrementWeakReference();
 			}*/
 
-			weak_ptr(const strong_ptr<std::remove_const_t<T>>& copy)
+			weak_ptr(const strong_ptr<std::remove_const_t<T>, _Atomic>& copy)
 				: pointer(copy.pointer)
 				, refCounter(copy.refCounter)
 			{
@@ -281,7 +284,7 @@ namespace cppu
 
 			// up cast constructor
 			template <typename TD, typename = typename std::enable_if_t<std::is_base_of_v<T, TD>&& std::is_assignable_v<T*&, TD*>>>
-			weak_ptr(const weak_ptr<TD>& copy)
+			weak_ptr(const weak_ptr<TD, _Atomic>& copy)
 				: pointer(copy.pointer)
 				, refCounter(copy.refCounter)
 			{
@@ -290,7 +293,7 @@ namespace cppu
 
 			// up cast move constructor
 			template <typename TD, typename = typename std::enable_if_t<std::is_base_of_v<T, TD>&& std::is_assignable_v<T*&, TD*>>>
-			weak_ptr(weak_ptr<TD>&& move) noexcept
+			weak_ptr(weak_ptr<TD, _Atomic>&& move) noexcept
 				: pointer(std::move(move.pointer))
 				, refCounter(std::move(move.refCounter))
 			{
@@ -303,15 +306,43 @@ namespace cppu
 				DecrementWeakReference();
 			}
 
+			weak_ptr<T, _Atomic>& operator=(const weak_ptr<T, _Atomic>& copy)
+			{
+				if (copy.refCounter != refCounter)
+				{
+					DecrementWeakReference();
+
+					pointer = copy.pointer;
+					refCounter = copy.refCounter;
+					IncrementWeakReference();
+				}
+				return *this;
+			}
+
+			weak_ptr<T, _Atomic>& operator=(weak_ptr<T, _Atomic>&& move) noexcept
+			{
+				std::swap(pointer, move.pointer);
+				std::swap(refCounter, move.refCounter);
+				return *this;
+			}
+
+			weak_ptr<T, _Atomic>& operator=(std::nullptr_t) noexcept
+			{
+				DecrementWeakReference();
+				pointer = nullptr;
+				refCounter = nullptr;
+				return *this;
+			}
+
 			T* ptr() const
 			{
 				return pointer;
 			}
 
 			template <typename TB, typename = typename std::enable_if<std::is_same<TB, T>::value || std::is_base_of<TB, T>::value>::type>
-			inline bool operator==(const weak_ptr<TB>& rhs) const { return pointer == rhs.pointer; }
+			inline bool operator==(const weak_ptr<TB, _Atomic>& rhs) const { return pointer == rhs.pointer; }
 			template <typename TB, typename = typename std::enable_if<std::is_same<TB, T>::value || std::is_base_of<TB, T>::value>::type>
-			inline bool operator!=(const weak_ptr<TB>& rhs) const { return pointer != rhs.pointer; }
+			inline bool operator!=(const weak_ptr<TB, _Atomic>& rhs) const { return pointer != rhs.pointer; }
 
 			template <typename TB, typename = typename std::enable_if<std::is_same<TB, T>::value || std::is_base_of<TB, T>::value>::type>
 			inline bool operator==(const TB& rhs) const { return pointer == &rhs; }
@@ -330,20 +361,14 @@ namespace cppu
 			inline void IncrementWeakReference()
 			{
 				if (refCounter != nullptr)
-					refCounter->weakReferences.fetch_add(1);
+					refCounter->add_weak<_Atomic>();
 			}
 
 			void DecrementWeakReference()
 			{
-				if (refCounter != nullptr)
-				{
-					// decrement by one and calculate the proper new value (fetc_add returns previous value)
-					details::RefCount weakRef = refCounter->weakReferences.fetch_sub(1) - 1;
-
-					// if both base_counters are 0 then delete the ref base_counter
-					if (refCounter->strongReferences.load() + weakRef == 0)
-						delete refCounter; // remove this tracking object
-				}
+				// strong references hold a weak reference as well, so reaching 0 means nobody uses the counter anymore
+				if (refCounter != nullptr && refCounter->sub_weak<_Atomic>())
+					refCounter->get_container()->release(refCounter); // remove or reuse this tracking object
 			}
 		};
 
@@ -368,11 +393,13 @@ namespace cppu
 				: pointer(ptr)
 			{}
 
-			raw_ptr(const strong_ptr<T>& ptr)
+			template <bool _Atomic>
+			raw_ptr(const strong_ptr<T, _Atomic>& ptr)
 				: pointer(ptr.pointer)
 			{ }
 
-			raw_ptr(const weak_ptr<T>& ptr)
+			template <bool _Atomic>
+			raw_ptr(const weak_ptr<T, _Atomic>& ptr)
 				: pointer(ptr.pointer)
 			{ }
 			
@@ -381,13 +408,13 @@ namespace cppu
 				: pointer(ptr.pointer)
 			{ }
 
-			template <typename T2, typename = std::enable_if_t<std::is_base_of_v<T, T2>>>
-			raw_ptr(const strong_ptr<T2>&ptr)
+			template <typename T2, bool _Atomic, typename = std::enable_if_t<std::is_base_of_v<T, T2>>>
+			raw_ptr(const strong_ptr<T2, _Atomic>&ptr)
 				: pointer(ptr.pointer)
 			{ }
 
-			template <typename T2, typename = std::enable_if_t<std::is_base_of_v<T, T2>>>
-			raw_ptr(const weak_ptr<T2>&ptr)
+			template <typename T2, bool _Atomic, typename = std::enable_if_t<std::is_base_of_v<T, T2>>>
+			raw_ptr(const weak_ptr<T2, _Atomic>&ptr)
 				: pointer(ptr.pointer)
 			{ }
 
@@ -404,19 +431,19 @@ namespace cppu
 			//inline raw_ptr<T>& operator=(const T2& rhs) const { pointer == rhs.pointer; return *this; }
 		};
 
-		template <typename T, typename T2, typename = typename std::enable_if<std::is_base_of<T, T2>::value || std::is_base_of<T2, T>::value || std::is_same<T, T2>::value>::type>
-		strong_ptr<T> static_pointer_cast(const strong_ptr<T2>& cast) noexcept
+		template <typename T, typename T2, bool _Atomic, typename = typename std::enable_if<std::is_base_of<T, T2>::value || std::is_base_of<T2, T>::value || std::is_same<T, T2>::value>::type>
+		strong_ptr<T, _Atomic> static_pointer_cast(const strong_ptr<T2, _Atomic>& cast) noexcept
 		{
-			return strong_ptr<T>(static_cast<T*>(cast.pointer), cast.refCounter);
+			return strong_ptr<T, _Atomic>(static_cast<T*>(cast.pointer), cast.refCounter);
 		}
 
 		///
 		/// \brief only down casting is supported, for up casting just use the constructor (it's implicit!) or the static cast
-		template <typename T, typename T2, typename = typename std::enable_if<std::is_base_of<T2, T>::value>::type>
-		strong_ptr<T> dynamic_pointer_cast(const strong_ptr<T2>& cast) noexcept
+		template <typename T, typename T2, bool _Atomic, typename = typename std::enable_if<std::is_base_of<T2, T>::value>::type>
+		strong_ptr<T, _Atomic> dynamic_pointer_cast(const strong_ptr<T2, _Atomic>& cast) noexcept
 		{
 			// dynamic_cast guarantees the types are interchangeble
-			strong_ptr<T> ptr;
+			strong_ptr<T, _Atomic> ptr;
 			if ((ptr.pointer = dynamic_cast<T*>(cast.pointer)))
 			{
 				ptr.refCounter = cast.refCounter;
@@ -428,18 +455,18 @@ namespace cppu
 
 		///
 		/// \brief remove the const attribute
-		template <typename T>
-		const strong_ptr<T>& const_pointer_cast(const strong_ptr<T>& cast) noexcept
+		template <typename T, bool _Atomic>
+		const strong_ptr<T, _Atomic>& const_pointer_cast(const strong_ptr<T, _Atomic>& cast) noexcept
 		{
-			return strong_ptr<T>(const_cast<std::remove_const_t<T>*>(cast.pointer), cast.refCounter);
+			return strong_ptr<T, _Atomic>(const_cast<std::remove_const_t<T>*>(cast.pointer), cast.refCounter);
 		}
 
 		///
 		/// \brief reinterpret the pointers' bit as if it is another type, unsafe by nature so programmer should gurantee its safety
-		template <typename T, typename T2>
-		const strong_ptr<T>& reinterpret_pointer_cast(const strong_ptr<T2>& cast) noexcept
+		template <typename T, typename T2, bool _Atomic>
+		const strong_ptr<T, _Atomic>& reinterpret_pointer_cast(const strong_ptr<T2, _Atomic>& cast) noexcept
 		{
-			return *reinterpret_cast<const strong_ptr<T>*>(&cast);
+			return *reinterpret_cast<const strong_ptr<T, _Atomic>*>(&cast);
 		}
 	}
 }
@@ -12,18 +12,22 @@ namespace cppu
 	{
 		namespace ref
 		{
-			template<class K, class V, CLEAN_PROC clean_proc = CLEAN_PROC::DIRECT>
-			class unordered_map : private details::base_unordered_map<K, details::counter_value_pair<V>>, public details::icontainer
+			template<class K, class V, CLEAN_PROC clean_proc = CLEAN_PROC::DIRECT, class backend = map_backend::node>
+			class unordered_map : private details::base_unordered_map<K, details::counter_value_pair<V>, backend>, public details::icontainer
 			{
+				static_assert(clean_proc != CLEAN_PROC::EPOCH || backend::concurrent, "CLEAN_PROC::EPOCH maps need map_backend::sharded");
 			private:
 				typedef details::counter_value_pair<V> VALUE;
-				typedef details::base_unordered_map<K, VALUE> BASE_MAP;
-				typedef std::unordered_map<K, VALUE> INTERNAL_MAP;
+				typedef details::base_unordered_map<K, VALUE, backend> BASE_MAP;
+
+				// emplace / release totals, see CPPU_CGC_STATS
+				details::stat_counters<> counts;
 
 			public:
-				typedef typename INTERNAL_MAP::iterator iterator;
+				typedef typename BASE_MAP::iterator iterator;
 
-				unordered_map()
+				explicit unordered_map(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+					: BASE_MAP(resource)
 				{ }
 
 				// This one shouldn't be called unless all of the members are not being used anymore anywhere.
@@ -33,32 +37,44 @@ namespace cppu
 				template<class... _Args>
 				inline strong_ptr<V> emplace(const K& key, _Args&&... arguments)
 				{
-					VALUE* object = BASE_MAP::base_emplace(key, new details::key_counter<K>(this, key, details::destructor::create_destructor<V>()), std::forward<_Args>(arguments)...);
-					return constructor::construct_pointer(&object->get_value(), object->get_counter());
+					counts.add_emplaced(1);
+					std::pair<VALUE*, details::base_counter*> object = BASE_MAP::template base_emplace_counted<true>(this, key, std::forward<_Args>(arguments)...);
+					return constructor::construct_pointer(&object.first->get_value(), object.second);
 				}
 
 				bool add_as_garbage(void* ptr, const details::base_counter* c) override
 				{
+					counts.add_released(1);
+
 					if constexpr (clean_proc == CLEAN_PROC::DIRECT)
-						BASE_MAP::base_destruct_slot(static_cast<const details::key_counter<K>*>(c)->get_key());
+						BASE_MAP::base_destruct_counted(c);
+					else if constexpr (clean_proc == CLEAN_PROC::EPOCH)
+						BASE_MAP::base_retire(c);
 					else
 					{
 						BASE_MAP::base_add_as_garbage(ptr, c);
 						
+						// coalesced by the cleaner, only the first call while dirty lists this container
 						if constexpr (clean_proc == CLEAN_PROC::THREAD)
-						{
-							if (BASE_MAP::garbage.size() == 1)
-								details::garbage_cleaner::add_to_clean(this);
-						}
+							details::garbage_cleaner::add_to_clean(this);
 					}
 
 					return true;
 				}
 
+				void release(const details::base_counter* c) override
+				{
+					BASE_MAP::base_release(c);
+				}
+
 				size_t clean_garbage(size_t max = std::numeric_limits<size_t>::max()) override
 				{
+					details::trace_scope trace("cgc::clean_garbage", this);
+
 					if constexpr (clean_proc == CLEAN_PROC::DIRECT)
 						return max;
+					else if constexpr (clean_proc == CLEAN_PROC::EPOCH)
+						return BASE_MAP::base_clean_retired(max);
 					else
 						return BASE_MAP::base_clean_garbage(max);
 				}
@@ -70,23 +86,23 @@ namespace cppu
 
 				inline cgc::strong_ptr<V> operator[] (K key)
 				{
-					VALUE& element = BASE_MAP::base_slots(key);
-					return constructor::construct_pointer(&element->value, element->counter);
+					VALUE& element = BASE_MAP::base_slots(this, key);
+					return constructor::construct_pointer(&element.get_value(), element.get_counter());
 				}
 
 				inline cgc::strong_ptr<V> front()
 				{
 					VALUE& element = BASE_MAP::base_front();
-					return constructor::construct_pointer(&element->value, element->counter);
+					return constructor::construct_pointer(&element.get_value(), element.get_counter());
 				}
 
 				inline cgc::strong_ptr<V> back()
 				{
 					VALUE& element = BASE_MAP::base_back();
-					return constructor::construct_pointer(&element->value, element->counter);
+					return constructor::construct_pointer(&element.get_value(), element.get_counter());
 				}
 
-				inline iterator erase(const K& key)
+				inline size_t erase(const K& key)
 				{
 					return BASE_MAP::base_erase(key);
 				}
@@ -106,9 +122,36 @@ namespace cppu
 					return BASE_MAP::base_end();
 				}
 
-				inline bool exists(K& key)
+				inline bool exists(const K& key)
 				{
-					return BASE_MAP::exists(key);
+					return BASE_MAP::base_exists(key);
+				}
+
+				// strong_ptr to the object of the key, nullptr when it isn't there or is being released (flat and sharded backends)
+				inline strong_ptr<V> get(const K& key)
+				{
+					std::pair<VALUE*, details::base_counter*> object = BASE_MAP::base_get(key);
+					if (object.first == nullptr)
+						return nullptr;
+
+					// the pointer takes over the strong reference base_get took to keep it alive
+					return constructor::adopt_pointer(&object.first->get_value(), object.second);
+				}
+
+				// plain pointer to the object of the key without touching its reference count, nullptr when it isn't there or is
+				// being released. Only valid while the calling thread holds the epoch_guard it was looked up under
+				inline V* find_pinned(const K& key)
+				{
+					static_assert(clean_proc == CLEAN_PROC::EPOCH, "find_pinned() needs CLEAN_PROC::EPOCH, other modes may destruct the object right away");
+					VALUE* value = BASE_MAP::base_find_pinned(key);
+					return value != nullptr ? &value->get_value() : nullptr;
+				}
+
+				// func(const K&, V&) for every element
+				template<class _Func>
+				inline void for_each(_Func&& func)
+				{
+					BASE_MAP::base_for_each([&func](const K& key, VALUE& value) { func(key, *value); });
 				}
 
 				inline std::size_t garbage_size()
@@ -116,7 +159,7 @@ namespace cppu
 					if constexpr (clean_proc == CLEAN_PROC::DIRECT)
 						return 0;
 					else
-						return BASE_MAP::garbage_size();
+						return BASE_MAP::base_garbage_size();
 				}
 
 				inline bool garbage_empty()
@@ -124,7 +167,18 @@ namespace cppu
 					if constexpr (clean_proc == CLEAN_PROC::DIRECT)
 						return true;
 					else
-						return BASE_MAP::garbage_empty();
+						return BASE_MAP::base_garbage_empty();
+				}
+
+				// live objects, objects waiting for a clean up, emplace / release totals (CPPU_CGC_STATS), free and blocks stay 0
+				container_stats stats()
+				{
+					container_stats s;
+					s.live = size();
+					s.garbage = garbage_size();
+					counts.fill(s);
+					s.time = details::stats_now();
+					return s;
 				}
 			};
 		}
@@ -0,0 +1,367 @@
+#pragma once
+
+#include <bitset>
+#include <limits>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "constructor.h"
+#include "soa.h"
+#include "details/memory_resource.h"
+#include "../bitops.h"
+#include "../dtypes.h"
+
+// Container Garbage Collection
+
+namespace cppu
+{
+	namespace cgc
+	{
+		template<class T>
+		class relocatable;
+
+		namespace details
+		{
+			// Dense storage for the objects of relocatable<T> slots. New objects go to the lowest block with room,
+			// compact() moves objects out of the last blocks into the holes of the first ones and frees blocks that became empty.
+			// Allocating and freeing lock the pool, which makes them safe against a compaction running on another thread.
+			template<class T>
+			class relocation_pool
+			{
+			public:
+				static constexpr size_t block_size = 1024;
+
+			private:
+				static constexpr size_t words = block_size / 64;
+
+				struct block
+				{
+					union
+					{
+						T values[block_size];
+					};
+
+					// handle of every occupied value, patched when the value moves
+					relocatable<T>* owners[block_size];
+					uint64 used[words] = {};
+					size_t count = 0;
+
+					block() { }
+					~block() { }
+
+					inline size_t find_free() const
+					{
+						for (size_t w = 0; w < words; ++w)
+						{
+							if (~used[w] != 0)
+								return w * 64 + bsf(~used[w]);
+						}
+
+						return block_size;
+					}
+
+					inline size_t find_used() const
+					{
+						// bsr() counts the leading zeros
+						for (size_t w = words; w-- > 0;)
+						{
+							if (used[w] != 0)
+								return w * 64 + 63 - bsr(used[w]);
+						}
+
+						return block_size;
+					}
+
+					inline void mark(size_t i, bool set)
+					{
+						if (set)
+							used[i / 64] |= uint64(1) << (i % 64);
+						else
+							used[i / 64] &= ~(uint64(1) << (i % 64));
+					}
+				};
+
+				std::pmr::memory_resource* resource;
+				std::pmr::vector<block*> blocks;
+				// blocks below this one are full
+				size_t firstFree = 0;
+				size_t live = 0;
+				std::mutex lock;
+
+				// expects to be locked, finds (or makes) room and ties it to owner
+				T* claim(relocatable<T>* owner)
+				{
+					size_t b = firstFree;
+					while (b < blocks.size() && blocks[b] != nullptr && blocks[b]->count == block_size)
+						++b;
+
+					if (b == blocks.size())
+						blocks.push_back(nullptr);
+
+					if (blocks[b] == nullptr)
+						blocks[b] = resource_new<block>(resource);
+
+					firstFree = b;
+
+					block* bl = blocks[b];
+					const size_t i = bl->find_free();
+					bl->mark(i, true);
+					bl->owners[i] = owner;
+					++bl->count;
+					++live;
+
+					owner->object = bl->values + i;
+					owner->blockIndex = uint32(b);
+					owner->valueIndex = uint32(i);
+
+					return bl->values + i;
+				}
+
+				// expects to be locked
+				void unclaim(relocatable<T>* owner)
+				{
+					block* bl = blocks[owner->blockIndex];
+					bl->mark(owner->valueIndex, false);
+					--bl->count;
+					--live;
+
+					if (owner->blockIndex < firstFree)
+						firstFree = owner->blockIndex;
+				}
+
+			public:
+				explicit relocation_pool(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+					: resource(resource)
+					, blocks(resource)
+				{ }
+
+				relocation_pool(const relocation_pool&) = delete;
+				relocation_pool& operator=(const relocation_pool&) = delete;
+
+				// objects are destructed by their arrays, only the memory is left
+				~relocation_pool()
+				{
+					for (block* bl : blocks)
+						resource_delete(resource, bl);
+				}
+
+				// build(T*) constructs the object, within the lock so a compaction can't move the spot half way
+				template<class _Build>
+				void construct(relocatable<T>* owner, _Build&& build)
+				{
+					std::lock_guard<std::mutex> lk(lock);
+					T* object = claim(owner);
+					try
+					{
+						build(object);
+					}
+					catch (...)
+					{
+						unclaim(owner);
+						throw;
+					}
+				}
+
+				void destroy(relocatable<T>* owner)
+				{
+					std::lock_guard<std::mutex> lk(lock);
+					owner->object->~T();
+					unclaim(owner);
+				}
+
+				// Moves at most max objects (move construct + destruct) from the back blocks into holes further to the front and
+				// patches their handles, then frees every empty block. Returns the amount of objects moved, 0 once it's dense.
+				// No other thread may use the objects during the call: handles are patched in place, references to the old spot dangle.
+				size_t compact(size_t max = std::numeric_limits<size_t>::max())
+				{
+					std::lock_guard<std::mutex> lk(lock);
+
+					size_t moved = 0;
+					size_t to = firstFree;
+					size_t from = blocks.size();
+					while (moved < max)
+					{
+						while (from > 0 && (blocks[from - 1] == nullptr || blocks[from - 1]->count == 0))
+							--from;
+
+						// released blocks aren't refilled here, that would only trade one block for another
+						while (to < from && (blocks[to] == nullptr || blocks[to]->count == block_size))
+							++to;
+
+						// holes only in the block objects would come from
+						if (to + 1 >= from)
+							break;
+
+						block* source = blocks[from - 1];
+						const size_t i = source->find_used();
+						relocatable<T>* owner = source->owners[i];
+
+						block* target = blocks[to];
+						const size_t j = target->find_free();
+						new (target->values + j) T(std::move(source->values[i]));
+						source->values[i].~T();
+
+						source->mark(i, false);
+						--source->count;
+						target->mark(j, true);
+						target->owners[j] = owner;
+						++target->count;
+
+						owner->object = target->values + j;
+						owner->blockIndex = uint32(to);
+						owner->valueIndex = uint32(j);
+
+						++moved;
+					}
+
+					release_empty();
+					return moved;
+				}
+
+				// fn(T&) for every object in pool order, the dense walk after a compact(). Holds the lock,
+				// so fn can't emplace or release objects of the same container
+				template<class _Func>
+				void for_each(_Func&& fn)
+				{
+					std::lock_guard<std::mutex> lk(lock);
+					for (block* bl : blocks)
+					{
+						if (bl == nullptr)
+							continue;
+
+						for (size_t w = 0; w < words; ++w)
+						{
+							for (uint64 bits = bl->used[w]; bits != 0; bits &= bits - 1)
+								fn(bl->values[w * 64 + bsf(bits)]);
+						}
+					}
+				}
+
+				// live objects, and the blocks currently holding memory
+				inline size_t size()
+				{
+					std::lock_guard<std::mutex> lk(lock);
+					return live;
+				}
+
+				size_t block_count()
+				{
+					std::lock_guard<std::mutex> lk(lock);
+
+					size_t count = 0;
+					for (block* bl : blocks)
+						count += bl != nullptr;
+
+					return count;
+				}
+
+			private:
+				// expects to be locked
+				void release_empty()
+				{
+					for (size_t b = 0; b < blocks.size(); ++b)
+					{
+						if (blocks[b] != nullptr && blocks[b]->count == 0)
+						{
+							resource_delete(resource, blocks[b]);
+							blocks[b] = nullptr;
+						}
+					}
+
+					while (!blocks.empty() && blocks.back() == nullptr)
+						blocks.pop_back();
+
+					if (firstFree > blocks.size())
+						firstFree = blocks.size();
+				}
+			};
+
+			// relocatable<T> slots keep a handle, the objects go to a pool that m_array shares between its blocks
+			template<class T, size_t N>
+			struct column_store<relocatable<T>, N>
+			{
+			private:
+				relocation_pool<T> own;
+				relocation_pool<T>* pool = &own;
+
+			public:
+				// set before the first object is constructed
+				inline void use_pool(relocation_pool<T>* shared)
+				{
+					pool = shared;
+				}
+
+				template<class... _Args>
+				inline void construct(relocatable<T>* row, size_t, _Args&&... arguments)
+				{
+					new (row) relocatable<T>();
+					pool->construct(row, [&](T* object) { constructor::construct_object<T>(object, std::forward<_Args>(arguments)...); });
+				}
+
+				inline void destroy(relocatable<T>* row, size_t)
+				{
+					pool->destroy(row);
+					row->~relocatable<T>();
+				}
+
+				inline void* const* columns() const
+				{
+					return nullptr;
+				}
+
+				inline relocation_pool<T>& objects()
+				{
+					return *pool;
+				}
+			};
+
+			template<class T>
+			struct is_relocatable : std::false_type { };
+
+			template<class T>
+			struct is_relocatable<relocatable<T>> : std::true_type { };
+
+			// pool member of m_array, nothing for other element types
+			template<class T>
+			struct relocation_pool_of
+			{
+				struct type
+				{
+					explicit type(std::pmr::memory_resource*) { }
+				};
+			};
+
+			template<class T>
+			struct relocation_pool_of<relocatable<T>>
+			{
+				typedef relocation_pool<T> type;
+			};
+		}
+
+		// Element type for arrays that can be defragmented: cgc::m_array<cgc::relocatable<Enemy>> stores a small handle in its
+		// slots (and strong_ptrs point at that handle), the objects live in a dense pool that compact() can pack together.
+		// The slot blocks holding the handles aren't compacted or freed, see m_array::compact().
+		// Only the handle is stable, don't keep plain pointers or references to the object across a compact() call:
+		//   strong_ptr<relocatable<Enemy>> e = enemies.emplace(...);
+		//   (*e)->health -= 10;
+		template<class T>
+		class relocatable
+		{
+			template<class> friend class details::relocation_pool;
+
+		private:
+			T* object = nullptr;
+			uint32 blockIndex = 0;
+			uint32 valueIndex = 0;
+
+		public:
+			typedef T value_type;
+
+			inline T* get() const { return object; }
+			inline T* operator->() const { return object; }
+			inline T& operator*() const { return *object; }
+		};
+	}
+}
@@ -0,0 +1,365 @@
+#pragma once
+
+#include <bitset>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "constructor.h"
+#include "details/slot_mask.h"
+#include "../dtypes.h"
+
+// Container Garbage Collection
+
+namespace cppu
+{
+	namespace cgc
+	{
+		// Lists the fields of T for structure of arrays storage (cgc::soa<T>), specialize it with member pointers:
+		//   template<> struct cgc::soa_fields<Particle> { static constexpr auto members = std::make_tuple(&Particle::x, &Particle::vx); };
+		template<class T>
+		struct soa_fields;
+
+		template<class T>
+		class soa;
+
+		// Contiguous values of one field, a column of a chunk
+		template<class F>
+		class column
+		{
+		private:
+			F* values;
+			size_t count;
+
+		public:
+			column(F* values, size_t count)
+				: values(values)
+				, count(count)
+			{ }
+
+			inline F* data() const { return values; }
+			inline size_t size() const { return count; }
+			inline F* begin() const { return values; }
+			inline F* end() const { return values + count; }
+			inline F& operator[](size_t i) const { return values[i]; }
+		};
+
+		namespace details
+		{
+			template<class M>
+			struct member_type;
+
+			template<class C, class F>
+			struct member_type<F C::*>
+			{
+				typedef F type;
+			};
+
+			template<class T>
+			struct soa_layout
+			{
+				typedef std::decay_t<decltype(soa_fields<T>::members)> members_t;
+				static constexpr size_t count = std::tuple_size_v<members_t>;
+
+				template<size_t I>
+				using field_t = typename member_type<std::tuple_element_t<I, members_t>>::type;
+
+				template<size_t I>
+				static constexpr auto member() { return std::get<I>(soa_fields<T>::members); }
+
+				// column index of a member pointer, count if it isn't listed
+				template<auto Member, size_t I = 0>
+				static constexpr size_t index_of()
+				{
+					if constexpr (I >= count)
+						return count;
+					else if constexpr (std::is_same_v<std::tuple_element_t<I, members_t>, decltype(Member)>)
+						return member<I>() == Member ? I : index_of<Member, I + 1>();
+					else
+						return index_of<Member, I + 1>();
+				}
+
+				// array fields (float[4]) are copied as a whole, they have to be trivially copyable
+				template<class F>
+				static inline void assign(F& to, const F& from)
+				{
+					if constexpr (std::is_array_v<F>)
+					{
+						static_assert(std::is_trivially_copyable_v<F>, "soa array fields need a trivially copyable element type");
+						std::memcpy(&to, &from, sizeof(F));
+					}
+					else
+						to = from;
+				}
+
+				// fields are picked by column index or by member pointer
+				template<auto Field>
+				static constexpr size_t field_index()
+				{
+					if constexpr (std::is_member_object_pointer_v<decltype(Field)>)
+						return index_of<Field>();
+					else
+						return size_t(Field);
+				}
+			};
+
+			// Column storage of a block, one cache line aligned array per field. Fields that are trivial to construct start zeroed
+			// and keep their last value when destructed, so a loop can run over a whole column and mask the results.
+			template<class T, size_t N>
+			class soa_columns
+			{
+			private:
+				typedef soa_layout<T> layout;
+
+				template<class F>
+				struct alignas(64) storage
+				{
+					union
+					{
+						F values[N];
+					};
+
+					storage() { }
+					~storage() { }
+				};
+
+				template<size_t... I>
+				static std::tuple<storage<typename layout::template field_t<I>>...> make_columns(std::index_sequence<I...>);
+
+				typedef std::make_index_sequence<layout::count> indices;
+
+				decltype(make_columns(indices())) data;
+				void* pointers[layout::count];
+
+				template<size_t... I>
+				inline void setup(std::index_sequence<I...>)
+				{
+					((pointers[I] = std::get<I>(data).values), ...);
+					(zero<I>(), ...);
+				}
+
+				template<size_t I>
+				inline void zero()
+				{
+					if constexpr (std::is_trivially_default_constructible_v<typename layout::template field_t<I>>)
+						std::memset(std::get<I>(data).values, 0, sizeof(std::get<I>(data).values));
+				}
+
+				template<size_t I>
+				inline void construct_field(size_t slot, T& object)
+				{
+					typedef typename layout::template field_t<I> F;
+					if constexpr (std::is_array_v<F>)
+						layout::assign(std::get<I>(data).values[slot], object.*layout::template member<I>());
+					else
+						new (std::get<I>(data).values + slot) F(std::move(object.*layout::template member<I>()));
+				}
+
+				template<size_t... I>
+				inline void construct_fields(size_t slot, T& object, std::index_sequence<I...>)
+				{
+					(construct_field<I>(slot, object), ...);
+				}
+
+				template<size_t I>
+				inline void destroy_field(size_t slot)
+				{
+					typedef typename layout::template field_t<I> F;
+					if constexpr (!std::is_trivially_destructible_v<F>)
+						std::get<I>(data).values[slot].~F();
+				}
+
+				template<size_t... I>
+				inline void destroy_fields(size_t slot, std::index_sequence<I...>)
+				{
+					(destroy_field<I>(slot), ...);
+				}
+
+			public:
+				soa_columns()
+				{
+					setup(indices());
+				}
+
+				// the whole object is built first, then moved into the columns field by field
+				template<class... _Args>
+				inline void construct(soa<T>* row, size_t slot, _Args&&... arguments)
+				{
+					T object(std::forward<_Args>(arguments)...);
+					construct_fields(slot, object, indices());
+					new (row) soa<T>(pointers, slot);
+				}
+
+				inline void destroy(soa<T>* row, size_t slot)
+				{
+					destroy_fields(slot, indices());
+					row->~soa<T>();
+				}
+
+				inline void* const* columns() const
+				{
+					return pointers;
+				}
+			};
+
+			// How an array constructs and destructs objects in its slots, plain objects by default
+			template<class T, size_t N>
+			struct column_store
+			{
+				template<class... _Args>
+				inline void construct(T* object, size_t, _Args&&... arguments)
+				{
+					constructor::construct_object<T>(object, std::forward<_Args>(arguments)...);
+				}
+
+				inline void destroy(T* object, size_t)
+				{
+					object->~T();
+				}
+
+				inline void* const* columns() const
+				{
+					return nullptr;
+				}
+			};
+
+			// soa<T> slots only hold a row handle, the fields go to the columns
+			template<class T, size_t N>
+			struct column_store<soa<T>, N> : public soa_columns<T, N>
+			{ };
+
+			template<class T>
+			struct is_soa : std::false_type { };
+
+			template<class T>
+			struct is_soa<soa<T>> : std::true_type { };
+		}
+
+		// Element type for structure of arrays storage: cgc::m_array<cgc::soa<Particle>> keeps every field listed in
+		// soa_fields<Particle> in its own column per block. Slots (and strong_ptrs) hold this row handle, objects are built from
+		// the emplace arguments and then split into the columns. Fields are accessed by column index or member pointer:
+		//   p->get<&Particle::x>() += 1.f;
+		template<class T>
+		class soa
+		{
+			template<class, size_t> friend class details::soa_columns;
+
+		private:
+			typedef details::soa_layout<T> layout;
+
+			void* const* columns;
+			size_t index;
+
+			soa(void* const* columns, size_t index)
+				: columns(columns)
+				, index(index)
+			{ }
+
+			template<size_t... I>
+			inline void load_fields(T& object, std::index_sequence<I...>) const
+			{
+				(layout::assign(object.*layout::template member<I>(), get<I>()), ...);
+			}
+
+			template<size_t... I>
+			inline void store_fields(const T& object, std::index_sequence<I...>) const
+			{
+				(layout::assign(get<I>(), object.*layout::template member<I>()), ...);
+			}
+
+		public:
+			typedef T value_type;
+
+			template<auto Field>
+			inline auto& get() const
+			{
+				constexpr size_t I = layout::template field_index<Field>();
+				static_assert(I < layout::count, "field isn't listed in soa_fields");
+				return static_cast<typename layout::template field_t<I>*>(columns[I])[index];
+			}
+
+			// copy of the fields, T has to be default constructible
+			inline T load() const
+			{
+				T object;
+				load_fields(object, std::make_index_sequence<layout::count>());
+				return object;
+			}
+
+			inline void store(const T& object) const
+			{
+				store_fields(object, std::make_index_sequence<layout::count>());
+			}
+
+			// position in its block, the same index in every column
+			inline size_t slot() const
+			{
+				return index;
+			}
+		};
+
+		// One block of an array as handed out by for_each_chunk(), with a snapshot of which slots hold an object.
+		// Plain arrays expose the objects through data(), soa<T> arrays their columns through field<>()
+		template<class T, class S>
+		class chunk
+		{
+			template<typename, typename, CLEAN_PROC, typename> friend class array;
+
+		public:
+			static constexpr size_t word_count = details::slot_mask<S>::word_count;
+
+		private:
+			T* rows;
+			void* const* columns;
+			uint64 occupancy[word_count];
+
+			chunk(T* rows, void* const* columns)
+				: rows(rows)
+				, columns(columns)
+			{ }
+
+		public:
+			static constexpr size_t size() { return details::slot_mask<S>::digits; }
+
+			// occupied slots of word w, bit i is slot w * 64 + i
+			inline uint64 mask(size_t w = 0) const
+			{
+				return occupancy[w];
+			}
+
+			inline bool occupied(size_t slot) const
+			{
+				return (occupancy[slot / 64] >> (slot % 64)) & 1;
+			}
+
+			inline size_t count() const
+			{
+				size_t total = 0;
+				for (uint64 w : occupancy)
+					total += std::bitset<64>(w).count();
+
+				return total;
+			}
+
+			// objects, or row handles for soa<T>
+			inline T* data() const
+			{
+				return rows;
+			}
+
+			template<auto Field>
+			inline auto field() const
+			{
+				static_assert(details::is_soa<T>::value, "field columns need soa<T> storage");
+
+				typedef details::soa_layout<typename T::value_type> layout;
+				constexpr size_t I = layout::template field_index<Field>();
+				static_assert(I < layout::count, "field isn't listed in soa_fields");
+
+				typedef typename layout::template field_t<I> F;
+				return column<F>(static_cast<F*>(columns[I]), size());
+			}
+		};
+	}
+}
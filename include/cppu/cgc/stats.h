@@ -0,0 +1,78 @@
+#pragma once
+
+#include <sstream>
+#include <string>
+
+#include "details/stats.h"
+#include "details/garbage_cleaner.h"
+
+// Container Garbage Collection
+
+namespace cppu
+{
+	namespace cgc
+	{
+		// objects per second between two snapshots of the same container
+		inline double emplace_rate(const container_stats& before, const container_stats& after)
+		{
+			return after.time > before.time ? double(after.emplaced - before.emplaced) * 1e9 / double(after.time - before.time) : 0.0;
+		}
+
+		inline double release_rate(const container_stats& before, const container_stats& after)
+		{
+			return after.time > before.time ? double(after.released - before.released) * 1e9 / double(after.time - before.time) : 0.0;
+		}
+
+		// "live 10 free 22 garbage 0 blocks 1 emplaced 12 released 2"
+		inline std::string to_text(const container_stats& s)
+		{
+			std::ostringstream out;
+			out << "live " << s.live << " free " << s.free << " garbage " << s.garbage << " blocks " << s.blocks
+				<< " emplaced " << s.emplaced << " released " << s.released;
+			return out.str();
+		}
+
+		inline std::string to_json(const container_stats& s)
+		{
+			std::ostringstream out;
+			out << "{\"live\":" << s.live << ",\"free\":" << s.free << ",\"garbage\":" << s.garbage << ",\"blocks\":" << s.blocks
+				<< ",\"emplaced\":" << s.emplaced << ",\"released\":" << s.released << ",\"time\":" << s.time << '}';
+			return out.str();
+		}
+
+		// counters on the first line, then a line per used histogram bucket: "< 2048ns 17"
+		inline std::string to_text(const cleaner_stats& s)
+		{
+			std::ostringstream out;
+			out << "queued " << s.queued << " visits " << s.visits << " cleaned " << s.cleaned
+				<< " total " << s.totalNanoseconds << "ns max " << s.maxNanoseconds << "ns\n";
+
+			for (size_t i = 0; i < cleaner_stats::buckets; ++i)
+			{
+				if (s.histogram[i] == 0)
+					continue;
+
+				if (i + 1 < cleaner_stats::buckets)
+					out << "< " << (uint64(2) << i) << "ns " << s.histogram[i] << '\n';
+				else
+					out << ">= " << (uint64(1) << i) << "ns " << s.histogram[i] << '\n';
+			}
+
+			return out.str();
+		}
+
+		// the histogram is the full bucket array, bucket i starts at 2^i nanoseconds
+		inline std::string to_json(const cleaner_stats& s)
+		{
+			std::ostringstream out;
+			out << "{\"queued\":" << s.queued << ",\"visits\":" << s.visits << ",\"cleaned\":" << s.cleaned
+				<< ",\"totalNanoseconds\":" << s.totalNanoseconds << ",\"maxNanoseconds\":" << s.maxNanoseconds << ",\"histogram\":[";
+
+			for (size_t i = 0; i < cleaner_stats::buckets; ++i)
+				out << (i > 0 ? "," : "") << s.histogram[i];
+
+			out << "],\"time\":" << s.time << '}';
+			return out.str();
+		}
+	}
+}
@@ -3,14 +3,20 @@
 #include "../dtypes.h"
 #include <bitset>
 #include <queue>
+#include <shared_mutex>
 #include <unordered_map>
 
 #include "pointers.h"
 #include "details/key_counter.h"
 #include "details/icontainer.h"
 #include "details/garbage_cleaner.h"
+#include "details/epoch.h"
+#include "details/flat_table.h"
+#include "details/memory_resource.h"
+#include "details/stats.h"
 #include "constructor.h"
 #include "../stor/lock/queue.h"
+#include "../stor/lockfree/queue.h"
 
 #include "../bitops.h"
 
@@ -26,16 +32,38 @@ namespace cppu
 	{
 		namespace details
 		{
-			template<class K, class V>
+			// Counter stored inline in a flat_table slot, knows its own slot so garbage is tracked by slot instead of by key
+			struct slot_counter : public base_counter
+			{
+				uint32 slot;
+				uint32 shard = 0; // map_backend::sharded only
+
+				slot_counter(icontainer* container, size_t slot)
+					: base_counter(container)
+					, slot(uint32(slot))
+				{ }
+			};
+
+			template<class K, class V, class backend = map_backend::node>
 			class base_unordered_map
 			{
+			public:
+				typedef typename std::pmr::unordered_map<K, V>::iterator iterator;
+
+				explicit base_unordered_map(std::pmr::memory_resource* resource)
+					: slots(resource)
+					, resource(resource)
+				{ }
+
 			protected:
-				std::unordered_map<K, V> slots;
+				std::pmr::unordered_map<K, V> slots;
+				// nodes come from the map's allocator, counters straight from the resource
+				std::pmr::memory_resource* resource;
 				stor::lock::queue<K> garbage;
 
-				__forceinline V& base_slots(const K& key)
+				__forceinline V& base_slots(icontainer*, const K& key)
 				{
-					return reinterpret_cast<std::unordered_map<K, V>&>(slots)[key];
+					return slots[key];
 				}
 
 				template<class... _Args>
@@ -47,14 +75,35 @@ namespace cppu
 					return static_cast<V*>(slot);
 				}
 
+				// constructs V from (counter, arguments...) when _CounterFirst, for values that keep their counter (ref maps)
+				template<bool _CounterFirst, class... _Args>
+				__forceinline std::pair<V*, base_counter*> base_emplace_counted(icontainer* owner, const K& key, _Args&&... arguments)
+				{
+					key_counter<K>* counter = resource_new<key_counter<K>>(resource, owner, key);
+					if constexpr (_CounterFirst)
+						return { base_emplace(key, counter, std::forward<_Args>(arguments)...), counter };
+					else
+						return { base_emplace(key, std::forward<_Args>(arguments)...), counter };
+				}
+
+				__forceinline void base_destruct_counted(const base_counter* c)
+				{
+					base_destruct_slot(static_cast<const key_counter<K>*>(c)->get_key());
+				}
+
+				__forceinline void base_release(const base_counter* c)
+				{
+					resource_delete(resource, const_cast<key_counter<K>*>(static_cast<const key_counter<K>*>(c)));
+				}
+
 				__forceinline void base_add_as_garbage(void* ptr, const base_counter* c)
 				{
 					garbage.push(static_cast<const key_counter<K>*>(c)->get_key());
 				}
 
-				__forceinline uint base_clean_garbage(uint max = std::numeric_limits<uint>::max())
+				__forceinline size_t base_clean_garbage(size_t max = std::numeric_limits<size_t>::max())
 				{
-					uint i = 0;
+					size_t i = 0;
 					while (!garbage.empty() && i < max)
 					{
 						K key = garbage.front();
@@ -67,7 +116,7 @@ namespace cppu
 					return i;
 				}
 
-				__forceinline void base_destruct_slot(typename std::unordered_map<K, V>::const_iterator it)
+				__forceinline void base_destruct_slot(typename std::pmr::unordered_map<K, V>::const_iterator it)
 				{
 					if (it != slots.end())
 						slots.erase(it);
@@ -93,31 +142,38 @@ namespace cppu
 					return slots.back();
 				}
 
-				__forceinline typename std::unordered_map<K, V>::iterator base_erase(const K& key)
+				__forceinline size_t base_erase(const K& key)
 				{
 					return slots.erase(key);
 				}
 
-				__forceinline typename std::unordered_map<K, V>::iterator base_find(const K& obj)
+				__forceinline iterator base_find(const K& obj)
 				{
 					return slots.find(obj);
 				}
 
-				__forceinline typename std::unordered_map<K, V>::iterator base_begin()
+				__forceinline iterator base_begin()
 				{
 					return slots.begin();
 				}
 
-				__forceinline typename std::unordered_map<K, V>::iterator base_end()
+				__forceinline iterator base_end()
 				{
 					return slots.end();
 				}
 
-				__forceinline bool base_exists(K& key)
+				__forceinline bool base_exists(const K& key)
 				{
 					return slots.count(key);
 				}
 
+				template<class _Func>
+				__forceinline void base_for_each(_Func&& func)
+				{
+					for (std::pair<const K, V>& element : slots)
+						func(element.first, element.second);
+				}
+
 				__forceinline std::size_t base_garbage_size()
 				{
 					return garbage.size();
@@ -128,16 +184,517 @@ namespace cppu
 					return garbage.empty();
 				}
 			};
+
+			// Flat backend: values stay in the table's stable slots, counters are stored next to them (no allocation per object)
+			// and garbage is queued as slot numbers, so cleaning doesn't hash the key again.
+			// The table is not thread safe, same as the node backend.
+			template<class K, class V>
+			class base_unordered_map<K, V, map_backend::flat>
+			{
+			public:
+				typedef typename flat_table<K, V, slot_counter>::iterator iterator;
+
+				explicit base_unordered_map(std::pmr::memory_resource* resource)
+					: slots(resource)
+				{ }
+
+			protected:
+				struct retired_slot
+				{
+					uint64 epoch;
+					size_t slot;
+				};
+
+				flat_table<K, V, slot_counter> slots;
+				// released from any thread, drained by the cleaner
+				stor::lockfree::queue<size_t> garbage;
+				stor::lock::queue<retired_slot> retired;
+
+				~base_unordered_map()
+				{
+					// retired slots are unlinked already, the table doesn't know about them anymore
+					std::unique_lock<std::mutex> lk;
+					std::queue<retired_slot>& nodes = retired.get_queue_and_lock(lk);
+					for (; !nodes.empty(); nodes.pop())
+						slots.destroy(nodes.front().slot);
+				}
+
+				static __forceinline size_t slot_of(const base_counter* c)
+				{
+					return static_cast<const slot_counter*>(c)->slot;
+				}
+
+				// after add_as_garbage the container holds a weak reference, so the slot isn't reused before it's cleaned
+				__forceinline void drop_garbage_hold(size_t slot)
+				{
+					if (slots.meta(slot)->sub_weak())
+						slots.release(slot);
+				}
+
+				// every slot gets a counter, erase() relies on it
+				__forceinline V& base_slots(icontainer* owner, const K& key)
+				{
+					std::pair<size_t, bool> result = slots.insert(key);
+					if (result.second)
+					{
+						new (slots.meta(result.first)) slot_counter(owner, result.first);
+						constructor::construct_object<V>(slots.value(result.first));
+					}
+
+					return *slots.value(result.first);
+				}
+
+				template<bool _CounterFirst, class... _Args>
+				__forceinline std::pair<V*, base_counter*> base_emplace_counted(icontainer* owner, const K& key, _Args&&... arguments)
+				{
+					std::pair<size_t, bool> result = slots.insert(key);
+					V* object = slots.value(result.first);
+					slot_counter* counter = slots.meta(result.first);
+
+					// same as the node backend, emplacing an existing key replaces the value (and keeps its counter)
+					if (result.second)
+						new (counter) slot_counter(owner, result.first);
+					else
+						object->~V();
+
+					if constexpr (_CounterFirst)
+						constructor::construct_object<V>(object, static_cast<base_counter*>(counter), std::forward<_Args>(arguments)...);
+					else
+						constructor::construct_object<V>(object, std::forward<_Args>(arguments)...);
+
+					return { object, counter };
+				}
+
+				__forceinline void base_destruct_counted(const base_counter* c)
+				{
+					const size_t slot = slot_of(c);
+					slots.unlink(slot);
+					slots.destroy(slot);
+				}
+
+				__forceinline void base_release(const base_counter* c)
+				{
+					slots.release(slot_of(c));
+				}
+
+				__forceinline void base_add_as_garbage(void*, const base_counter* c)
+				{
+					const size_t slot = slot_of(c);
+					slots.meta(slot)->add_weak();
+					garbage.push(slot);
+				}
+
+				__forceinline size_t base_clean_garbage(size_t max = std::numeric_limits<size_t>::max())
+				{
+					size_t i = 0;
+					size_t slot;
+					while (i < max && garbage.try_pop(slot))
+					{
+						slots.unlink(slot);
+						slots.destroy(slot);
+						drop_garbage_hold(slot);
+						++i;
+					}
+
+					return i;
+				}
+
+				// EPOCH: only reached through the sharded backend, which holds the shard's lock for it.
+				// The slot is unlinked right away and destructed once no reader can hold it anymore
+				__forceinline void base_retire(const base_counter* c)
+				{
+					// note the epoch this thread is pinned at, see details::epoch::grace
+					epoch_guard guard;
+
+					const size_t slot = slot_of(c);
+					slots.meta(slot)->add_weak();
+					slots.unlink(slot);
+					retired.push({ guard.epoch(), slot });
+				}
+
+				__forceinline size_t base_clean_retired(size_t max = std::numeric_limits<size_t>::max())
+				{
+					// same passes as cgc::array, slots are queued in (roughly) epoch order so stop at the first one that's too young
+					size_t i = 0;
+					for (size_t pass = 0; pass < epoch::buckets && i < max; ++pass)
+					{
+						{
+							epoch_guard guard;
+							std::unique_lock<std::mutex> lk;
+							std::queue<retired_slot>& nodes = retired.get_queue_and_lock(lk);
+							while (!nodes.empty() && nodes.front().epoch + epoch::grace <= guard.epoch() && i < max)
+							{
+								const size_t slot = nodes.front().slot;
+								nodes.pop();
+
+								slots.destroy(slot);
+								drop_garbage_hold(slot);
+								++i;
+							}
+						}
+
+						epoch::try_advance();
+					}
+
+					return i;
+				}
+
+				__forceinline size_t base_size()
+				{
+					return slots.size();
+				}
+
+				__forceinline V& base_front()
+				{
+					return (*slots.begin()).second;
+				}
+
+				__forceinline size_t base_erase(const K& key)
+				{
+					const size_t slot = slots.find_slot(key);
+					if (slot == slots.npos)
+						return 0;
+
+					slot_counter* counter = slots.meta(slot);
+					slots.unlink(slot);
+
+					// strong count 1 is the base count: nobody refers to it, destruct now.
+					// Otherwise the last strong reference (or the pending clean up for 0) destructs it later
+					if (counter->strong_count() == 1)
+					{
+						counter->sub_strong();
+						slots.destroy(slot);
+						drop_garbage_hold(slot);
+					}
+
+					return 1;
+				}
+
+				__forceinline iterator base_find(const K& key)
+				{
+					return slots.find(key);
+				}
+
+				__forceinline iterator base_begin()
+				{
+					return slots.begin();
+				}
+
+				__forceinline iterator base_end()
+				{
+					return slots.end();
+				}
+
+				__forceinline bool base_exists(const K& key)
+				{
+					return slots.count_key(key);
+				}
+
+				// value and counter with a strong reference taken, or nullptr when the key is gone or its object is being released
+				__forceinline std::pair<V*, base_counter*> base_get(const K& key)
+				{
+					const size_t slot = slots.find_slot(key);
+					if (slot == slots.npos || !slots.meta(slot)->try_add_strong())
+						return { nullptr, nullptr };
+
+					return { slots.value(slot), slots.meta(slot) };
+				}
+
+				// value without a reference taken, nullptr when the key is gone or its object is being released.
+				// Only a plain load of the count, the caller keeps the object alive (sharded backend: an epoch_guard)
+				__forceinline V* base_find_pinned(const K& key)
+				{
+					const size_t slot = slots.find_slot(key);
+					if (slot == slots.npos || slots.meta(slot)->strong_count() == 0)
+						return nullptr;
+
+					return slots.value(slot);
+				}
+
+				template<class _Func>
+				__forceinline void base_for_each(_Func&& func)
+				{
+					for (size_t slot = slots.next_live(0); slot < slots.slot_count(); slot = slots.next_live(slot + 1))
+						func(slots.key(slot), *slots.value(slot));
+				}
+
+				__forceinline std::size_t base_garbage_size()
+				{
+					return garbage.size() + retired.size();
+				}
+
+				__forceinline bool base_garbage_empty()
+				{
+					return garbage.empty() && retired.empty();
+				}
+			};
+
+			// Sharded backend: flat tables behind their own lock, picked by key hash. Lookups share the lock, everything that
+			// changes a table (emplace, erase, cleaning, giving a slot back) takes it exclusively, so owner threads and the
+			// garbage cleaner can work on the map at the same time without one global lock.
+			// A key is unlinked on erase (or when emplaced again) and its object stays valid until the last strong_ptr is gone.
+			// No iterators, they couldn't stay valid while other threads change the map, use get() and for_each() instead.
+			template<class K, class V, size_t Shards>
+			class base_unordered_map<K, V, map_backend::sharded<Shards>>
+			{
+			public:
+				typedef void iterator;
+
+				explicit base_unordered_map(std::pmr::memory_resource* resource)
+					: base_unordered_map(resource, std::make_index_sequence<Shards>())
+				{ }
+
+			private:
+				typedef base_unordered_map<K, V, map_backend::flat> FLAT_MAP;
+
+				// the table's memory goes through the epoch_resource, base_find_pinned() probes it without the lock
+				struct alignas(64) shard : private epoch_resource, public FLAT_MAP
+				{
+					std::shared_mutex lock;
+					std::atomic<uint64> version = 0; // odd while a writer changes the table, see flat_table::find_slot_optimistic()
+
+					explicit shard(std::pmr::memory_resource* resource)
+						: epoch_resource(resource)
+						, FLAT_MAP(this)
+					{ }
+
+					using epoch_resource::reclaim;
+
+					using FLAT_MAP::slots;
+					using FLAT_MAP::base_emplace_counted;
+					using FLAT_MAP::base_destruct_counted;
+					using FLAT_MAP::base_release;
+					using FLAT_MAP::base_add_as_garbage;
+					using FLAT_MAP::base_clean_garbage;
+					using FLAT_MAP::base_retire;
+					using FLAT_MAP::base_clean_retired;
+					using FLAT_MAP::base_get;
+					using FLAT_MAP::base_find_pinned;
+					using FLAT_MAP::base_for_each;
+					using FLAT_MAP::base_garbage_size;
+				};
+
+				shard shards[Shards];
+
+				// exclusive lock of a shard, lock free readers see an odd version while it's held
+				struct write_lock
+				{
+					shard& s;
+					std::unique_lock<std::shared_mutex> lk;
+
+					explicit write_lock(shard& s)
+						: s(s)
+						, lk(s.lock)
+					{
+						s.version.store(s.version.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+						std::atomic_thread_fence(std::memory_order_release);
+					}
+
+					~write_lock()
+					{
+						s.version.store(s.version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+					}
+				};
+
+				template<size_t... I>
+				base_unordered_map(std::pmr::memory_resource* resource, std::index_sequence<I...>)
+					: shards{ shard((void(I), resource))... }
+				{ }
+
+				// the tables mix the hash themselves, the top bits of another mix pick the shard
+				inline shard& shard_of(const K& key)
+				{
+					const uint64 h = uint64(std::hash<K>()(key)) * 0xD6E8FEB86659FD93ull;
+					return shards[(h >> 32) & (Shards - 1)];
+				}
+
+				inline shard& shard_of(const base_counter* c)
+				{
+					return shards[static_cast<const slot_counter*>(c)->shard];
+				}
+
+			protected:
+				template<bool _CounterFirst, class... _Args>
+				__forceinline std::pair<V*, base_counter*> base_emplace_counted(icontainer* owner, const K& key, _Args&&... arguments)
+				{
+					shard& s = shard_of(key);
+					write_lock lk(s);
+
+					// other threads may still hold the old object, only unlink it, its last strong_ptr cleans it up
+					const size_t old = s.slots.find_slot(key);
+					if (old != s.slots.npos)
+						s.slots.unlink(old);
+
+					std::pair<V*, base_counter*> object = s.template base_emplace_counted<_CounterFirst>(owner, key, std::forward<_Args>(arguments)...);
+					static_cast<slot_counter*>(object.second)->shard = uint32(&s - shards);
+					return object;
+				}
+
+				__forceinline void base_destruct_counted(const base_counter* c)
+				{
+					shard& s = shard_of(c);
+					write_lock lk(s);
+					s.base_destruct_counted(c);
+				}
+
+				__forceinline void base_release(const base_counter* c)
+				{
+					shard& s = shard_of(c);
+					write_lock lk(s);
+					s.base_release(c);
+				}
+
+				__forceinline void base_add_as_garbage(void* ptr, const base_counter* c)
+				{
+					// the garbage queue has its own lock, the table itself isn't changed
+					shard& s = shard_of(c);
+					std::shared_lock<std::shared_mutex> lk(s.lock);
+					s.base_add_as_garbage(ptr, c);
+				}
+
+				__forceinline size_t base_clean_garbage(size_t max = std::numeric_limits<size_t>::max())
+				{
+					size_t i = 0;
+					for (size_t n = 0; n < Shards && i < max; ++n)
+					{
+						write_lock lk(shards[n]);
+						i += shards[n].base_clean_garbage(max - i);
+					}
+
+					return i;
+				}
+
+				__forceinline void base_retire(const base_counter* c)
+				{
+					shard& s = shard_of(c);
+					write_lock lk(s);
+					s.base_retire(c);
+				}
+
+				__forceinline size_t base_clean_retired(size_t max = std::numeric_limits<size_t>::max())
+				{
+					size_t i = 0;
+					for (size_t n = 0; n < Shards && i < max; ++n)
+					{
+						write_lock lk(shards[n]);
+						i += shards[n].base_clean_retired(max - i);
+						shards[n].reclaim();
+					}
+
+					return i;
+				}
+
+				__forceinline size_t base_size()
+				{
+					size_t total = 0;
+					for (shard& s : shards)
+					{
+						std::shared_lock<std::shared_mutex> lk(s.lock);
+						total += s.slots.size();
+					}
+
+					return total;
+				}
+
+				__forceinline size_t base_erase(const K& key)
+				{
+					shard& s = shard_of(key);
+					write_lock lk(s);
+
+					// every object was handed out by emplace, so its last strong_ptr always cleans it up
+					const size_t slot = s.slots.find_slot(key);
+					if (slot == s.slots.npos)
+						return 0;
+
+					s.slots.unlink(slot);
+					return 1;
+				}
+
+				__forceinline bool base_exists(const K& key)
+				{
+					shard& s = shard_of(key);
+					std::shared_lock<std::shared_mutex> lk(s.lock);
+					return s.slots.count_key(key);
+				}
+
+				__forceinline std::pair<V*, base_counter*> base_get(const K& key)
+				{
+					shard& s = shard_of(key);
+					std::shared_lock<std::shared_mutex> lk(s.lock);
+					return s.base_get(key);
+				}
+
+				// neither the lock nor the counter is touched (keys that aren't trivially copyable take the read lock): the caller's
+				// epoch_guard keeps the table's old memory around, and EPOCH destructs a released object a grace period after
+				// it's unlinked, see details::epoch::grace. A few tries while writers keep the shard busy, then the read lock
+				__forceinline V* base_find_pinned(const K& key)
+				{
+					shard& s = shard_of(key);
+
+					if constexpr (std::is_trivially_copyable_v<K>)
+					{
+						for (size_t attempt = 0; attempt < 4; ++attempt)
+						{
+							const size_t slot = s.slots.find_slot_optimistic(key, s.version);
+							if (slot == s.slots.retry)
+								continue;
+
+							if (slot == s.slots.npos || s.slots.meta(slot)->strong_count() == 0)
+								return nullptr;
+
+							return s.slots.value(slot);
+						}
+					}
+
+					std::shared_lock<std::shared_mutex> lk(s.lock);
+					return s.base_find_pinned(key);
+				}
+
+				// func runs while the shard is locked for reading, it shouldn't change this map
+				template<class _Func>
+				__forceinline void base_for_each(_Func&& func)
+				{
+					for (shard& s : shards)
+					{
+						std::shared_lock<std::shared_mutex> lk(s.lock);
+						s.base_for_each(func);
+					}
+				}
+
+				__forceinline std::size_t base_garbage_size()
+				{
+					size_t total = 0;
+					for (shard& s : shards)
+						total += s.base_garbage_size();
+
+					return total;
+				}
+
+				__forceinline bool base_garbage_empty()
+				{
+					return base_garbage_size() == 0;
+				}
+			};
 		}
 
-		template<class K, class V, CLEAN_PROC clean_proc = CLEAN_PROC::DIRECT>
-		class unordered_map : private details::base_unordered_map<K, V>, public details::icontainer
+		// backend: map_backend::node (std::unordered_map), map_backend::flat (details::flat_table) or map_backend::sharded.
+		// EPOCH needs the sharded backend: a released object is unlinked by whichever thread lets go of it last, the node and
+		// flat tables can't be changed while other threads look up keys.
+		template<class K, class V, CLEAN_PROC clean_proc = CLEAN_PROC::DIRECT, class backend = map_backend::node>
+		class unordered_map : private details::base_unordered_map<K, V, backend>, public details::icontainer
 		{
+			static_assert(clean_proc != CLEAN_PROC::EPOCH || backend::concurrent, "CLEAN_PROC::EPOCH maps need map_backend::sharded");
 		private:
-			typedef details::base_unordered_map<K, V> BASE_MAP;
+			typedef details::base_unordered_map<K, V, backend> BASE_MAP;
+
+			// emplace / release totals, see CPPU_CGC_STATS
+			details::stat_counters<> counts;
 
 		public:
-			unordered_map()
+			typedef typename BASE_MAP::iterator iterator;
+
+			explicit unordered_map(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+				: BASE_MAP(resource)
 			{ }
 
 			// This one shouldn't be called unless all of the members are not being used anymore anywhere.
@@ -147,32 +704,44 @@ namespace cppu
 			template<class... _Args>
 			inline strong_ptr<V> emplace(const K& key, _Args&&... arguments)
 			{
-				V* object = BASE_MAP::base_emplace(key, std::forward<_Args>(arguments)...);
-				return constructor::construct_pointer(object, new details::key_counter<K>(this, key, details::destructor::create_destructor<V>()));
+				counts.add_emplaced(1);
+				std::pair<V*, details::base_counter*> object = BASE_MAP::template base_emplace_counted<false>(this, key, std::forward<_Args>(arguments)...);
+				return constructor::construct_pointer(object.first, object.second);
 			}
 
-			virtual bool add_as_garbage(void* ptr, const details::base_counter* c)
+			bool add_as_garbage(void* ptr, const details::base_counter* c) override
 			{
+				counts.add_released(1);
+
 				if constexpr (clean_proc == CLEAN_PROC::DIRECT)
-					BASE_MAP::base_destruct_slot(static_cast<const details::key_counter<K>*>(c)->get_key());
+					BASE_MAP::base_destruct_counted(c);
+				else if constexpr (clean_proc == CLEAN_PROC::EPOCH)
+					BASE_MAP::base_retire(c);
 				else
 				{
 					BASE_MAP::base_add_as_garbage(ptr, c);
 
+					// coalesced by the cleaner, only the first call while dirty lists this container
 					if constexpr (clean_proc == CLEAN_PROC::THREAD)
-					{
-						if (BASE_MAP::garbage.size() == 1)
-							details::garbage_cleaner::add_to_clean(this);
-					}
+						details::garbage_cleaner::add_to_clean(this);
 				}
 
 				return true;
 			}
 
-			virtual uint clean_garbage(uint max = std::numeric_limits<uint>::max())
+			void release(const details::base_counter* c) override
+			{
+				BASE_MAP::base_release(c);
+			}
+
+			size_t clean_garbage(size_t max = std::numeric_limits<size_t>::max()) override
 			{
+				details::trace_scope trace("cgc::clean_garbage", this);
+
 				if constexpr (clean_proc == CLEAN_PROC::DIRECT)
 					return max;
+				else if constexpr (clean_proc == CLEAN_PROC::EPOCH)
+					return BASE_MAP::base_clean_retired(max);
 				else
 					return BASE_MAP::base_clean_garbage(max);
 			}
@@ -184,7 +753,7 @@ namespace cppu
 
 			inline V& operator[] (K key)
 			{
-				return BASE_MAP::base_slots(key);
+				return BASE_MAP::base_slots(this, key);
 			}
 
 			inline V& front()
@@ -197,29 +766,55 @@ namespace cppu
 				return BASE_MAP::base_back();
 			}
 
-			inline typename std::unordered_map<K, V>::iterator erase(const K& key)
+			inline size_t erase(const K& key)
 			{
 				return BASE_MAP::base_erase(key);
 			}
 
-			inline typename std::unordered_map<K, V>::iterator find(const K& obj)
+			inline iterator find(const K& obj)
 			{
 				return BASE_MAP::base_find(obj);
 			}
 
-			inline typename std::unordered_map<K, V>::iterator begin()
+			inline iterator begin()
 			{
 				return BASE_MAP::base_begin();
 			}
 
-			inline typename std::unordered_map<K, V>::iterator end()
+			inline iterator end()
 			{
 				return BASE_MAP::base_end();
 			}
 
-			inline bool exists(K& key)
+			inline bool exists(const K& key)
+			{
+				return BASE_MAP::base_exists(key);
+			}
+
+			// strong_ptr to the object of the key, nullptr when it isn't there or is being released (flat and sharded backends)
+			inline strong_ptr<V> get(const K& key)
 			{
-				return BASE_MAP::exists(key);
+				std::pair<V*, details::base_counter*> object = BASE_MAP::base_get(key);
+				if (object.first == nullptr)
+					return nullptr;
+
+				// the pointer takes over the strong reference base_get took to keep it alive
+				return constructor::adopt_pointer(object.first, object.second);
+			}
+
+			// plain pointer to the object of the key without touching its reference count, nullptr when it isn't there or is
+			// being released. Only valid while the calling thread holds the epoch_guard it was looked up under
+			inline V* find_pinned(const K& key)
+			{
+				static_assert(clean_proc == CLEAN_PROC::EPOCH, "find_pinned() needs CLEAN_PROC::EPOCH, other modes may destruct the object right away");
+				return BASE_MAP::base_find_pinned(key);
+			}
+
+			// func(const K&, V&) for every element
+			template<class _Func>
+			inline void for_each(_Func&& func)
+			{
+				BASE_MAP::base_for_each(std::forward<_Func>(func));
 			}
 
 			inline std::size_t garbage_size()
@@ -227,7 +822,7 @@ namespace cppu
 				if constexpr (clean_proc == CLEAN_PROC::DIRECT)
 					return 0;
 				else
-					return BASE_MAP::garbage_size();
+					return BASE_MAP::base_garbage_size();
 			}
 
 			inline bool garbage_empty()
@@ -235,7 +830,18 @@ namespace cppu
 				if constexpr (clean_proc == CLEAN_PROC::DIRECT)
 					return true;
 				else
-					return BASE_MAP::garbage_empty();
+					return BASE_MAP::base_garbage_empty();
+			}
+
+			// live objects, objects waiting for a clean up, emplace / release totals (CPPU_CGC_STATS), free and blocks stay 0
+			container_stats stats()
+			{
+				container_stats s;
+				s.live = size();
+				s.garbage = garbage_size();
+				counts.fill(s);
+				s.time = details::stats_now();
+				return s;
 			}
 		};
 	}
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "function.h"
+#include "details/epoch.h"
+#include "dtypes.h"
+
+namespace cppu
+{
+	// handed out by delegate::subscribe(), unsubscribes in O(1)
+	struct delegate_token
+	{
+		uint32 id = ~uint32(0);
+
+		inline explicit operator bool() const noexcept
+		{
+			return id != ~uint32(0);
+		}
+	};
+
+	template <typename _Sig>
+	class delegate;
+
+	// Multicast delegate (an event with a list of subscribers).
+	// Subscribers sit next to each other in an immutable snapshot, invoke() pins the epoch and calls the current one
+	// without a lock. Subscribing builds a new snapshot (copy on write, under a writer lock) and retires the old one in the
+	// epoch, targets are copied then so keep their captures small (embedded or member functions copy as two words).
+	// Unsubscribing only flags the target in the current snapshot, the flagged ones are dropped on the next rebuild (or once
+	// they're half of the snapshot). An invoke that already started may still call a target that's just been unsubscribed.
+	// Return values are ignored. Define CPPU_FUNCTION_ENABLE_JUMP_RESOLVE to have the targets call straight into the functions.
+	template<typename _R, typename... _Args>
+	class delegate<_R(_Args...)>
+	{
+	private:
+		struct entry
+		{
+			function<_R(_Args...)> target;
+			std::atomic<bool> alive;
+			uint32 id;
+
+			entry()
+				: alive(false)
+				, id(0)
+			{ }
+		};
+
+		struct snapshot
+		{
+			const size_t count;
+			std::unique_ptr<entry[]> entries;
+			snapshot* retiredNext = nullptr;
+
+			explicit snapshot(size_t count)
+				: count(count)
+				, entries(count > 0 ? new entry[count] : nullptr)
+			{ }
+		};
+
+		std::atomic<snapshot*> current;
+
+		// writer side
+		std::mutex lock;
+		std::vector<uint32> positions; // per token id, the position in the current snapshot
+		std::vector<uint32> freeIds;
+		size_t dead = 0;
+		snapshot* retired[details::epoch::buckets] = {};
+
+		static constexpr uint32 unused = ~uint32(0);
+
+		// expects the lock, copies the living targets of the current snapshot plus `add` and publishes the result
+		void rebuild(const function<_R(_Args...)>* add, uint32 addId)
+		{
+			details::epoch_guard guard;
+
+			snapshot* old = current.load(std::memory_order_relaxed);
+			const size_t living = (old != nullptr ? old->count : 0) - dead + (add != nullptr ? 1 : 0);
+
+			snapshot* next = new snapshot(living);
+			size_t n = 0;
+			if (old != nullptr)
+			{
+				for (size_t i = 0; i < old->count; ++i)
+				{
+					entry& e = old->entries[i];
+					if (e.alive.load(std::memory_order_relaxed))
+					{
+						next->entries[n].target = e.target;
+						next->entries[n].id = e.id;
+						next->entries[n].alive.store(true, std::memory_order_relaxed);
+						positions[e.id] = uint32(n++);
+					}
+				}
+			}
+
+			if (add != nullptr)
+			{
+				next->entries[n].target = *add;
+				next->entries[n].id = addId;
+				next->entries[n].alive.store(true, std::memory_order_relaxed);
+				positions[addId] = uint32(n);
+			}
+
+			dead = 0;
+			current.store(next, std::memory_order_release);
+
+			// retired under this guard's epoch, the pins of earlier rebuilds were never later than it
+			const size_t retireBucket = details::epoch::retire_bucket(guard.epoch());
+			const size_t freeBucket = details::epoch::reclaim_bucket(guard.epoch());
+			assert(retireBucket != freeBucket && "the snapshot invoke() walks would be freed");
+
+			if (old != nullptr)
+			{
+				snapshot*& bucket = retired[retireBucket];
+				old->retiredNext = bucket;
+				bucket = old;
+				details::epoch::try_advance();
+			}
+
+			// nobody can be reading these anymore, see details::epoch::grace
+			snapshot*& done = retired[freeBucket];
+			free_list(done);
+			done = nullptr;
+		}
+
+		static void free_list(snapshot* s)
+		{
+			while (s != nullptr)
+			{
+				snapshot* next = s->retiredNext;
+				delete s;
+				s = next;
+			}
+		}
+
+	public:
+		delegate()
+			: current(nullptr)
+		{ }
+
+		delegate(const delegate&) = delete;
+		delegate& operator=(const delegate&) = delete;
+
+		// no invoke() may be running
+		~delegate()
+		{
+			delete current.load();
+			for (snapshot* bucket : retired)
+				free_list(bucket);
+		}
+
+		delegate_token subscribe(const function<_R(_Args...)>& target)
+		{
+			std::lock_guard<std::mutex> lk(lock);
+
+			uint32 id;
+			if (!freeIds.empty())
+			{
+				id = freeIds.back();
+				freeIds.pop_back();
+			}
+			else
+			{
+				id = uint32(positions.size());
+				positions.push_back(unused);
+			}
+
+			rebuild(&target, id);
+			return { id };
+		}
+
+		// false if the token isn't (or no longer) subscribed
+		bool unsubscribe(delegate_token& token)
+		{
+			std::lock_guard<std::mutex> lk(lock);
+			if (!token || token.id >= positions.size() || positions[token.id] == unused)
+				return false;
+
+			snapshot* s = current.load(std::memory_order_relaxed);
+			s->entries[positions[token.id]].alive.store(false, std::memory_order_relaxed);
+			positions[token.id] = unused;
+			freeIds.push_back(token.id);
+			token.id = unused;
+
+			// compaction every count / 2 removals keeps it O(1) per unsubscribe
+			if (++dead * 2 >= s->count)
+				rebuild(nullptr, 0);
+
+			return true;
+		}
+
+		// living targets, may be off while other threads (un)subscribe
+		size_t size() const
+		{
+			details::epoch_guard guard;
+			snapshot* s = current.load(std::memory_order_acquire);
+			if (s == nullptr)
+				return 0;
+
+			size_t n = 0;
+			for (size_t i = 0; i < s->count; ++i)
+				n += s->entries[i].alive.load(std::memory_order_relaxed);
+
+			return n;
+		}
+
+		// calls every subscriber in subscription order, no lock
+		void invoke(_Args... args) const
+		{
+			details::epoch_guard guard;
+			snapshot* s = current.load(std::memory_order_acquire);
+			if (s == nullptr)
+				return;
+
+			for (entry* e = s->entries.get(), *end = e + s->count; e != end; ++e)
+			{
+				if (e->alive.load(std::memory_order_relaxed))
+					e->target(args...);
+			}
+		}
+
+		inline void operator()(_Args... args) const
+		{
+			invoke(args...);
+		}
+
+		// invokes every subscriber for each element of [first, last) (the arguments, or a tuple of them), one subscriber
+		// at a time so its code stays hot for the whole batch. All of it runs on one snapshot
+		template<typename _It>
+		void invoke_batch(_It first, _It last) const
+		{
+			details::epoch_guard guard;
+			snapshot* s = current.load(std::memory_order_acquire);
+			if (s == nullptr)
+				return;
+
+			for (entry* e = s->entries.get(), *end = e + s->count; e != end; ++e)
+			{
+				if (!e->alive.load(std::memory_order_relaxed))
+					continue;
+
+				const function<_R(_Args...)>& target = e->target;
+				for (_It it = first; it != last; ++it)
+				{
+					if constexpr (sizeof...(_Args) == 1)
+						target(*it);
+					else
+						std::apply(target, *it);
+				}
+			}
+		}
+	};
+}
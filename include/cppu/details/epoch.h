@@ -0,0 +1,237 @@
+#pragma once
+
+#include <atomic>
+
+#include "../dtypes.h"
+
+namespace cppu
+{
+	namespace details
+	{
+		class epoch_guard;
+
+		// Global epoch, for CLEAN_PROC::EPOCH containers, delegate snapshots and the segments of the unbounded queues.
+		// Threads pin the epoch they start reading in, the epoch only moves forward once every pinned thread has seen the
+		// current one. An object retired by a thread pinned at e can't be reached by anyone once the epoch is e + grace.
+		class epoch
+		{
+			friend class epoch_guard;
+		public:
+			// the epoch is e or e + 1 while the retiring thread is pinned at e, readers that found the object are pinned at
+			// e + 1 at most and those hold the epoch back until e + 2
+			static constexpr uint64 grace = 3;
+
+			// retired objects are kept per epoch modulo buckets. Pins that overlap are at most 1 apart, so while a cleaner
+			// is pinned at e others retire into e - 1 up to e + 1 and the bucket of e - grace is left alone
+			static constexpr size_t buckets = grace + 2;
+
+			// the bucket a thread pinned at `pinned` retires into
+			static constexpr size_t retire_bucket(uint64 pinned)
+			{
+				return size_t(pinned % buckets);
+			}
+
+			// the bucket a cleaner pinned at `pinned` may reclaim, never one that's being retired into
+			static constexpr size_t reclaim_bucket(uint64 pinned)
+			{
+				return size_t((pinned + buckets - grace) % buckets);
+			}
+
+		private:
+			struct record
+			{
+				// (epoch << 1) | 1 while pinned, 0 otherwise
+				std::atomic<uint64> state = 0;
+				std::atomic<bool> used = true;
+				size_t depth = 0; // nested guards, owner thread only
+				record* next = nullptr;
+			};
+
+			// records are reused by new threads and never freed
+			struct owner
+			{
+				record* rec;
+
+				owner()
+					: rec(acquire())
+				{ }
+
+				~owner()
+				{
+					rec->used.store(false);
+				}
+			};
+
+			static std::atomic<uint64>& global() { static std::atomic<uint64> v = 0; return v; }
+			static std::atomic<record*>& records() { static std::atomic<record*> v = nullptr; return v; }
+
+			static record* acquire()
+			{
+				for (record* r = records().load(); r != nullptr; r = r->next)
+				{
+					bool used = false;
+					if (!r->used.load() && r->used.compare_exchange_strong(used, true))
+						return r;
+				}
+
+				record* r = new record();
+				record* head = records().load();
+				do
+					r->next = head;
+				while (!records().compare_exchange_weak(head, r));
+
+				return r;
+			}
+
+			static record& local()
+			{
+				thread_local owner o;
+				return *o.rec;
+			}
+
+			// returns the pinned epoch, the global one was still at it after the pin became visible
+			static uint64 enter()
+			{
+				record& r = local();
+				if (r.depth++ == 0)
+				{
+					uint64 e = global().load();
+					for (;;)
+					{
+						r.state.store((e << 1) | 1);
+
+						// nothing this thread reads may be loaded before the pin is visible to try_advance()
+						std::atomic_thread_fence(std::memory_order_seq_cst);
+
+						// the epoch may have moved on while this thread wasn't counted as pinned yet (between the load and
+						// the store), pinning that stale epoch would let a cleaner reclaim the bucket retire() fills now
+						const uint64 check = global().load();
+						if (check == e)
+							break;
+
+						e = check;
+					}
+				}
+
+				return r.state.load(std::memory_order_relaxed) >> 1;
+			}
+
+			static void leave()
+			{
+				record& r = local();
+				if (--r.depth == 0)
+					r.state.store(0, std::memory_order_release);
+			}
+
+		public:
+			static uint64 current()
+			{
+				return global().load();
+			}
+
+			// move the epoch forward if all pinned threads are in the current one
+			static bool try_advance()
+			{
+				uint64 e = global().load();
+				for (record* r = records().load(); r != nullptr; r = r->next)
+				{
+					uint64 state = r->state.load();
+					if ((state & 1) && (state >> 1) != e)
+						return false;
+				}
+
+				return global().compare_exchange_strong(e, e + 1);
+			}
+		};
+
+		static_assert(epoch::reclaim_bucket(8) != epoch::retire_bucket(7) && epoch::reclaim_bucket(8) != epoch::retire_bucket(8)
+			&& epoch::reclaim_bucket(8) != epoch::retire_bucket(9), "a cleaner would reclaim a bucket that's being retired into");
+
+		// Pins the current epoch, whatever is retired while the guard can still reach it stays around until the guard is gone.
+		// Guards are cheap and may be nested, cgc::epoch_guard is the same class.
+		class epoch_guard
+		{
+		private:
+			uint64 pinned;
+
+		public:
+			epoch_guard()
+				: pinned(epoch::enter())
+			{ }
+
+			~epoch_guard()
+			{
+				epoch::leave();
+			}
+
+			epoch_guard(const epoch_guard&) = delete;
+			epoch_guard& operator=(const epoch_guard&) = delete;
+
+			inline uint64 epoch() const
+			{
+				return pinned;
+			}
+		};
+
+		// Nodes retired per epoch bucket, handed out again once no pinned thread can still be looking at them.
+		// Node needs a `Node* retiredNext` member, nodes that aren't reused are deleted.
+		template<class Node>
+		class epoch_recycler
+		{
+		private:
+			std::atomic<Node*> retired[epoch::buckets];
+
+		public:
+			epoch_recycler()
+			{
+				for (std::atomic<Node*>& bucket : retired)
+					bucket.store(nullptr, std::memory_order_relaxed);
+			}
+
+			epoch_recycler(const epoch_recycler&) = delete;
+			epoch_recycler& operator=(const epoch_recycler&) = delete;
+
+			~epoch_recycler()
+			{
+				for (std::atomic<Node*>& bucket : retired)
+					free(bucket.load());
+			}
+
+			// expects the caller to be pinned at `pinned` and node to be unreachable for threads that pin after it
+			void retire(uint64 pinned, Node* node)
+			{
+				std::atomic<Node*>& bucket = retired[epoch::retire_bucket(pinned)];
+				Node* first = bucket.load();
+				do
+					node->retiredNext = first;
+				while (!bucket.compare_exchange_weak(first, node));
+
+				epoch::try_advance();
+			}
+
+			// a node nobody can see anymore or nullptr, expects the caller to be pinned at `pinned`.
+			// Takes the whole bucket, the other nodes in it are deleted
+			Node* reuse(uint64 pinned)
+			{
+				Node* node = retired[epoch::reclaim_bucket(pinned)].exchange(nullptr);
+				if (node == nullptr)
+					return nullptr;
+
+				free(node->retiredNext);
+				node->retiredNext = nullptr;
+				return node;
+			}
+
+		private:
+			static void free(Node* node)
+			{
+				while (node != nullptr)
+				{
+					Node* next = node->retiredNext;
+					delete node;
+					node = next;
+				}
+			}
+		};
+	}
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "../../dtypes.h"
+
+namespace cppu
+{
+	namespace exec
+	{
+		namespace details
+		{
+			// Chase-Lev work stealing deque of T pointers (Lê, Pop, Cohen, Zappa Nardelli: "Correct and Efficient Work-Stealing
+			// for Weak Memory Models"). The owner pushes and pops at the bottom, thieves take from the top with a CAS, the two
+			// only race for the last element. The ring doubles when full, replaced rings are kept until the deque goes away
+			// as a thief may still read from them (they add up to less than the current one).
+			template<class T>
+			class work_deque
+			{
+			private:
+				struct ring
+				{
+					const int64 capacity;
+					const int64 mask;
+					std::atomic<T*>* items;
+
+					explicit ring(int64 capacity)
+						: capacity(capacity)
+						, mask(capacity - 1)
+						, items(new std::atomic<T*>[size_t(capacity)])
+					{ }
+
+					~ring()
+					{
+						delete[] items;
+					}
+
+					// release / acquire on the slots as well, so what the item points to is published with it
+					inline T* get(int64 index) const { return items[index & mask].load(std::memory_order_acquire); }
+					inline void put(int64 index, T* item) { items[index & mask].store(item, std::memory_order_release); }
+				};
+
+				alignas(64) std::atomic<int64> top;
+				alignas(64) std::atomic<int64> bottom;
+				std::atomic<ring*> items;
+				std::vector<ring*> retired; // owner only
+
+				ring* grow(ring* current, int64 b, int64 t)
+				{
+					ring* bigger = new ring(current->capacity * 2);
+					for (int64 i = t; i < b; ++i)
+						bigger->put(i, current->get(i));
+
+					retired.push_back(current);
+					items.store(bigger, std::memory_order_release);
+					return bigger;
+				}
+
+			public:
+				explicit work_deque(int64 capacity = 256)
+					: top(0)
+					, bottom(0)
+					, items(new ring(capacity))
+				{ }
+
+				work_deque(const work_deque&) = delete;
+				work_deque& operator=(const work_deque&) = delete;
+
+				~work_deque()
+				{
+					delete items.load();
+					for (ring* r : retired)
+						delete r;
+				}
+
+				// owner only
+				void push(T* item)
+				{
+					const int64 b = bottom.load(std::memory_order_relaxed);
+					const int64 t = top.load(std::memory_order_acquire);
+					ring* r = items.load(std::memory_order_relaxed);
+					if (b - t > r->capacity - 1)
+						r = grow(r, b, t);
+
+					r->put(b, item);
+					bottom.store(b + 1, std::memory_order_release);
+				}
+
+				// owner only, newest first, nullptr when empty
+				T* pop()
+				{
+					const int64 b = bottom.load(std::memory_order_relaxed) - 1;
+					ring* r = items.load(std::memory_order_relaxed);
+					bottom.store(b, std::memory_order_relaxed);
+					std::atomic_thread_fence(std::memory_order_seq_cst);
+					int64 t = top.load(std::memory_order_relaxed);
+
+					if (t > b)
+					{
+						bottom.store(b + 1, std::memory_order_relaxed);
+						return nullptr;
+					}
+
+					T* item = r->get(b);
+					if (t == b)
+					{
+						// last one, a thief may be after it as well
+						if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+							item = nullptr;
+
+						bottom.store(b + 1, std::memory_order_relaxed);
+					}
+
+					return item;
+				}
+
+				// any thread, oldest first, nullptr when empty or when another thread got it first
+				T* steal()
+				{
+					int64 t = top.load(std::memory_order_acquire);
+					std::atomic_thread_fence(std::memory_order_seq_cst);
+					const int64 b = bottom.load(std::memory_order_acquire);
+					if (t >= b)
+						return nullptr;
+
+					T* item = items.load(std::memory_order_acquire)->get(t);
+					if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+						return nullptr;
+
+					return item;
+				}
+
+				// approximate from other threads
+				inline size_t size() const
+				{
+					const int64 b = bottom.load(std::memory_order_relaxed);
+					const int64 t = top.load(std::memory_order_relaxed);
+					return b > t ? size_t(b - t) : 0;
+				}
+
+				inline bool empty() const
+				{
+					return size() == 0;
+				}
+			};
+		}
+	}
+}
@@ -0,0 +1,315 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "details/work_deque.h"
+#include "../unique_function.h"
+#include "../stor/details/waiter.h"
+#include "../stor/lockfree/queue.h"
+#include "../dtypes.h"
+
+// Workers of scheduler::instance(), 0 picks the hardware thread count
+#ifndef CPPU_EXEC_THREADS
+#define CPPU_EXEC_THREADS 0
+#endif
+
+namespace cppu
+{
+	namespace exec
+	{
+		// workers take every high task they can find before they look at normal ones, and normal ones before low ones
+		enum class priority : uint8
+		{
+			high,
+			normal,
+			low
+		};
+
+		// Move only void() closure, closures up to 48 bytes (move only ones too) are stored in place, bigger ones go to the heap
+		typedef unique_function<void(), 48> task;
+
+		namespace details
+		{
+			struct task_node
+			{
+				task fn;
+				task_node* next = nullptr;
+			};
+
+			// Free nodes of the calling thread, tasks posted and run by workers don't touch the allocator once these are warm.
+			// A stolen node is given back on the thief's side, a list that grows past max_count hands the rest to the heap.
+			class node_cache
+			{
+			private:
+				static constexpr size_t max_count = 1024;
+
+				task_node* head = nullptr;
+				size_t count = 0;
+
+			public:
+				~node_cache()
+				{
+					while (head != nullptr)
+					{
+						task_node* next = head->next;
+						delete head;
+						head = next;
+					}
+				}
+
+				static node_cache& local() { thread_local node_cache v; return v; }
+
+				inline task_node* acquire()
+				{
+					if (head == nullptr)
+						return new task_node();
+
+					task_node* node = head;
+					head = node->next;
+					--count;
+					return node;
+				}
+
+				inline void release(task_node* node)
+				{
+					node->fn = nullptr;
+					if (count < max_count)
+					{
+						node->next = head;
+						head = node;
+						++count;
+					}
+					else
+						delete node;
+				}
+			};
+		}
+
+		// Work stealing scheduler, one worker thread per core by default.
+		// Every worker owns a Chase-Lev deque per priority, tasks posted from a worker go into its own deque (newest first,
+		// while the data is still in cache) and idle workers steal the oldest ones. Tasks posted from other threads, and deferred
+		// ones, go into a lock-free queue per priority that every worker checks after its own deque.
+		// Workers with nothing to do spin shortly and then sleep on a futex, every post wakes one of them (if any is asleep).
+		// Tasks shouldn't block for long, they hold a worker meanwhile. A task that throws ends the program (like a std::thread).
+		class scheduler
+		{
+		public:
+			static constexpr size_t priorities = 3;
+
+		private:
+			static constexpr size_t spin_rounds = 64;
+
+			struct alignas(64) worker
+			{
+				details::work_deque<details::task_node> deques[priorities];
+				std::thread thread;
+			};
+
+			struct current_t
+			{
+				scheduler* owner = nullptr;
+				worker* self = nullptr;
+			};
+
+			static current_t& current() { thread_local current_t v; return v; }
+
+			std::vector<std::unique_ptr<worker>> pool;
+			stor::lockfree::queue<task> injected[priorities];
+			std::atomic<int64> injectedCount[priorities];
+
+			// posted but not taken yet, sleeping workers wake up when it's above 0
+			alignas(64) std::atomic<int64> queued;
+			std::atomic<bool> stopping;
+			stor::details::waiter idle;
+
+			inline void run(details::task_node* node)
+			{
+				queued.fetch_sub(1, std::memory_order_relaxed);
+				node->fn();
+				details::node_cache::local().release(node);
+			}
+
+			// runs one task, own deque first, then the shared queue, then the other workers, per priority. False if none was found
+			bool run_one(worker* self, size_t start)
+			{
+				for (size_t p = 0; p < priorities; ++p)
+				{
+					if (self != nullptr)
+					{
+						if (details::task_node* node = self->deques[p].pop())
+						{
+							run(node);
+							return true;
+						}
+					}
+
+					if (injectedCount[p].load(std::memory_order_relaxed) > 0)
+					{
+						task t;
+						if (injected[p].try_pop(t))
+						{
+							injectedCount[p].fetch_sub(1, std::memory_order_relaxed);
+							queued.fetch_sub(1, std::memory_order_relaxed);
+							t();
+							return true;
+						}
+					}
+
+					for (size_t i = 0; i < pool.size(); ++i)
+					{
+						worker* victim = pool[(start + i) % pool.size()].get();
+						if (victim == self)
+							continue;
+
+						if (details::task_node* node = victim->deques[p].steal())
+						{
+							run(node);
+							return true;
+						}
+					}
+				}
+
+				return false;
+			}
+
+			void thread_function(size_t index)
+			{
+				worker* self = pool[index].get();
+				current() = { this, self };
+
+				// victims are tried from a different worker every round
+				size_t start = index + 1;
+				while (!stopping.load(std::memory_order_relaxed))
+				{
+					if (run_one(self, start++))
+						continue;
+
+					bool found = false;
+					for (size_t i = 0; i < spin_rounds && !found; ++i)
+					{
+						std::this_thread::yield();
+						found = run_one(self, start++);
+					}
+
+					if (!found)
+						idle.wait_until([this]() { return stopping.load() || queued.load() > 0; });
+				}
+
+				current() = {};
+			}
+
+			// a sleeper per task, workers that are awake see the count before they go to sleep
+			inline void after_post()
+			{
+				queued.fetch_add(1);
+				idle.notify_one();
+			}
+
+		public:
+			explicit scheduler(size_t threads = 0)
+				: queued(0)
+				, stopping(false)
+			{
+				for (std::atomic<int64>& count : injectedCount)
+					count.store(0);
+
+				threads = threads > 0 ? threads : std::max<size_t>(1, std::thread::hardware_concurrency());
+				for (size_t i = 0; i < threads; ++i)
+					pool.emplace_back(new worker());
+
+				for (size_t i = 0; i < threads; ++i)
+					pool[i]->thread = std::thread(&scheduler::thread_function, this, i);
+			}
+
+			scheduler(const scheduler&) = delete;
+			scheduler& operator=(const scheduler&) = delete;
+
+			// tasks that didn't run yet are dropped
+			~scheduler()
+			{
+				stopping.store(true);
+				idle.notify();
+
+				for (std::unique_ptr<worker>& w : pool)
+					w->thread.join();
+
+				// straight to the heap, the calling thread's cache may already be gone at exit
+				for (std::unique_ptr<worker>& w : pool)
+				{
+					for (details::work_deque<details::task_node>& deque : w->deques)
+					{
+						while (details::task_node* node = deque.pop())
+							delete node;
+					}
+				}
+			}
+
+			// shared by everything that doesn't bring its own, CPPU_EXEC_THREADS workers
+			static scheduler& instance()
+			{
+				static scheduler v(CPPU_EXEC_THREADS);
+				return v;
+			}
+
+			inline size_t workers() const
+			{
+				return pool.size();
+			}
+
+			// true on the workers of this scheduler
+			inline bool inside() const
+			{
+				return current().owner == this;
+			}
+
+			// any thread, from a worker the task goes into the worker's own deque
+			template<class F>
+			void post(F&& fn, priority p = priority::normal)
+			{
+				current_t& c = current();
+				if (c.owner == this)
+				{
+					details::task_node* node = details::node_cache::local().acquire();
+					node->fn = task(std::forward<F>(fn));
+					c.self->deques[size_t(p)].push(node);
+				}
+				else
+				{
+					injected[size_t(p)].emplace(std::forward<F>(fn));
+					injectedCount[size_t(p)].fetch_add(1);
+				}
+
+				after_post();
+			}
+
+			// any thread, always through the shared queue: queues behind what's already there, for tasks that post themselves again
+			template<class F>
+			void defer(F&& fn, priority p = priority::normal)
+			{
+				injected[size_t(p)].emplace(std::forward<F>(fn));
+				injectedCount[size_t(p)].fetch_add(1);
+				after_post();
+			}
+
+			// runs tasks on the calling thread until done() returns true, lets a task wait for the tasks it posted
+			template<class _Done>
+			void help_until(_Done&& done)
+			{
+				current_t& c = current();
+				worker* self = c.owner == this ? c.self : nullptr;
+
+				size_t start = 0;
+				while (!done())
+				{
+					if (!run_one(self, start++))
+						std::this_thread::yield();
+				}
+			}
+		};
+	}
+}
@@ -1,8 +1,21 @@
 #pragma once
 
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
 #include <type_traits>
 #include <memory>
 
+#ifndef WIN32
+#define __forceinline __attribute__((always_inline))
+#endif
+
+#ifdef _MSC_VER
+#define CPPU_NOVTABLE __declspec(novtable)
+#else
+#define CPPU_NOVTABLE
+#endif
+
 namespace cppu
 {
 	namespace details
@@ -44,52 +57,70 @@ namespace cppu
 		class closure_t;
 
 		template <>
-		class __declspec(novtable) closure_t<dummy> : public dummy
+		class CPPU_NOVTABLE closure_t<dummy> : public dummy
 		{
 		public:
 			virtual closure_t* copy() const = 0;
 			virtual void destruct() = 0;
+
+			// the payload (the dummy the member functions are called on) sits right behind the vtable ptr, not every ABI
+			// places the empty dummy base there so we use the offset instead of a static_cast
+			static dummy* payload(closure_t* closure) noexcept
+			{
+				return reinterpret_cast<dummy*>(reinterpret_cast<char*>(closure) + sizeof(closure_t));
+			}
+
+			static closure_t* from_payload(dummy* ptr) noexcept
+			{
+				return reinterpret_cast<closure_t*>(reinterpret_cast<char*>(ptr) - sizeof(closure_t));
+			}
 		};
 
 		template <typename _B>
-		class closure_t : public closure_t<dummy>
+		class closure_t final : public closure_t<dummy>
 		{
-		public:
-			closure_t() = default;
+		private:
+			inline _B* data() const noexcept
+			{
+				return reinterpret_cast<_B*>(payload(const_cast<closure_t*>(this)));
+			}
+
+#ifndef _WIN32
+			static constexpr size_t align = alignof(_B) > alignof(closure_t<>) ? alignof(_B) : alignof(closure_t<>);
+			static constexpr size_t offset = (sizeof(closure_t<>) + alignof(_B) - 1) / alignof(_B) * alignof(_B) - sizeof(closure_t<>);
+#endif
 
+		public:
 			closure_t(const _B& copy)
 			{
-				new (static_cast<dummy*>(this)) _B(copy);
+				new (data()) _B(copy);
 			}
 
 			closure_t(_B&& move)
 			{
-				new (static_cast<dummy*>(this)) _B(std::move(move));
+				new (data()) _B(std::move(move));
 			}
 
 			virtual closure_t* copy() const
 			{
-				auto ptr = new closure_t();
-				auto* data = (const _B*)static_cast<const dummy*>(this);
-				new (static_cast<dummy*>(ptr)) _B(*data);
-				return ptr;
+				return new closure_t(*data());
 			}
 
 			virtual void destruct()
 			{
-				reinterpret_cast<_B*>(static_cast<dummy*>(this))->~_B();
-				delete static_cast<closure_t*>(this);
+				data()->~_B();
+				delete this;
 			}
 
-			// Force _B alignment (where our dummy is) but still keep the vtable ptr on the left of it
-			void* operator new(size_t size)
+			// Force _B alignment (where our payload is) but still keep the vtable ptr on the left of it
+			void* operator new(size_t)
 			{
 #ifdef _WIN32
 				return _aligned_offset_malloc(sizeof(closure_t<>) + sizeof(_B), alignof(_B), sizeof(closure_t<>));
 #else
-				constexpr size_t align = std::max(sizeof(_B), sizeof(closure_t<>));
-				constexpr size_t size = align + sizeof(_B);
-				return (void*)((uintptr_t)std::aligned_alloc(align, size) + (align - sizeof(closure_t<>)));
+				// aligned_alloc wants a multiple of the alignment
+				constexpr size_t total = (offset + sizeof(closure_t<>) + sizeof(_B) + align - 1) / align * align;
+				return static_cast<char*>(std::aligned_alloc(align, total)) + offset;
 #endif
 			}
 
@@ -99,8 +130,7 @@ namespace cppu
 #ifdef _WIN32
 				_aligned_free(ptr);
 #else
-				constexpr size_t align = std::max(sizeof(_B), sizeof(closure_t<>));
-				std::free((void*)((uinptr_t)ptr - (align - sizeof(closure_t<>))));
+				std::free(static_cast<char*>(ptr) - offset);
 #endif
 			}
 		};
@@ -165,10 +195,10 @@ namespace cppu
 			SHIFT = std::numeric_limits<uintptr_t>::digits - 2,
 			MASK = uintptr_t(0b11) << SHIFT,
 
-			TARGET_UNOWNED_SHIFTED = TARGET_UNOWNED << SHIFT,
-			TARGET_OWNED_SHIFTED = TARGET_OWNED << SHIFT,
-			TARGET_EMBEDDED_SHIFTED = TARGET_EMBEDDED << SHIFT,
-			TARGET_LESS_SHIFTED = TARGET_LESS << SHIFT
+			TARGET_UNOWNED_SHIFTED = uintptr_t(TARGET_UNOWNED) << SHIFT,
+			TARGET_OWNED_SHIFTED = uintptr_t(TARGET_OWNED) << SHIFT,
+			TARGET_EMBEDDED_SHIFTED = uintptr_t(TARGET_EMBEDDED) << SHIFT,
+			TARGET_LESS_SHIFTED = uintptr_t(TARGET_LESS) << SHIFT
 		};
 
 		union target_t
@@ -182,7 +212,7 @@ namespace cppu
 			target_t(std::nullptr_t) noexcept : target_t() { }
 
 			target_t(details::dummy* ptr) noexcept : _ptr(ptr) { }
-			target_t(details::closure_t<>* ptr) noexcept : _ptr(static_cast<details::dummy*>(ptr)) { }
+			target_t(details::closure_t<>* ptr) noexcept : _ptr(details::closure_t<>::payload(ptr)) { }
 
 			void operator=(std::nullptr_t) noexcept { _ptr = nullptr; }
 			void operator=(const target_t& copy) noexcept { _ptr = copy._ptr; }
@@ -201,10 +231,10 @@ namespace cppu
 			func_t() noexcept = default;
 			func_t(const func_t&) noexcept = default;
 			func_t(func_t&& move) noexcept : _member(move._member) { move._member = nullptr; }
-			func_t(std::nullptr_t) noexcept : target_t() { }
+			func_t(std::nullptr_t) noexcept : _member(nullptr) { }
 
 			func_t(_R(details::dummy::* func)(_Args...)) noexcept : _member(details::resolve_jumps(func)) { }
-			func_t(_R(*func)(_Args...)) noexcept : _static(details::resolve_jumps(func)) { }
+			func_t(_R(*func)(_Args...)) noexcept : _member(nullptr) { _static = details::resolve_jumps(func); }
 
 			void operator=(_R(details::dummy::* func)(_Args...)) noexcept { _member = func; }
 			void operator=(_R(*func)(_Args...)) noexcept { _static = func; }
@@ -225,14 +255,14 @@ namespace cppu
 		inline details::dummy* target_copy() const noexcept
 		{
 			return target_owned()
-				? static_cast<details::dummy*>(static_cast<details::closure_t<>*>(_target._ptr)->copy())
+				? details::closure_t<>::payload(details::closure_t<>::from_payload(_target._ptr)->copy())
 				: _target._ptr;
 		}
 
 		inline void target_destruct()
 		{
 			if (target_owned())
-				static_cast<details::closure_t<>*>(_target._ptr)->destruct();
+				details::closure_t<>::from_payload(_target._ptr)->destruct();
 		}
 
 		template<typename _Func>
@@ -311,20 +341,20 @@ namespace cppu
 		}
 
 		// lambda function
-		template<typename _Lambda, typename =
-			std::enable_if_t<details::is_lambda_invocable_v<decltype(&std::decay_t<_Lambda>::operator()), _R, _Args...>>>
+		template<typename _Lambda, typename = std::enable_if_t<!std::is_same_v<std::decay_t<_Lambda>, function>
+			&& details::is_lambda_invocable_v<decltype(&std::decay_t<_Lambda>::operator()), _R, _Args...>>>
 		function(_Lambda&& lambda) noexcept
 			: _func(reinterpret_func(&std::decay_t<_Lambda>::operator()))
 		{
 			typedef std::decay_t<_Lambda> _DecayedLambda;
 			if constexpr (details::is_embeddable_v<_DecayedLambda, sizeof(target_t)>)
 			{
-				new (&_target) _DecayedLambda(std::move(lambda));
+				new (&_target) _DecayedLambda(std::forward<_Lambda>(lambda));
 				_func._address |= tag_e::TARGET_EMBEDDED_SHIFTED;
 			}
 			else
 			{
-				new (&_target) target_t(new details::closure_t<_DecayedLambda>(std::move(lambda)));
+				new (&_target) target_t(new details::closure_t<_DecayedLambda>(std::forward<_Lambda>(lambda)));
 				_func._address |= tag_e::TARGET_OWNED_SHIFTED;
 			}
 		}
@@ -127,6 +127,9 @@
 				#define HALF_ENABLE_CPP11_HASH 1
 			#endif
 		#else
+			#if HALF_GNUC_VERSION >= 403 && !defined(HALF_ENABLE_CPP11_TYPE_TRAITS)
+				#define HALF_ENABLE_CPP11_TYPE_TRAITS 1
+			#endif
 			#if HALF_GNUC_VERSION >= 403 && !defined(HALF_ENABLE_CPP11_CSTDINT)
 				#define HALF_ENABLE_CPP11_CSTDINT 1
 			#endif
@@ -640,10 +643,10 @@ namespace half_float
 			if(exp > 16)
 			{
 				if(R == std::round_toward_infinity)
-					return hbits | 0x7C00 - (hbits>>15);
+					return hbits | (0x7C00 - (hbits>>15));
 				else if(R == std::round_toward_neg_infinity)
-					return hbits | 0x7BFF + (hbits>>15);
-				return hbits | 0x7BFF + (R!=std::round_toward_zero);
+					return hbits | (0x7BFF + (hbits>>15));
+				return hbits | (0x7BFF + (R!=std::round_toward_zero));
 			}
 			if(exp < -13)
 				value = std::ldexp(value, 24);
@@ -2,6 +2,13 @@
 
 #include <cstdint>
 #include <iostream>
+#include <string_view>
+
+#ifdef _MSC_VER
+#define CPPU_SUPPRESS_OVERFLOW_WARNING __pragma(warning(suppress : 4307))
+#else
+#define CPPU_SUPPRESS_OVERFLOW_WARNING
+#endif
 
 namespace cppu
 {
@@ -33,31 +40,31 @@ namespace cppu
 
 	constexpr hash_t hash(const char* string) noexcept
 	{
-		__pragma(warning(suppress : 4307));
+		CPPU_SUPPRESS_OVERFLOW_WARNING
 		return details::hash_function(string);
 	}
 
 	constexpr hash_t hash(const char* string, const char* end_string) noexcept
 	{
-		__pragma(warning(suppress : 4307));
+		CPPU_SUPPRESS_OVERFLOW_WARNING
 		return details::hash_function(string, end_string);
 	}
 
 	constexpr hash_t hash(const char* string, size_t size) noexcept
 	{
-		__pragma(warning(suppress : 4307));
+		CPPU_SUPPRESS_OVERFLOW_WARNING
 		return details::hash_function(string, string + size);
 	}
 
 	constexpr hash_t hash(std::string_view string) noexcept
 	{
-		__pragma(warning(suppress : 4307));
+		CPPU_SUPPRESS_OVERFLOW_WARNING
 		return details::hash_function(string.data(), string.data() + string.size());
 	}
 
 	constexpr hash_t operator "" _hash(const char* string, size_t size)
 	{
-		__pragma(warning(suppress : 4307));
+		CPPU_SUPPRESS_OVERFLOW_WARNING
 		return details::hash_function(string, string + size);
 	}
 
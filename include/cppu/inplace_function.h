@@ -0,0 +1,234 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace cppu
+{
+	namespace details
+	{
+		enum class inplace_op
+		{
+			copy,
+			move, // destructs the source as well
+			destroy
+		};
+
+		template<typename _T>
+		void inplace_manage(inplace_op op, void* from, void* to)
+		{
+			switch (op)
+			{
+			case inplace_op::copy:
+				new (to) _T(*static_cast<const _T*>(from));
+				break;
+			case inplace_op::move:
+				new (to) _T(std::move(*static_cast<_T*>(from)));
+				static_cast<_T*>(from)->~_T();
+				break;
+			case inplace_op::destroy:
+				static_cast<_T*>(from)->~_T();
+				break;
+			}
+		}
+	}
+
+	template <typename _Sig, size_t _Capacity = 32, size_t _Align = alignof(std::max_align_t)>
+	class inplace_function;
+
+	// Function wrapper that never allocates: the callable is stored in _Capacity bytes inside the object, a callable that
+	// doesn't fit is a compile error. Trivially copyable callables are copied as bytes, anything else goes through one manager
+	// function (copy, move or destroy) next to the invoker, so the overhead is two pointers.
+	template<typename _R, typename... _Args, size_t _Capacity, size_t _Align>
+	class inplace_function<_R(_Args...), _Capacity, _Align>
+	{
+		template <typename, size_t, size_t>
+		friend class inplace_function;
+	private:
+		typedef _R(*invoker_t)(void*, _Args&&...);
+		typedef void(*manager_t)(details::inplace_op, void*, void*);
+
+		alignas(_Align) unsigned char _storage[_Capacity];
+		invoker_t _invoker;
+		manager_t _manager; // nullptr for trivially copyable callables
+
+		template<typename _T>
+		static _R invoke(void* storage, _Args&&... args)
+		{
+			return (*static_cast<_T*>(storage))(std::forward<_Args>(args)...);
+		}
+
+		template<typename _T, typename... _Valty>
+		void construct(_Valty&&... _Val)
+		{
+			static_assert(sizeof(_T) <= _Capacity, "callable doesn't fit in the inplace_function, raise its capacity");
+			static_assert(alignof(_T) <= _Align, "callable needs a bigger alignment than the inplace_function has");
+
+			new (_storage) _T(std::forward<_Valty>(_Val)...);
+			_invoker = &invoke<_T>;
+
+			if constexpr (std::is_trivially_copyable_v<_T> && std::is_trivially_destructible_v<_T>)
+				_manager = nullptr;
+			else
+				_manager = &details::inplace_manage<_T>;
+		}
+
+		template <size_t _OtherCapacity, size_t _OtherAlign>
+		void copy_from(const inplace_function<_R(_Args...), _OtherCapacity, _OtherAlign>& copy)
+		{
+			if (copy._manager != nullptr)
+				copy._manager(details::inplace_op::copy, const_cast<unsigned char*>(copy._storage), _storage);
+			else
+				std::memcpy(_storage, copy._storage, _OtherCapacity);
+
+			_invoker = copy._invoker;
+			_manager = copy._manager;
+		}
+
+		template <size_t _OtherCapacity, size_t _OtherAlign>
+		void move_from(inplace_function<_R(_Args...), _OtherCapacity, _OtherAlign>& move) noexcept
+		{
+			if (move._manager != nullptr)
+				move._manager(details::inplace_op::move, move._storage, _storage);
+			else
+				std::memcpy(_storage, move._storage, _OtherCapacity);
+
+			_invoker = move._invoker;
+			_manager = move._manager;
+			move._invoker = nullptr;
+			move._manager = nullptr;
+		}
+
+		void reset() noexcept
+		{
+			if (_manager != nullptr)
+				_manager(details::inplace_op::destroy, _storage, nullptr);
+
+			_invoker = nullptr;
+			_manager = nullptr;
+		}
+
+	public:
+		static constexpr size_t capacity = _Capacity;
+
+		inplace_function() noexcept
+			: _invoker(nullptr)
+			, _manager(nullptr)
+		{ }
+
+		inplace_function(std::nullptr_t) noexcept
+			: inplace_function()
+		{ }
+
+		inplace_function(const inplace_function& copy)
+			: inplace_function()
+		{
+			copy_from(copy);
+		}
+
+		inplace_function(inplace_function&& move) noexcept
+			: inplace_function()
+		{
+			move_from(move);
+		}
+
+		// a smaller one fits as well
+		template <size_t _OtherCapacity, size_t _OtherAlign, typename = std::enable_if_t<(_OtherCapacity < _Capacity) && _OtherAlign <= _Align>>
+		inplace_function(const inplace_function<_R(_Args...), _OtherCapacity, _OtherAlign>& copy)
+			: inplace_function()
+		{
+			copy_from(copy);
+		}
+
+		template <size_t _OtherCapacity, size_t _OtherAlign, typename = std::enable_if_t<(_OtherCapacity < _Capacity) && _OtherAlign <= _Align>>
+		inplace_function(inplace_function<_R(_Args...), _OtherCapacity, _OtherAlign>&& move) noexcept
+			: inplace_function()
+		{
+			move_from(move);
+		}
+
+		// static function, lambda or any other copyable callable
+		template<typename _Func, typename _Decayed = std::decay_t<_Func>, typename = std::enable_if_t<
+			!std::is_same_v<_Decayed, inplace_function> && std::is_invocable_r_v<_R, _Decayed&, _Args...>>>
+		inplace_function(_Func&& func)
+		{
+			static_assert(std::is_copy_constructible_v<_Decayed>, "inplace_function needs a copyable callable");
+			construct<_Decayed>(std::forward<_Func>(func));
+		}
+
+		// member function
+		template<typename _B, typename _T, typename = std::enable_if_t<std::is_base_of_v<_B, _T>>>
+		inplace_function(_R(_B::* func)(_Args...), _T* target)
+		{
+			auto bound = [func, target](_Args... args) -> _R { return (static_cast<_B*>(target)->*func)(std::forward<_Args>(args)...); };
+			construct<decltype(bound)>(bound);
+		}
+
+		~inplace_function()
+		{
+			reset();
+		}
+
+		inplace_function& operator=(const inplace_function& copy)
+		{
+			if (this != &copy)
+			{
+				reset();
+				copy_from(copy);
+			}
+
+			return *this;
+		}
+
+		inplace_function& operator=(inplace_function&& move) noexcept
+		{
+			if (this != &move)
+			{
+				reset();
+				move_from(move);
+			}
+
+			return *this;
+		}
+
+		inplace_function& operator=(std::nullptr_t) noexcept
+		{
+			reset();
+			return *this;
+		}
+
+		template<typename _Func, typename _Decayed = std::decay_t<_Func>, typename = std::enable_if_t<
+			!std::is_same_v<_Decayed, inplace_function> && std::is_invocable_r_v<_R, _Decayed&, _Args...>>>
+		inplace_function& operator=(_Func&& func)
+		{
+			static_assert(std::is_copy_constructible_v<_Decayed>, "inplace_function needs a copyable callable");
+			reset();
+			construct<_Decayed>(std::forward<_Func>(func));
+			return *this;
+		}
+
+		void swap(inplace_function& other) noexcept
+		{
+			inplace_function temp(std::move(other));
+			other = std::move(*this);
+			*this = std::move(temp);
+		}
+
+		inline explicit operator bool() const noexcept
+		{
+			return _invoker != nullptr;
+		}
+
+		inline _R operator()(_Args... args) const
+		{
+			if (_invoker == nullptr)
+				throw std::bad_function_call();
+
+			return _invoker(const_cast<unsigned char*>(_storage), std::forward<_Args>(args)...);
+		}
+	};
+}
@@ -1,12 +1,17 @@
 #pragma once
 
 #include "../dtypes.h"
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <thread>
 #include <condition_variable>
 
+#include "../exec/scheduler.h"
+
 #include "./detail/config.h"
 #include <asio/io_context.hpp>
+#include <asio/executor_work_guard.hpp>
 
 namespace cppu
 {
@@ -16,10 +21,25 @@ namespace cppu
 		{
 			inline static ::asio::io_context context = {};
 
-			inline static bool threadsRunning = false;
+			inline static std::atomic<bool> threadsRunning = false;
 			inline static std::mutex threadsLock = {};
 			inline static std::vector<std::thread> threads = {};
 			inline static std::condition_variable threadsWait = {};
+
+			// Start(scheduler): keeps the context from running out of work, the reactor thread would return otherwise
+			inline static std::unique_ptr<::asio::executor_work_guard<::asio::io_context::executor_type>> work = {};
+			// Start(scheduler): where the completion callbacks run, nullptr runs them on the thread that completed the operation
+			inline static exec::scheduler* completions = nullptr;
+
+			// hands a completion callback to the scheduler, so user code never runs on (and never holds up) the reactor thread
+			template<class F>
+			inline void Complete(F&& fn)
+			{
+				if (completions != nullptr)
+					completions->post(std::forward<F>(fn));
+				else
+					fn();
+			}
 		}
 
 		inline ::asio::io_context& GetContext()
@@ -31,10 +51,17 @@ namespace cppu
 		{
 			details::threadsRunning = false;
 			details::threadsWait.notify_all();
+			details::work.reset();
 			details::context.stop();
 
 			for (std::size_t i = 0; i < details::threads.size(); ++i)
-				details::threads[i].join();
+			{
+				if (details::threads[i].joinable())
+					details::threads[i].join();
+			}
+
+			details::threads.clear();
+			details::completions = nullptr;
 		}
 
 		inline void Start(uint threads = 1)
@@ -61,5 +88,23 @@ namespace cppu
 				});
 			}
 		}
+
+		// One reactor thread blocks in the context (idle sockets cost nothing) and the completion callbacks run as tasks on scheduler.
+		// Stop() only joins the reactor, so it's fine from a worker too (but call it before the scheduler goes away)
+		inline void Start(exec::scheduler& scheduler)
+		{
+			Stop();
+
+			details::context.restart();
+			details::work.reset(new ::asio::executor_work_guard<::asio::io_context::executor_type>(details::context.get_executor()));
+			details::completions = &scheduler;
+			details::threadsRunning = true;
+
+			details::threads.emplace_back([]()
+			{
+				asio::error_code error;
+				details::context.run(error);
+			});
+		}
 	}
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../dtypes.h"
+#include "../unique_function.h"
 #include <functional>
 
 #include "./detail/config.h"
@@ -22,9 +23,9 @@ namespace cppu
 		private:
 			asio::ip::tcp::socket socket;
 
-			void ConnectHandler(const asio::error_code& error, const std::function<void(TCPSocket*, ErrorCode)>& callback)
+			void ConnectHandler(const asio::error_code& error, unique_function<void(TCPSocket*, ErrorCode)>&& callback)
 			{
-				callback(this, static_cast<ErrorCode>(error.value()));
+				details::Complete([this, code = static_cast<ErrorCode>(error.value()), callback = std::move(callback)]() { callback(this, code); });
 			}
 
 			void SendHandler(const asio::error_code& error)
@@ -94,10 +95,10 @@ namespace cppu
 				return static_cast<ErrorCode>(error.value());
 			}
 
-			void ConnectAsync(const EndPoint& remoteEndPoint, std::function<void(TCPSocket*, ErrorCode)> callback = IgnoreCallback)
+			void ConnectAsync(const EndPoint& remoteEndPoint, unique_function<void(TCPSocket*, ErrorCode)> callback = IgnoreCallback)
 			{
 				socket.async_connect(asio::ip::tcp::endpoint(remoteEndPoint.endPoint.address(), remoteEndPoint.endPoint.port()),
-					std::bind(&TCPSocket::ConnectHandler, this, std::placeholders::_1, callback));
+					[this, callback = std::move(callback)](const asio::error_code& error) mutable { ConnectHandler(error, std::move(callback)); });
 
 				details::threadsWait.notify_one();
 			}
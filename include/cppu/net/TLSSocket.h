@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../dtypes.h"
+#include "../unique_function.h"
 #include "./detail/config.h"
 
 #include <asio/ip/tcp.hpp>
@@ -43,9 +44,9 @@ namespace cppu
 			std::vector<unsigned char> buffer;
 			std::string expectedHostName;
 			
-			void ConnectHandler(const asio::error_code& error, const std::function<void(cppu::net::TLSSocket*, cppu::net::ErrorCode)>& callback)
+			void ConnectHandler(const asio::error_code& error, unique_function<void(cppu::net::TLSSocket*, cppu::net::ErrorCode)>&& callback)
 			{
-				callback(this, static_cast<ErrorCode>(error.value()));
+				details::Complete([this, code = static_cast<ErrorCode>(error.value()), callback = std::move(callback)]() { callback(this, code); });
 			}
 
 			void SendHandler(const asio::error_code& error)
@@ -155,10 +156,10 @@ namespace cppu
 				return static_cast<cppu::net::ErrorCode>(error.value());
 			}
 
-			void ConnectAsync(const EndPoint& remoteEndPoint, std::function<void(TLSSocket*, ErrorCode)> callback = IgnoreCallback)
+			void ConnectAsync(const EndPoint& remoteEndPoint, unique_function<void(TLSSocket*, ErrorCode)> callback = IgnoreCallback)
 			{
 				socket.async_connect(asio::ip::tcp::endpoint(remoteEndPoint.endPoint.address(), remoteEndPoint.endPoint.port()),
-					std::bind(&TLSSocket::ConnectHandler, this, std::placeholders::_1, callback));
+					[this, callback = std::move(callback)](const asio::error_code& error) mutable { ConnectHandler(error, std::move(callback)); });
 
 				details::threadsWait().notify_one();
 			}
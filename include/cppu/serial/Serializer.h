@@ -9,9 +9,15 @@
 #include "../stor/vector.h"
 #include "../hash.h"
 
+#include <algorithm>
+#include <cstring>
 #include <unordered_map>
 #include <deque>
+#include <list>
+#include <string>
 #include <string_view>
+#include <tuple>
+#include <vector>
 #include <assert.h>
 #include <functional>
 
@@ -58,11 +64,11 @@ namespace cppu
 			//void SetRow(Key key, ValuePos pos);
 		};
 
-		template <typename Base>
+		template <typename _Base>
 		class base
 		{
 		public:
-			typedef Base Base;
+			typedef _Base Base;
 
 			Base* ptr;
 
@@ -154,13 +160,13 @@ namespace cppu
 		public:
 			ArchiveWriter(VTableSize tableSize, ArchiveVersion version, ValuePos initialBufferSize = 1024)
 				: version(version)
-				, writePosition(sizeof(ValuePos) + sizeof(ArchiveVersion))
 				, bufferSize(initialBufferSize)
+				, writePosition(sizeof(ValuePos) + sizeof(ArchiveVersion))
 			{
 				table.rows.resize(tableSize);
 				buffer = static_cast<char*>(malloc(initialBufferSize + sizeof(ValuePos)));
 
-#if defined(DEBUG) || defined(_DEBUG)
+#ifndef NDEBUG
 				memset(buffer, 0, sizeof(ValuePos)); // can be used to check if Finish() has already been called
 #endif
 				memcpy(reinterpret_cast<ValuePos*>(buffer + sizeof(ValuePos)), &version, sizeof(ArchiveVersion));
@@ -329,6 +335,8 @@ namespace cppu
 		public:
 			ArchiveReader(const ArchiveWriter& archive)
 				: original(true)
+				, referenceTable(nullptr)
+				, references(nullptr)
 			{
 				buffer = static_cast<char*>(malloc(archive.writePosition));
 				if (buffer)
@@ -338,9 +346,10 @@ namespace cppu
 					bufferSize = reinterpret_cast<ValuePos&>(archive.buffer[0]);
 					table = reinterpret_cast<VTableRead*>(buffer + bufferSize);
 
-					if (bufferSize + table->size < archive.writePosition)
+					// a reference table follows the vtable
+					ValuePos offset = bufferSize + sizeof(table->size) + table->size * sizeof(table->rows);
+					if (offset < archive.writePosition)
 					{
-						ValuePos offset = bufferSize + sizeof(table->size) + table->size * sizeof(table->rows);
 						referenceTable = reinterpret_cast<VReferenceTableRead*>(buffer + reinterpret_cast<ValuePos&>(buffer[offset]));
 
 						references = new std::unordered_map<Reference, Pointer>();
@@ -352,6 +361,8 @@ namespace cppu
 
 			ArchiveReader(const std::string& string)
 				: original(true)
+				, referenceTable(nullptr)
+				, references(nullptr)
 			{
 				buffer = static_cast<char*>(malloc(string.size()));
 				if (buffer)
@@ -361,9 +372,10 @@ namespace cppu
 					bufferSize = reinterpret_cast<ValuePos&>(buffer[0]);
 					table = reinterpret_cast<VTableRead*>(buffer + bufferSize);
 
-					if (bufferSize + table->size < string.size())
+					// a reference table follows the vtable
+					ValuePos offset = bufferSize + sizeof(table->size) + table->size * sizeof(table->rows);
+					if (offset < string.size())
 					{
-						ValuePos offset = bufferSize + sizeof(table->size) + table->size * sizeof(table->rows);
 						referenceTable = reinterpret_cast<VReferenceTableRead*>(buffer + reinterpret_cast<ValuePos&>(buffer[offset]));
 
 						references = new std::unordered_map<Reference, Pointer>();
@@ -376,7 +388,10 @@ namespace cppu
 			~ArchiveReader()
 			{
 				if (original)
+				{
 					delete references;
+					free(buffer);
+				}
 			}
 
 			ValuePos GetVTableEntry(Key key) { return table->GetRow(key); }
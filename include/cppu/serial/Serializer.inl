@@ -47,7 +47,7 @@ namespace cppu
 
 			constexpr cppu::hash_t hash_combine(cppu::hash_t hash1, cppu::hash_t hash2)
 			{
-				return hash2 ^ hash1 + 0x9e3779b9 + (hash2 << 6) + (hash2 >> 2);
+				return hash2 ^ (hash1 + 0x9e3779b9 + (hash2 << 6) + (hash2 >> 2));
 			}
 
 			template <typename T>
@@ -133,29 +133,25 @@ namespace cppu
 			template <typename T> static Yes HasDeSerialize(TypeCheck<typename ClassDeSerialize<T>::func_ptr, &T::DeSerialize>*);
 			template <typename T> static No  HasDeSerialize(...);
 
-			template <typename T> static Yes NamespaceHasSerialize(TypeCheck<typedef void(ArchiveWriter&, const T&), &Serialize>*);
-			template <typename T> static No  NamespaceHasSerialize(...);
-
-			template <typename T> static Yes NamespaceHasDeSerialize(TypeCheck<typedef void(ArchiveReader&, T&), &DeSerialize>*);
-			template <typename T> static No  NamespaceHasDeSerialize(...);
-
 
 		public:
 			template <typename P>
 			static bool const class_construct_value = sizeof(HasConstruct<Type, P>(0)) == sizeof(Yes);
 			static bool const serialize_value = sizeof(HasSerialize<Type>(0)) == sizeof(Yes);
 			static bool const deserialize_value = sizeof(HasDeSerialize<Type>(0)) == sizeof(Yes);
-
-			static bool const namespace_serialize_value = sizeof(NamespaceHasSerialize<Type>(0)) == sizeof(Yes);
-			static bool const namespace_deserialize_value = sizeof(NamespaceHasDeSerialize<Type>(0)) == sizeof(Yes);
 		};
 
 		template<typename T, typename P> inline constexpr bool class_has_construct_v = serialize_checker<T>::template class_construct_value<P>;
 		template<typename T> inline constexpr bool class_has_serialize_v = serialize_checker<T>::serialize_value;
 		template<typename T> inline constexpr bool class_has_deserialize_v = serialize_checker<T>::deserialize_value;
 
-		template<typename T> inline constexpr bool namespace_has_serialize_v = serialize_checker<T>::namespace_serialize_value;
-		template<typename T> inline constexpr bool namespace_has_deserialize_v = serialize_checker<T>::namespace_deserialize_value;
+		template <typename T, typename = void> struct namespace_has_serialize : std::false_type {};
+		template <typename T> struct namespace_has_serialize<T, std::void_t<decltype(Serialize(std::declval<ArchiveWriter&>(), std::declval<const T&>())) >> : std::true_type {};
+		template<typename T> inline constexpr bool namespace_has_serialize_v = namespace_has_serialize<T>::value;
+
+		template <typename T, typename = void> struct namespace_has_deserialize : std::false_type {};
+		template <typename T> struct namespace_has_deserialize<T, std::void_t<decltype(DeSerialize(std::declval<ArchiveReader&>(), std::declval<T&>())) >> : std::true_type {};
+		template<typename T> inline constexpr bool namespace_has_deserialize_v = namespace_has_deserialize<T>::value;
 
 		template <typename T, typename = void> struct namespace_has_construct : std::false_type {};
 		template <typename T> struct namespace_has_construct<T, std::void_t<decltype(Construct(std::declval<ArchiveReader&>(), std::declval<T&>())) >> : std::true_type {};
@@ -473,7 +469,6 @@ namespace cppu
 				Reference reference;
 				if (referencesTaken.count(key) == 0)
 				{
-					typedef typename T::element_type ElementType;
 					auto& object = *data;
 					reference = static_cast<Reference>(references.size());
 
@@ -518,7 +513,7 @@ namespace cppu
 		template<class... TT>
 		inline bool ArchiveWriter::Write(const std::tuple<TT...>& data)
 		{
-			std::apply(Write, data);
+			return std::apply([this](const TT&... values) { return (Write(values), ...); }, data);
 		}
 
 		template<>
@@ -886,7 +881,7 @@ namespace cppu
 		inline void ArchiveReader::ReadPosition(std::tuple<TT...>& data, int position)
 		{
 			readPosition = position;
-			std::apply(Read, data);
+			std::apply([this](TT&... values) { (Read(values), ...); }, data);
 		}
 
 		inline void ArchiveReader::ReadPosition(void* data, std::size_t size, int position)
@@ -973,7 +968,7 @@ namespace cppu
 
 			ValuePos size = reinterpret_cast<ValuePos&>(buffer[readPosition]);
 			readPosition += sizeof(ValuePos);
-			ArchiveVersion version = reinterpret_cast<ArchiveVersion&>(buffer[readPosition + sizeof(ValuePos)]);
+			[[maybe_unused]] ArchiveVersion version = reinterpret_cast<ArchiveVersion&>(buffer[readPosition + sizeof(ValuePos)]);
 			//readPosition += sizeof(ArchiveVersion);
 
 			//readPosition += size; // advance past all the contents
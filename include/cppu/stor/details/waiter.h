@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <limits>
+#include <thread>
+
+#ifdef WIN32
+#include "windows.h"
+#ifdef _MSC_VER
+#pragma comment(lib, "Synchronization.lib")
+#endif
+#elif defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "../../dtypes.h"
+
+namespace cppu
+{
+	namespace stor
+	{
+		namespace details
+		{
+			// Blocks while word still holds expected, may return early (callers check their condition again)
+			inline void futex_wait(std::atomic<uint32>& word, uint32 expected)
+			{
+				static_assert(sizeof(std::atomic<uint32>) == sizeof(uint32), "futex needs a plain 32 bit word");
+#ifdef WIN32
+				WaitOnAddress(&word, &expected, sizeof(uint32), INFINITE);
+#elif defined(__linux__)
+				syscall(SYS_futex, reinterpret_cast<uint32*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+				if (word.load() == expected)
+					std::this_thread::yield();
+#endif
+			}
+
+			inline void futex_wake_all(std::atomic<uint32>& word)
+			{
+#ifdef WIN32
+				WakeByAddressAll(&word);
+#elif defined(__linux__)
+				syscall(SYS_futex, reinterpret_cast<uint32*>(&word), FUTEX_WAKE_PRIVATE, std::numeric_limits<int>::max(), nullptr, nullptr, 0);
+#else
+				(void)word;
+#endif
+			}
+
+			inline void futex_wake_one(std::atomic<uint32>& word)
+			{
+#ifdef WIN32
+				WakeByAddressSingle(&word);
+#elif defined(__linux__)
+				syscall(SYS_futex, reinterpret_cast<uint32*>(&word), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+				(void)word;
+#endif
+			}
+
+			// Lets a thread sleep until another one made progress. The waiting side announces itself before checking its
+			// condition a last time, the notifying side publishes first and only signals when someone announced,
+			// so notify() is a fence and a load when nobody waits.
+			class waiter
+			{
+			private:
+				std::atomic<uint32> signal;
+				std::atomic<uint32> waiting;
+
+			public:
+				waiter()
+					: signal(0)
+					, waiting(0)
+				{ }
+
+				// returns once ready() is true
+				template<class _Ready>
+				void wait_until(_Ready&& ready)
+				{
+					while (!ready())
+					{
+						const uint32 seen = signal.load();
+						waiting.fetch_add(1);
+
+						if (!ready())
+							futex_wait(signal, seen);
+
+						waiting.fetch_sub(1);
+					}
+				}
+
+				// call after publishing whatever the waiting side checks for
+				inline void notify()
+				{
+					std::atomic_thread_fence(std::memory_order_seq_cst);
+					if (waiting.load(std::memory_order_relaxed) != 0)
+					{
+						signal.fetch_add(1);
+						futex_wake_all(signal);
+					}
+				}
+
+				// same, but wakes a single waiter, for when one thread is enough to handle what was published
+				inline void notify_one()
+				{
+					std::atomic_thread_fence(std::memory_order_seq_cst);
+					if (waiting.load(std::memory_order_relaxed) != 0)
+					{
+						signal.fetch_add(1);
+						futex_wake_one(signal);
+					}
+				}
+			};
+		}
+	}
+}
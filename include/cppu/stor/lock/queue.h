@@ -131,8 +131,8 @@ namespace cppu
 					std::lock_guard<std::mutex> lk(lock);
 					if (!container.empty())
 					{
-						obj = std::move(container.back());
-						container.pop_back();
+						obj = std::move(container.front());
+						container.pop();
 
 						return true;
 					}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace cppu
+{
+	namespace stor
+	{
+		namespace lockfree
+		{
+			// Multi producer, multi consumer ring (D. Vyukov's bounded queue): every cell carries a sequence number that says
+			// whose turn it is, producers and consumers each claim positions with a CAS on their own counter.
+			// A producer (or consumer) that stalls between claiming a cell and publishing it holds up the ones behind it.
+			// try_push_n() / try_pop_n() claim a run of cells with one CAS.
+			template<typename T>
+			class bounded_queue
+			{
+			private:
+				struct cell
+				{
+					std::atomic<size_t> sequence;
+					union
+					{
+						T value;
+					};
+
+					cell() { }
+					~cell() { }
+				};
+
+				std::unique_ptr<cell[]> cells;
+				size_t mask;
+
+				alignas(64) std::atomic<size_t> enqueuePos;
+				alignas(64) std::atomic<size_t> dequeuePos;
+
+				static inline size_t round_capacity(size_t capacity)
+				{
+					size_t c = 2;
+					while (c < capacity)
+						c <<= 1;
+
+					return c;
+				}
+
+				// free cells from pos on, at most max
+				inline size_t count_free(size_t pos, size_t max) const
+				{
+					size_t n = 0;
+					while (n < max && cells[(pos + n) & mask].sequence.load(std::memory_order_acquire) == pos + n)
+						++n;
+
+					return n;
+				}
+
+				inline size_t count_ready(size_t pos, size_t max) const
+				{
+					size_t n = 0;
+					while (n < max && cells[(pos + n) & mask].sequence.load(std::memory_order_acquire) == pos + n + 1)
+						++n;
+
+					return n;
+				}
+
+				// claims up to max cells of the counter, returns the first position and sets claimed
+				template<bool _Push>
+				inline size_t claim(size_t max, size_t& claimed)
+				{
+					std::atomic<size_t>& counter = _Push ? enqueuePos : dequeuePos;
+					size_t pos = counter.load(std::memory_order_relaxed);
+					while (true)
+					{
+						claimed = _Push ? count_free(pos, max) : count_ready(pos, max);
+						if (claimed == 0)
+						{
+							// full (or empty), unless another thread moved the counter in the mean time
+							const size_t current = counter.load(std::memory_order_relaxed);
+							if (current == pos)
+								return pos;
+
+							pos = current;
+						}
+						else if (counter.compare_exchange_weak(pos, pos + claimed, std::memory_order_relaxed))
+							return pos;
+					}
+				}
+
+			public:
+				// capacity is rounded up to a power of two
+				explicit bounded_queue(size_t capacity = 1024)
+					: cells(new cell[round_capacity(capacity)])
+					, mask(round_capacity(capacity) - 1)
+					, enqueuePos(0)
+					, dequeuePos(0)
+				{
+					for (size_t i = 0; i <= mask; ++i)
+						cells[i].sequence.store(i, std::memory_order_relaxed);
+				}
+
+				bounded_queue(const bounded_queue&) = delete;
+				bounded_queue& operator=(const bounded_queue&) = delete;
+
+				~bounded_queue()
+				{
+					for (size_t pos = dequeuePos.load(); pos != enqueuePos.load(); ++pos)
+						cells[pos & mask].value.~T();
+				}
+
+				inline size_t capacity() const
+				{
+					return mask + 1;
+				}
+
+				// false when the queue is full
+				template<class... _Valty>
+				bool try_emplace(_Valty&&... _Val)
+				{
+					size_t claimed;
+					const size_t pos = claim<true>(1, claimed);
+					if (claimed == 0)
+						return false;
+
+					cell& c = cells[pos & mask];
+					new (&c.value) T(std::forward<_Valty>(_Val)...);
+					c.sequence.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+
+				inline bool try_push(const T& obj)
+				{
+					return try_emplace(obj);
+				}
+
+				inline bool try_push(T&& obj)
+				{
+					return try_emplace(std::move(obj));
+				}
+
+				// false when the queue is empty
+				bool try_pop(T& obj)
+				{
+					size_t claimed;
+					const size_t pos = claim<false>(1, claimed);
+					if (claimed == 0)
+						return false;
+
+					cell& c = cells[pos & mask];
+					obj = std::move(c.value);
+					c.value.~T();
+					c.sequence.store(pos + mask + 1, std::memory_order_release);
+					return true;
+				}
+
+				// pushes *first++ up to count times, as many as fit, returns the amount pushed
+				template<class _It>
+				size_t try_push_n(_It first, size_t count)
+				{
+					size_t claimed;
+					const size_t pos = claim<true>(count, claimed);
+					for (size_t i = 0; i < claimed; ++i, ++first)
+					{
+						cell& c = cells[(pos + i) & mask];
+						new (&c.value) T(*first);
+						c.sequence.store(pos + i + 1, std::memory_order_release);
+					}
+
+					return claimed;
+				}
+
+				// *out++ = value for up to max values, returns the amount popped
+				template<class _OutIt>
+				size_t try_pop_n(_OutIt out, size_t max)
+				{
+					size_t claimed;
+					const size_t pos = claim<false>(max, claimed);
+					for (size_t i = 0; i < claimed; ++i, ++out)
+					{
+						cell& c = cells[(pos + i) & mask];
+						*out = std::move(c.value);
+						c.value.~T();
+						c.sequence.store(pos + i + mask + 1, std::memory_order_release);
+					}
+
+					return claimed;
+				}
+
+				// may be off while other threads push or pop
+				inline size_t size() const
+				{
+					const size_t dequeued = dequeuePos.load(std::memory_order_relaxed);
+					const size_t enqueued = enqueuePos.load(std::memory_order_relaxed);
+					return enqueued > dequeued ? enqueued - dequeued : 0;
+				}
+
+				inline bool empty() const
+				{
+					return size() == 0;
+				}
+			};
+		}
+	}
+}
@@ -0,0 +1,326 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <utility>
+
+#include "../../details/epoch.h"
+#include "../../dtypes.h"
+
+namespace cppu
+{
+	namespace stor
+	{
+		namespace lockfree
+		{
+			// Unbounded multi producer, multi consumer queue: a list of fixed size segments (P. Ramalhete's FAA array queue).
+			// Producers and consumers take indices in the tail / head segment with a fetch_add, a consumer that gets ahead of
+			// its producer marks the cell as taken and the producer moves on to the next index. Drained segments are retired
+			// in the epoch and reused for new segments once no thread can still be looking at them.
+			// A consumer waits for a producer that claimed its cell but hasn't finished constructing the value yet.
+			template<typename T, size_t SegmentSize = 1024>
+			class queue
+			{
+			private:
+				typedef ::cppu::details::epoch_guard epoch_guard;
+
+				enum : uint32 { cell_empty, cell_writing, cell_ready, cell_done };
+
+				struct cell
+				{
+					std::atomic<uint32> state;
+					union
+					{
+						T value;
+					};
+
+					cell() { }
+					~cell() { }
+				};
+
+				struct segment
+				{
+					alignas(64) std::atomic<size_t> enqueueIndex;
+					alignas(64) std::atomic<size_t> dequeueIndex;
+					std::atomic<segment*> next;
+					// position of cells[0] since the queue started, for size()
+					size_t base;
+					segment* retiredNext;
+					cell cells[SegmentSize];
+
+					explicit segment(size_t base)
+					{
+						reset(base);
+					}
+
+					// before the segment is published
+					void reset(size_t base)
+					{
+						enqueueIndex.store(0, std::memory_order_relaxed);
+						dequeueIndex.store(0, std::memory_order_relaxed);
+						next.store(nullptr, std::memory_order_relaxed);
+						this->base = base;
+						retiredNext = nullptr;
+						for (cell& c : cells)
+							c.state.store(cell_empty, std::memory_order_relaxed);
+					}
+				};
+
+				alignas(64) std::atomic<segment*> head;
+				alignas(64) std::atomic<segment*> tail;
+				// drained segments, reused by whoever needs a new segment
+				::cppu::details::epoch_recycler<segment> retired;
+
+				// expects the caller to be pinned at `pinned`
+				segment* new_segment(uint64 pinned, size_t base)
+				{
+					segment* reuse = retired.reuse(pinned);
+					if (reuse == nullptr)
+						return new segment(base);
+
+					reuse->reset(base);
+					return reuse;
+				}
+
+				// tail is full, link a new segment or help the one that did
+				void extend(const epoch_guard& guard, segment* last)
+				{
+					segment* next = last->next.load();
+					if (next == nullptr)
+					{
+						segment* s = new_segment(guard.epoch(), last->base + SegmentSize);
+						if (last->next.compare_exchange_strong(next, s))
+							next = s;
+						else
+							delete s;
+					}
+
+					tail.compare_exchange_strong(last, next);
+				}
+
+				// head is drained, false if there's nothing after it
+				bool advance_head(const epoch_guard& guard, segment* first)
+				{
+					segment* next = first->next.load();
+					if (next == nullptr)
+						return false;
+
+					// head can't pass tail, the segment would be retired while tail still points at it
+					segment* last = first;
+					tail.compare_exchange_strong(last, next);
+
+					if (head.compare_exchange_strong(first, next))
+						retired.retire(guard.epoch(), first);
+
+					return true;
+				}
+
+				// hands the value of a claimed cell to sink(T&&), false if the producer hasn't come this far (the cell is skipped)
+				template<class _Sink>
+				inline bool take(cell& c, _Sink&& sink)
+				{
+					uint32 state = cell_empty;
+					if (c.state.compare_exchange_strong(state, cell_done))
+						return false;
+
+					while (state == cell_writing)
+					{
+						std::this_thread::yield();
+						state = c.state.load();
+					}
+
+					sink(std::move(c.value));
+					c.value.~T();
+					c.state.store(cell_done, std::memory_order_relaxed);
+					return true;
+				}
+
+				// claims up to count cells of the tail segment for construct(T*) calls, returns the amount constructed
+				template<class _Construct>
+				size_t push_some(const epoch_guard& guard, size_t count, _Construct&& construct)
+				{
+					segment* last = tail.load();
+					const size_t index = last->enqueueIndex.fetch_add(count);
+					if (index >= SegmentSize)
+					{
+						extend(guard, last);
+						return 0;
+					}
+
+					size_t pushed = 0;
+					const size_t end = std::min(index + count, SegmentSize);
+					for (size_t i = index; i < end; ++i)
+					{
+						// a consumer got here first
+						cell& c = last->cells[i];
+						uint32 state = cell_empty;
+						if (!c.state.compare_exchange_strong(state, cell_writing))
+							continue;
+
+						construct(&c.value);
+						c.state.store(cell_ready, std::memory_order_release);
+						++pushed;
+					}
+
+					if (end == SegmentSize)
+						extend(guard, last);
+
+					return pushed;
+				}
+
+			public:
+				queue()
+				{
+					segment* s = new segment(0);
+					head.store(s);
+					tail.store(s);
+				}
+
+				queue(const queue&) = delete;
+				queue& operator=(const queue&) = delete;
+
+				~queue()
+				{
+					for (segment* s = head.load(); s != nullptr;)
+					{
+						const size_t used = std::min(s->enqueueIndex.load(), SegmentSize);
+						for (size_t i = 0; i < used; ++i)
+						{
+							if (s->cells[i].state.load() == cell_ready)
+								s->cells[i].value.~T();
+						}
+
+						segment* next = s->next.load();
+						delete s;
+						s = next;
+					}
+				}
+
+				template<class... _Valty>
+				void emplace(_Valty&&... _Val)
+				{
+					epoch_guard guard;
+					while (push_some(guard, 1, [&](T* value) { new (value) T(std::forward<_Valty>(_Val)...); }) == 0);
+				}
+
+				inline void push(const T& obj)
+				{
+					emplace(obj);
+				}
+
+				inline void push(T&& obj)
+				{
+					emplace(std::move(obj));
+				}
+
+				// always succeeds, for code that works with either queue
+				template<class... _Valty>
+				inline bool try_emplace(_Valty&&... _Val)
+				{
+					emplace(std::forward<_Valty>(_Val)...);
+					return true;
+				}
+
+				inline bool try_push(const T& obj)
+				{
+					push(obj);
+					return true;
+				}
+
+				inline bool try_push(T&& obj)
+				{
+					push(std::move(obj));
+					return true;
+				}
+
+				// false when the queue is empty
+				bool try_pop(T& obj)
+				{
+					epoch_guard guard;
+					while (true)
+					{
+						segment* first = head.load();
+
+						// don't burn indices on an empty segment, producers would have to skip them
+						if (first->dequeueIndex.load() >= first->enqueueIndex.load() && first->next.load() == nullptr)
+							return false;
+
+						const size_t index = first->dequeueIndex.fetch_add(1);
+						if (index >= SegmentSize)
+						{
+							if (!advance_head(guard, first))
+								return false;
+						}
+						else if (take(first->cells[index], [&obj](T&& value) { obj = std::move(value); }))
+							return true;
+					}
+				}
+
+				// pushes *first++ count times, cells are claimed with one fetch_add per segment
+				template<class _It>
+				size_t try_push_n(_It first, size_t count)
+				{
+					epoch_guard guard;
+					size_t pushed = 0;
+					while (pushed < count)
+						pushed += push_some(guard, std::min(count - pushed, SegmentSize), [&first](T* value) { new (value) T(*first); ++first; });
+
+					return count;
+				}
+
+				// *out++ = value for up to max values, returns the amount popped
+				template<class _OutIt>
+				size_t try_pop_n(_OutIt out, size_t max)
+				{
+					epoch_guard guard;
+					size_t popped = 0;
+					while (popped < max)
+					{
+						segment* first = head.load();
+						const size_t dequeued = first->dequeueIndex.load();
+						const size_t enqueued = std::min(first->enqueueIndex.load(), SegmentSize);
+						if (dequeued >= enqueued && first->next.load() == nullptr)
+							break;
+
+						// only claims what looks available, the rest may be skipped cells
+						const size_t want = std::max<size_t>(1, std::min(max - popped, enqueued > dequeued ? enqueued - dequeued : 0));
+						const size_t index = first->dequeueIndex.fetch_add(want);
+						if (index >= SegmentSize)
+						{
+							if (!advance_head(guard, first))
+								break;
+
+							continue;
+						}
+
+						const size_t end = std::min(index + want, SegmentSize);
+						for (size_t i = index; i < end; ++i)
+						{
+							if (take(first->cells[i], [&out](T&& value) { *out = std::move(value); ++out; }))
+								++popped;
+						}
+					}
+
+					return popped;
+				}
+
+				// may be off while other threads push or pop, skipped cells count as well
+				size_t size()
+				{
+					epoch_guard guard;
+					segment* first = head.load();
+					segment* last = tail.load();
+					const size_t dequeued = first->base + std::min(first->dequeueIndex.load(), SegmentSize);
+					const size_t enqueued = last->base + std::min(last->enqueueIndex.load(), SegmentSize);
+					return enqueued > dequeued ? enqueued - dequeued : 0;
+				}
+
+				inline bool empty()
+				{
+					return size() == 0;
+				}
+			};
+		}
+	}
+}
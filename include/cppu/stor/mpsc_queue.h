@@ -0,0 +1,264 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+#include "details/waiter.h"
+#include "../details/epoch.h"
+#include "../dtypes.h"
+
+namespace cppu
+{
+	namespace stor
+	{
+		// Unbounded multi producer, single consumer queue: producers take cells of the tail segment with a fetch_add and
+		// publish them with a store, the consumer walks the cells in order without any read-modify-write.
+		// The consumer stops at a cell whose producer hasn't finished yet, values behind it wait for that producer.
+		// Producers pin the epoch while they touch a segment, drained segments are reused once no producer can still see them.
+		// Blocking: pop_wait() sleeps on a futex, producers then pay a fence per push, so it's a template switch.
+		template<class T, bool Blocking = false, size_t SegmentSize = 1024>
+		class mpsc_queue
+		{
+		private:
+			typedef ::cppu::details::epoch_guard epoch_guard;
+
+			struct cell
+			{
+				std::atomic<bool> ready;
+				union
+				{
+					T value;
+				};
+
+				cell() { }
+				~cell() { }
+			};
+
+			struct segment
+			{
+				alignas(64) std::atomic<size_t> enqueueIndex;
+				std::atomic<segment*> next;
+				segment* retiredNext;
+				cell cells[SegmentSize];
+
+				segment()
+				{
+					reset();
+				}
+
+				// before the segment is published
+				void reset()
+				{
+					enqueueIndex.store(0, std::memory_order_relaxed);
+					next.store(nullptr, std::memory_order_relaxed);
+					retiredNext = nullptr;
+					for (cell& c : cells)
+						c.ready.store(false, std::memory_order_relaxed);
+				}
+			};
+
+			// producer side
+			alignas(64) std::atomic<segment*> tail;
+			::cppu::details::epoch_recycler<segment> retired;
+
+			// consumer side
+			alignas(64) segment* head;
+			size_t headIndex;
+
+			details::waiter pushed;
+
+			// expects the caller to be pinned at `pinned`
+			segment* new_segment(uint64 pinned)
+			{
+				segment* reuse = retired.reuse(pinned);
+				if (reuse == nullptr)
+					return new segment();
+
+				reuse->reset();
+				return reuse;
+			}
+
+			void extend(const epoch_guard& guard, segment* last)
+			{
+				segment* next = last->next.load();
+				if (next == nullptr)
+				{
+					segment* s = new_segment(guard.epoch());
+					if (last->next.compare_exchange_strong(next, s))
+						next = s;
+					else
+						delete s;
+				}
+
+				tail.compare_exchange_strong(last, next);
+			}
+
+			// claims up to count cells for construct(T*) calls, returns the amount constructed
+			template<class _Construct>
+			size_t push_some(const epoch_guard& guard, size_t count, _Construct&& construct)
+			{
+				segment* last = tail.load();
+				const size_t index = last->enqueueIndex.fetch_add(count);
+				if (index >= SegmentSize)
+				{
+					extend(guard, last);
+					return 0;
+				}
+
+				const size_t end = std::min(index + count, SegmentSize);
+				for (size_t i = index; i < end; ++i)
+				{
+					construct(&last->cells[i].value);
+					last->cells[i].ready.store(true, std::memory_order_release);
+				}
+
+				if (end == SegmentSize)
+					extend(guard, last);
+
+				return end - index;
+			}
+
+			// consumer: the cell to read next, nullptr when the queue is empty (or its producer isn't done)
+			cell* front_cell()
+			{
+				if (headIndex == SegmentSize)
+				{
+					segment* next = head->next.load(std::memory_order_acquire);
+					if (next == nullptr)
+						return nullptr;
+
+					// tail can't be left on a segment that's about to be reused
+					segment* last = head;
+					tail.compare_exchange_strong(last, next);
+
+					epoch_guard guard;
+					retired.retire(guard.epoch(), head);
+
+					head = next;
+					headIndex = 0;
+				}
+
+				cell* c = head->cells + headIndex;
+				return c->ready.load(std::memory_order_acquire) ? c : nullptr;
+			}
+
+			inline void after_push()
+			{
+				if constexpr (Blocking)
+					pushed.notify();
+			}
+
+		public:
+			mpsc_queue()
+				: tail(new segment())
+				, head(tail.load())
+				, headIndex(0)
+			{ }
+
+			mpsc_queue(const mpsc_queue&) = delete;
+			mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+			~mpsc_queue()
+			{
+				for (segment* s = head; s != nullptr;)
+				{
+					for (size_t i = s == head ? headIndex : 0; i < SegmentSize; ++i)
+					{
+						if (s->cells[i].ready.load())
+							s->cells[i].value.~T();
+					}
+
+					segment* next = s->next.load();
+					delete s;
+					s = next;
+				}
+			}
+
+			// any thread
+			template<class... _Valty>
+			void emplace(_Valty&&... _Val)
+			{
+				{
+					epoch_guard guard;
+					while (push_some(guard, 1, [&](T* value) { new (value) T(std::forward<_Valty>(_Val)...); }) == 0);
+				}
+
+				after_push();
+			}
+
+			inline void push(const T& obj)
+			{
+				emplace(obj);
+			}
+
+			inline void push(T&& obj)
+			{
+				emplace(std::move(obj));
+			}
+
+			// any thread, pushes *first++ count times with one fetch_add per segment
+			template<class _It>
+			void push_n(_It first, size_t count)
+			{
+				{
+					epoch_guard guard;
+					size_t pushed = 0;
+					while (pushed < count)
+						pushed += push_some(guard, std::min(count - pushed, SegmentSize), [&first](T* value) { new (value) T(*first); ++first; });
+				}
+
+				after_push();
+			}
+
+			// consumer only, false when empty
+			bool try_pop(T& obj)
+			{
+				cell* c = front_cell();
+				if (c == nullptr)
+					return false;
+
+				obj = std::move(c->value);
+				c->value.~T();
+				++headIndex;
+				return true;
+			}
+
+			// consumer only, fn(T&) on up to max values in place, returns the amount consumed
+			template<class _Func>
+			size_t consume(_Func&& fn, size_t max = SegmentSize)
+			{
+				size_t n = 0;
+				for (cell* c; n < max && (c = front_cell()) != nullptr; ++n)
+				{
+					fn(c->value);
+					c->value.~T();
+					++headIndex;
+				}
+
+				return n;
+			}
+
+			// consumer only, *out++ = value for up to max values
+			template<class _OutIt>
+			size_t try_pop_n(_OutIt out, size_t max)
+			{
+				return consume([&out](T& value) { *out = std::move(value); ++out; }, max);
+			}
+
+			// consumer only, sleeps while the queue is empty
+			void pop_wait(T& obj)
+			{
+				static_assert(Blocking, "pop_wait() needs mpsc_queue<T, true>");
+				pushed.wait_until([this]() { return front_cell() != nullptr; });
+				try_pop(obj);
+			}
+
+			// consumer only
+			inline bool empty()
+			{
+				return front_cell() == nullptr;
+			}
+		};
+	}
+}
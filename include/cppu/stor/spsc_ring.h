@@ -0,0 +1,211 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+#include "details/waiter.h"
+
+namespace cppu
+{
+	namespace stor
+	{
+		// Single producer, single consumer ring of N values (a power of two), for handing work from one thread to another.
+		// Each side owns its index on its own cache line and keeps a copy of the other side's index, so the shared lines are
+		// only read when the copy says the ring is full (or empty). Batches publish (or release) their values with one store.
+		// Blocking: push_wait() / pop_wait() sleep on a futex (WaitOnAddress on Windows), the other side pays a fence per
+		// publish for it, so it's a template switch.
+		template<class T, size_t N, bool Blocking = false>
+		class spsc_ring
+		{
+			static_assert(N >= 2 && (N & (N - 1)) == 0, "spsc_ring size has to be a power of two");
+		private:
+			static constexpr size_t mask = N - 1;
+
+			union
+			{
+				T values[N];
+			};
+
+			// producer side
+			alignas(64) std::atomic<size_t> tail;
+			size_t headCache;
+
+			// consumer side
+			alignas(64) std::atomic<size_t> head;
+			size_t tailCache;
+
+			alignas(64) details::waiter pushed;
+			details::waiter popped;
+
+			// free values for the producer, refreshes the copy of head when the copy runs out
+			inline size_t free_count(size_t t, size_t wanted)
+			{
+				if (N - (t - headCache) < wanted)
+					headCache = head.load(std::memory_order_acquire);
+
+				return N - (t - headCache);
+			}
+
+			inline size_t ready_count(size_t h, size_t wanted)
+			{
+				if (tailCache - h < wanted)
+					tailCache = tail.load(std::memory_order_acquire);
+
+				return tailCache - h;
+			}
+
+			inline void publish_tail(size_t t)
+			{
+				tail.store(t, std::memory_order_release);
+				if constexpr (Blocking)
+					pushed.notify();
+			}
+
+			inline void publish_head(size_t h)
+			{
+				head.store(h, std::memory_order_release);
+				if constexpr (Blocking)
+					popped.notify();
+			}
+
+		public:
+			spsc_ring()
+				: tail(0)
+				, headCache(0)
+				, head(0)
+				, tailCache(0)
+			{ }
+
+			spsc_ring(const spsc_ring&) = delete;
+			spsc_ring& operator=(const spsc_ring&) = delete;
+
+			~spsc_ring()
+			{
+				for (size_t h = head.load(); h != tail.load(); ++h)
+					values[h & mask].~T();
+			}
+
+			static constexpr size_t capacity()
+			{
+				return N;
+			}
+
+			// producer only, false when full
+			template<class... _Valty>
+			bool try_emplace(_Valty&&... _Val)
+			{
+				const size_t t = tail.load(std::memory_order_relaxed);
+				if (free_count(t, 1) == 0)
+					return false;
+
+				new (values + (t & mask)) T(std::forward<_Valty>(_Val)...);
+				publish_tail(t + 1);
+				return true;
+			}
+
+			inline bool try_push(const T& obj)
+			{
+				return try_emplace(obj);
+			}
+
+			inline bool try_push(T&& obj)
+			{
+				return try_emplace(std::move(obj));
+			}
+
+			// producer only, pushes *first++ as long as there's room (up to count), publishes once
+			template<class _It>
+			size_t try_push_n(_It first, size_t count)
+			{
+				const size_t t = tail.load(std::memory_order_relaxed);
+				const size_t free = free_count(t, count);
+				const size_t n = count < free ? count : free;
+				if (n == 0)
+					return 0;
+
+				for (size_t i = 0; i < n; ++i, ++first)
+					new (values + ((t + i) & mask)) T(*first);
+
+				publish_tail(t + n);
+				return n;
+			}
+
+			// consumer only, false when empty
+			bool try_pop(T& obj)
+			{
+				const size_t h = head.load(std::memory_order_relaxed);
+				if (ready_count(h, 1) == 0)
+					return false;
+
+				T& value = values[h & mask];
+				obj = std::move(value);
+				value.~T();
+				publish_head(h + 1);
+				return true;
+			}
+
+			// consumer only, fn(T&) on up to max values in place, they're destructed and released with one store afterwards
+			template<class _Func>
+			size_t consume(_Func&& fn, size_t max = N)
+			{
+				const size_t h = head.load(std::memory_order_relaxed);
+				const size_t ready = ready_count(h, max);
+				const size_t n = max < ready ? max : ready;
+				if (n == 0)
+					return 0;
+
+				for (size_t i = 0; i < n; ++i)
+				{
+					T& value = values[(h + i) & mask];
+					fn(value);
+					value.~T();
+				}
+
+				publish_head(h + n);
+				return n;
+			}
+
+			// consumer only, *out++ = value for up to max values
+			template<class _OutIt>
+			size_t try_pop_n(_OutIt out, size_t max)
+			{
+				return consume([&out](T& value) { *out = std::move(value); ++out; }, max);
+			}
+
+			// producer only, sleeps while the ring is full
+			template<class... _Valty>
+			void push_wait(_Valty&&... _Val)
+			{
+				static_assert(Blocking, "push_wait() needs spsc_ring<T, N, true>");
+
+				const size_t t = tail.load(std::memory_order_relaxed);
+				popped.wait_until([this, t]() { return free_count(t, 1) != 0; });
+
+				new (values + (t & mask)) T(std::forward<_Valty>(_Val)...);
+				publish_tail(t + 1);
+			}
+
+			// consumer only, sleeps while the ring is empty
+			void pop_wait(T& obj)
+			{
+				static_assert(Blocking, "pop_wait() needs spsc_ring<T, N, true>");
+
+				const size_t h = head.load(std::memory_order_relaxed);
+				pushed.wait_until([this, h]() { return ready_count(h, 1) != 0; });
+
+				try_pop(obj);
+			}
+
+			// exact from either side when the other one is idle
+			inline size_t size() const
+			{
+				return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+			}
+
+			inline bool empty() const
+			{
+				return size() == 0;
+			}
+		};
+	}
+}
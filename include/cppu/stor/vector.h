@@ -274,9 +274,9 @@ namespace cppu
 			{
 				if (_size < _capacity)
 				{
-					new((void*)(_data + _size)) T(std::forward<_Args>(arguments)...);
+					T* element = new((void*)(_data + _size)) T(std::forward<_Args>(arguments)...);
 					_size++;
-					return;
+					return *element;
 				}
 
 				size_type newCapacity = _capacity + _capacity * mulCapacity + addCapacity;
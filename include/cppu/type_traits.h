@@ -2,13 +2,14 @@
 
 #include <type_traits>
 #include <memory>
+#include <vector>
 
 namespace cppu
 {
 	namespace cgc
 	{
-		template<class T> class strong_ptr;
-		template<class T> class weak_ptr;
+		template<class T, bool _Atomic> class strong_ptr;
+		template<class T, bool _Atomic> class weak_ptr;
 	}
 
 	template<class T> struct is_smart_ptr : std::false_type {};
@@ -18,8 +19,8 @@ namespace cppu
 	template<class T> struct is_smart_ptr<std::shared_ptr<T>> : std::true_type {};
 	template<class T> struct is_smart_ptr<std::weak_ptr<T>> : std::true_type {};
 	
-	template<class T> struct is_smart_ptr<::cppu::cgc::strong_ptr<T>> : std::true_type {};
-	template<class T> struct is_smart_ptr<::cppu::cgc::weak_ptr<T>> : std::true_type {};
+	template<class T, bool _Atomic> struct is_smart_ptr<::cppu::cgc::strong_ptr<T, _Atomic>> : std::true_type {};
+	template<class T, bool _Atomic> struct is_smart_ptr<::cppu::cgc::weak_ptr<T, _Atomic>> : std::true_type {};
 	/// @endcond
 
 	template<class T> inline constexpr bool is_smart_ptr_v = is_smart_ptr<T>::value;
@@ -0,0 +1,275 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace cppu
+{
+	namespace details
+	{
+		// heap side of a unique_function, there's nothing to copy so destruction is the only virtual
+		class unique_closure_base
+		{
+		public:
+			virtual ~unique_closure_base() = default;
+		};
+
+		template <typename _B>
+		class unique_closure_t final : public unique_closure_base
+		{
+		public:
+			_B value;
+
+			template<typename... _Valty>
+			unique_closure_t(_Valty&&... _Val)
+				: value(std::forward<_Valty>(_Val)...)
+			{ }
+		};
+
+		// moves a target stored in place from `from` to `to` and destructs the source, only destructs it when to is nullptr
+		template<typename _T>
+		void unique_relocate(void* from, void* to)
+		{
+			if (to != nullptr)
+				new (to) _T(std::move(*static_cast<_T*>(from)));
+
+			static_cast<_T*>(from)->~_T();
+		}
+
+		// relocator of the in place target, only unique_functions with room for more than a pointer keep non trivial targets in place
+		template<bool _Managed>
+		struct unique_manager
+		{
+			void(*_relocate)(void*, void*) = nullptr; // nullptr while the target is trivial, owned or absent
+		};
+
+		template<>
+		struct unique_manager<false>
+		{ };
+	}
+
+	template <typename _Sig, size_t _Capacity = sizeof(void*)>
+	class unique_function;
+
+	// Move only function wrapper, two words like cppu::function: the target (the callable itself when it's small, trivially
+	// movable and trivially destructible, otherwise an owned heap closure) and the invoker, tagged in its top bit when the
+	// target is owned. Captures can be move only (unique_ptr, sockets, buffers), moving a unique_function never allocates.
+	// A _Capacity above a pointer stores callables up to that size in place, move only ones too (they add a relocator word).
+	template<typename _R, typename... _Args, size_t _Capacity>
+	class unique_function<_R(_Args...), _Capacity> : private details::unique_manager<(_Capacity > sizeof(void*))>
+	{
+		static_assert(_Capacity >= sizeof(void*), "a unique_function holds at least a pointer");
+	private:
+		static constexpr bool managed = _Capacity > sizeof(void*);
+
+		enum tag_e : uintptr_t
+		{
+			SHIFT = std::numeric_limits<uintptr_t>::digits - 1,
+			TARGET_OWNED_SHIFTED = uintptr_t(1) << SHIFT,
+			MASK = TARGET_OWNED_SHIFTED
+		};
+
+		typedef _R(*invoker_t)(void*, _Args&&...);
+
+		union target_t
+		{
+			void* _ptr;
+			alignas(void*) unsigned char _embed[_Capacity];
+		} _target;
+
+		uintptr_t _invoker;
+
+		template<typename _T>
+		static constexpr bool trivial = std::is_trivially_move_constructible_v<_T> && std::is_trivially_destructible_v<_T>;
+
+		template<typename _T>
+		static constexpr bool embeddable = (trivial<_T> || (managed && std::is_nothrow_move_constructible_v<_T>))
+			&& sizeof(_T) <= _Capacity && alignof(_T) <= alignof(void*);
+
+		template<typename _T>
+		static _R invoke_embedded(void* target, _Args&&... args)
+		{
+			return (*static_cast<_T*>(target))(std::forward<_Args>(args)...);
+		}
+
+		template<typename _T>
+		static _R invoke_owned(void* target, _Args&&... args)
+		{
+			return static_cast<details::unique_closure_t<_T>*>(static_cast<details::unique_closure_base*>(target))->value(std::forward<_Args>(args)...);
+		}
+
+		template<auto _Method, typename _T>
+		static _R invoke_method(void* target, _Args&&... args)
+		{
+			return (static_cast<_T*>(*static_cast<void**>(target))->*_Method)(std::forward<_Args>(args)...);
+		}
+
+		template<typename _T, typename... _Valty>
+		void construct(_Valty&&... _Val)
+		{
+			if constexpr (embeddable<_T>)
+			{
+				new (_target._embed) _T(std::forward<_Valty>(_Val)...);
+				_invoker = reinterpret_cast<uintptr_t>(&invoke_embedded<_T>);
+
+				if constexpr (managed && !trivial<_T>)
+					this->_relocate = &details::unique_relocate<_T>;
+			}
+			else
+			{
+				_target._ptr = static_cast<details::unique_closure_base*>(new details::unique_closure_t<_T>(std::forward<_Valty>(_Val)...));
+				_invoker = reinterpret_cast<uintptr_t>(&invoke_owned<_T>) | tag_e::TARGET_OWNED_SHIFTED;
+			}
+		}
+
+		inline void target_destruct() noexcept
+		{
+			if (_invoker & tag_e::TARGET_OWNED_SHIFTED)
+				delete static_cast<details::unique_closure_base*>(_target._ptr);
+			else if constexpr (managed)
+			{
+				if (this->_relocate != nullptr)
+					this->_relocate(_target._embed, nullptr);
+			}
+
+			_invoker = 0;
+			if constexpr (managed)
+				this->_relocate = nullptr;
+		}
+
+		// expects this to be empty, leaves move empty
+		inline void take(unique_function& move) noexcept
+		{
+			if constexpr (managed)
+			{
+				if (move._relocate != nullptr)
+					move._relocate(move._target._embed, _target._embed);
+				else
+					_target = move._target;
+
+				this->_relocate = move._relocate;
+				move._relocate = nullptr;
+			}
+			else
+				_target = move._target;
+
+			_invoker = move._invoker;
+			move._invoker = 0;
+		}
+
+		struct method_tag {};
+
+		unique_function(method_tag, void* target, uintptr_t invoker) noexcept
+			: _target{ target }
+			, _invoker(invoker)
+		{ }
+
+	public:
+		unique_function() noexcept
+			: _target{ nullptr }
+			, _invoker(0)
+		{ }
+
+		unique_function(std::nullptr_t) noexcept
+			: unique_function()
+		{ }
+
+		unique_function(unique_function&& move) noexcept
+			: _invoker(0)
+		{
+			take(move);
+		}
+
+		unique_function(const unique_function&) = delete;
+		unique_function& operator=(const unique_function&) = delete;
+
+		// static function, lambda or any other callable, copyable or not
+		template<typename _Func, typename _Decayed = std::decay_t<_Func>, typename = std::enable_if_t<
+			!std::is_same_v<_Decayed, unique_function> && std::is_invocable_r_v<_R, _Decayed&, _Args...>>>
+		unique_function(_Func&& func)
+		{
+			construct<_Decayed>(std::forward<_Func>(func));
+		}
+
+		// member function and a pointer to the object, the pair is owned (a member function pointer doesn't fit a word
+		// everywhere), bind<&T::Method>(object) embeds the pointer instead
+		template<typename _B, typename _T, typename = std::enable_if_t<std::is_base_of_v<_B, _T>>>
+		unique_function(_R(_B::* func)(_Args...), _T* target)
+		{
+			auto bound = [func, target](_Args... args) -> _R { return (static_cast<_B*>(target)->*func)(std::forward<_Args>(args)...); };
+			construct<decltype(bound)>(std::move(bound));
+		}
+
+		// member function known at compile time, only the object pointer is stored
+		template<auto _Method, typename _T>
+		static unique_function bind(_T* target) noexcept
+		{
+			return unique_function(method_tag{}, target, reinterpret_cast<uintptr_t>(&invoke_method<_Method, _T>));
+		}
+
+		~unique_function()
+		{
+			target_destruct();
+		}
+
+		unique_function& operator=(unique_function&& move) noexcept
+		{
+			if (this != &move)
+			{
+				target_destruct();
+				take(move);
+			}
+
+			return *this;
+		}
+
+		unique_function& operator=(std::nullptr_t) noexcept
+		{
+			target_destruct();
+			return *this;
+		}
+
+		template<typename _Func, typename _Decayed = std::decay_t<_Func>, typename = std::enable_if_t<
+			!std::is_same_v<_Decayed, unique_function> && std::is_invocable_r_v<_R, _Decayed&, _Args...>>>
+		unique_function& operator=(_Func&& func)
+		{
+			target_destruct();
+			construct<_Decayed>(std::forward<_Func>(func));
+			return *this;
+		}
+
+		void swap(unique_function& other) noexcept
+		{
+			if constexpr (managed)
+			{
+				unique_function temp(std::move(other));
+				other.take(*this);
+				take(temp);
+			}
+			else
+			{
+				std::swap(_target, other._target);
+				std::swap(_invoker, other._invoker);
+			}
+		}
+
+		inline explicit operator bool() const noexcept
+		{
+			return _invoker != 0;
+		}
+
+		inline _R operator()(_Args... args) const
+		{
+			if (_invoker == 0)
+				throw std::bad_function_call();
+
+			// owned targets are called through the pointer, embedded ones in place
+			void* target = (_invoker & tag_e::TARGET_OWNED_SHIFTED) ? _target._ptr : const_cast<unsigned char*>(_target._embed);
+			return reinterpret_cast<invoker_t>(_invoker & ~tag_e::MASK)(target, std::forward<_Args>(args)...);
+		}
+	};
+}
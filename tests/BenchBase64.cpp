@@ -0,0 +1,58 @@
+#include "Benchmark.h"
+
+#include <string>
+#include <vector>
+
+#include <cppu/crypt/base64.h>
+
+namespace
+{
+	constexpr size_t BYTES = 16 * 1024 * 1024;
+	constexpr size_t SIZES[] = { 64, 4096 };
+
+	std::string row(const char* name, size_t size)
+	{
+		return std::string(name) + " " + (size >= 1024 ? std::to_string(size / 1024) + "KB" : std::to_string(size) + "B");
+	}
+}
+
+BENCHMARK(base64)
+{
+	bench::header("cppu::crypt base64 into a preallocated buffer (per byte of input)");
+
+	for (size_t size : SIZES)
+	{
+		std::string input(size, '\0');
+		for (size_t i = 0; i < size; ++i)
+			input[i] = char(i * 31 + 7);
+
+		std::vector<byte> encoded(cppu::crypt::base64_enc_len(size));
+		cppu::crypt::base64_enc_raw(encoded.data(), input);
+		const std::string_view text(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+		std::vector<byte> decoded(cppu::crypt::base64_dec_len(text.size()));
+
+		bench::run_batch(row("Encode", size).c_str(), BYTES, [&](size_t calls, bench::stopwatch& sw)
+		{
+			sw.start();
+			for (size_t i = 0; i < calls; i += size)
+			{
+				cppu::crypt::base64_enc_raw(encoded.data(), input);
+				bench::do_not_optimize(encoded.data());
+			}
+			sw.stop();
+		});
+
+		bench::run_batch(row("Decode", size).c_str(), BYTES, [&](size_t calls, bench::stopwatch& sw)
+		{
+			sw.start();
+			for (size_t i = 0; i < calls; i += size)
+			{
+				cppu::crypt::base64_dec_raw(decoded.data(), nullptr, text, nullptr);
+				bench::do_not_optimize(decoded.data());
+			}
+			sw.stop();
+		});
+
+		bench::empty_line();
+	}
+}
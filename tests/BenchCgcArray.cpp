@@ -0,0 +1,136 @@
+#include "Benchmark.h"
+
+#include <memory>
+#include <thread>
+#include <cppu/cgc/m_array.h>
+
+namespace
+{
+	constexpr size_t OBJECTS = 1'000'000;
+	constexpr size_t THREADS = 4;
+
+	struct Particle
+	{
+		float x, y;
+
+		Particle(float x, float y) : x(x), y(y) { }
+	};
+
+	template<typename S>
+	void emplace_destroy(const char* emplaceName, const char* destroyName)
+	{
+		typedef cppu::cgc::m_array<Particle, S> container;
+		std::vector<cppu::cgc::strong_ptr<Particle>> pointers(OBJECTS);
+
+		// every rerun starts with a fresh container, so block allocation is part of the emplace cost
+		std::unique_ptr<container> arr;
+		bench::run_batch(emplaceName, OBJECTS, [&](size_t calls, bench::stopwatch& sw)
+		{
+			arr = std::make_unique<container>();
+
+			sw.start();
+			for (size_t i = 0; i < calls; ++i)
+				pointers[i] = arr->emplace(float(i), 0.f);
+			sw.stop();
+
+			pointers.assign(OBJECTS, nullptr);
+		});
+
+		bench::run_batch(destroyName, OBJECTS, [&](size_t calls, bench::stopwatch& sw)
+		{
+			for (size_t i = 0; i < calls; ++i)
+				pointers[i] = arr->emplace(float(i), 0.f);
+
+			sw.start();
+			for (size_t i = 0; i < calls; ++i)
+				pointers[i].~strong_ptr();
+			sw.stop();
+
+			for (size_t i = 0; i < calls; ++i)
+				new (&pointers[i]) cppu::cgc::strong_ptr<Particle>();
+		});
+	}
+
+	// emplace_n() / release_all() in waves of BATCH objects
+	template<typename S>
+	void batch_emplace_release(const char* emplaceName, const char* releaseName)
+	{
+		constexpr size_t BATCH = 4096;
+		typedef cppu::cgc::m_array<Particle, S> container;
+		std::vector<typename container::batch> batches(OBJECTS / BATCH);
+
+		std::unique_ptr<container> arr;
+		bench::run_batch(emplaceName, batches.size() * BATCH, [&](size_t, bench::stopwatch& sw)
+		{
+			batches.clear();
+			batches.resize(OBJECTS / BATCH);
+			arr = std::make_unique<container>();
+
+			sw.start();
+			for (typename container::batch& b : batches)
+				b = arr->emplace_n(BATCH, 1.f, 0.f);
+			sw.stop();
+		});
+
+		bench::run_batch(releaseName, batches.size() * BATCH, [&](size_t, bench::stopwatch& sw)
+		{
+			for (typename container::batch& b : batches)
+			{
+				if (b.empty())
+					b = arr->emplace_n(BATCH, 1.f, 0.f);
+			}
+
+			sw.start();
+			for (typename container::batch& b : batches)
+				arr->release_all(b);
+			sw.stop();
+		});
+
+		batches.clear();
+	}
+
+	// THREADS threads emplace and release at the same time, reported per object
+	template<typename S>
+	void churn(const char* name)
+	{
+		cppu::cgc::m_array<Particle, S> arr;
+
+		bench::run_batch(name, OBJECTS, [&](size_t calls, bench::stopwatch& sw)
+		{
+			std::vector<std::thread> threads;
+
+			sw.start();
+			for (size_t t = 0; t < THREADS; ++t)
+			{
+				threads.emplace_back([&arr, calls]()
+				{
+					std::vector<cppu::cgc::strong_ptr<Particle>> pointers(256);
+					for (size_t i = 0; i < calls / THREADS; ++i)
+						pointers[i % pointers.size()] = arr.emplace(float(i), 0.f);
+				});
+			}
+
+			for (std::thread& thread : threads)
+				thread.join();
+			sw.stop();
+		});
+	}
+}
+
+BENCHMARK(cgc_array)
+{
+	bench::header("cgc::m_array emplace / destroy (per object)");
+	emplace_destroy<cppu::cgc::SIZE_32>("Emplace 32", "Destroy 32");
+	emplace_destroy<cppu::cgc::SIZE_64>("Emplace 64", "Destroy 64");
+	bench::empty_line();
+	emplace_destroy<cppu::cgc::SIZE_256>("Emplace 256", "Destroy 256");
+	emplace_destroy<cppu::cgc::SIZE_1024>("Emplace 1024", "Destroy 1024");
+	emplace_destroy<cppu::cgc::SIZE_4096>("Emplace 4096", "Destroy 4096");
+	bench::empty_line();
+	batch_emplace_release<cppu::cgc::SIZE_64>("Batch 64", "Unbatch 64");
+	batch_emplace_release<cppu::cgc::SIZE_4096>("Batch 4096", "Unbatch 4096");
+	bench::empty_line();
+	churn<cppu::cgc::SIZE_32>("Churn 32");
+	churn<cppu::cgc::SIZE_256>("Churn 256");
+	churn<cppu::cgc::SIZE_4096>("Churn 4096");
+}
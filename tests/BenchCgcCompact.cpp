@@ -0,0 +1,93 @@
+#include "Benchmark.h"
+
+#include <memory>
+#include <cppu/cgc/m_array.h>
+
+namespace
+{
+	constexpr size_t OBJECTS = 1'000'000;
+	// one in KEEP objects survives the despawn wave
+	constexpr size_t KEEP = 10;
+
+	struct Enemy
+	{
+		float x = 0.f, vx = 1.f;
+		float state[14] = {};
+	};
+
+	typedef cppu::cgc::m_array<cppu::cgc::relocatable<Enemy>, cppu::cgc::SIZE_64> relocatable_enemies;
+	typedef std::vector<cppu::cgc::strong_ptr<cppu::cgc::relocatable<Enemy>>> relocatable_pointers;
+
+	std::unique_ptr<relocatable_enemies> despawn_wave(relocatable_pointers& pointers)
+	{
+		pointers.assign(OBJECTS, nullptr);
+
+		std::unique_ptr<relocatable_enemies> enemies = std::make_unique<relocatable_enemies>();
+		for (size_t i = 0; i < OBJECTS; ++i)
+			pointers[i] = enemies->emplace();
+
+		for (size_t i = 0; i < OBJECTS; ++i)
+		{
+			if (i % KEEP != 0)
+				pointers[i] = nullptr;
+		}
+
+		return enemies;
+	}
+}
+
+BENCHMARK(cgc_compact)
+{
+	bench::header("cgc::m_array after despawning 90% (per live object)");
+
+	cppu::cgc::m_array<Enemy, cppu::cgc::SIZE_64> plain;
+	std::vector<cppu::cgc::strong_ptr<Enemy>> plainPointers(OBJECTS);
+	for (size_t i = 0; i < OBJECTS; ++i)
+		plainPointers[i] = plain.emplace();
+
+	for (size_t i = 0; i < OBJECTS; ++i)
+	{
+		if (i % KEEP != 0)
+			plainPointers[i] = nullptr;
+	}
+
+	bench::run_batch("Plain", OBJECTS / KEEP, [&](size_t, bench::stopwatch& sw)
+	{
+		sw.start();
+		for (Enemy& e : plain)
+			e.x += e.vx * 0.016f;
+		sw.stop();
+	});
+
+	relocatable_pointers pointers;
+	std::unique_ptr<relocatable_enemies> enemies;
+
+	// per moved object, every rerun starts from a fresh sparse pool
+	bench::run_batch("Compact", OBJECTS / KEEP, [&](size_t, bench::stopwatch& sw)
+	{
+		pointers.clear();
+		enemies = despawn_wave(pointers);
+
+		sw.start();
+		while (enemies->compact(1024) > 0);
+		sw.stop();
+	});
+
+	// through the handles, in slot order
+	bench::run_batch("Handles", OBJECTS / KEEP, [&](size_t, bench::stopwatch& sw)
+	{
+		sw.start();
+		for (cppu::cgc::relocatable<Enemy>& e : *enemies)
+			e->x += e->vx * 0.016f;
+		sw.stop();
+	});
+
+	bench::run_batch("Pool", OBJECTS / KEEP, [&](size_t, bench::stopwatch& sw)
+	{
+		sw.start();
+		enemies->get_objects().for_each([](Enemy& e) { e.x += e.vx * 0.016f; });
+		sw.stop();
+	});
+
+	pointers.clear();
+}
@@ -0,0 +1,94 @@
+#include "Benchmark.h"
+
+#include <cppu/cgc/m_array.h>
+
+namespace
+{
+	constexpr size_t OBJECTS = 100'000;
+
+	struct Transform
+	{
+		float x = 0.f, y = 0.f, z = 0.f;
+	};
+
+	// a component that refers to another entity's transform
+	template<class R>
+	struct Follower
+	{
+		R target;
+	};
+}
+
+template<>
+struct cppu::cgc::uses_handles<Transform> : std::true_type {};
+
+BENCHMARK(cgc_handle)
+{
+	bench::header("cgc::handle vs strong_ptr references (per reference)");
+
+	cppu::cgc::m_array<Transform, cppu::cgc::SIZE_64> transforms;
+	std::vector<Follower<cppu::cgc::strong_ptr<Transform>>> strong(OBJECTS);
+	std::vector<Follower<cppu::cgc::handle<Transform>>> handles(OBJECTS);
+	for (size_t i = 0; i < OBJECTS; ++i)
+	{
+		strong[i].target = transforms.emplace();
+		handles[i].target = transforms.handle_of(strong[i].target);
+	}
+
+	bench::run_batch("Strong copy", OBJECTS, [&](size_t calls, bench::stopwatch& sw)
+	{
+		std::vector<Follower<cppu::cgc::strong_ptr<Transform>>> copies;
+		copies.reserve(calls);
+
+		sw.start();
+		for (size_t i = 0; i < calls; ++i)
+			copies.push_back(strong[i]);
+		sw.stop();
+	});
+
+	bench::run_batch("Handle copy", OBJECTS, [&](size_t calls, bench::stopwatch& sw)
+	{
+		std::vector<Follower<cppu::cgc::handle<Transform>>> copies;
+		copies.reserve(calls);
+
+		sw.start();
+		for (size_t i = 0; i < calls; ++i)
+			copies.push_back(handles[i]);
+		sw.stop();
+	});
+
+	bench::run_batch("Strong deref", OBJECTS, [&](size_t calls, bench::stopwatch& sw)
+	{
+		float sum = 0.f;
+		sw.start();
+		for (size_t i = 0; i < calls; ++i)
+			sum += strong[i].target->x;
+		sw.stop();
+		bench::do_not_optimize(sum);
+	});
+
+	bench::run_batch("Handle get", OBJECTS, [&](size_t calls, bench::stopwatch& sw)
+	{
+		float sum = 0.f;
+		sw.start();
+		for (size_t i = 0; i < calls; ++i)
+		{
+			if (Transform* t = transforms.get(handles[i].target))
+				sum += t->x;
+		}
+		sw.stop();
+		bench::do_not_optimize(sum);
+	});
+
+	bench::run_batch("Handle share", OBJECTS, [&](size_t calls, bench::stopwatch& sw)
+	{
+		float sum = 0.f;
+		sw.start();
+		for (size_t i = 0; i < calls; ++i)
+			sum += transforms.share(handles[i].target)->x;
+		sw.stop();
+		bench::do_not_optimize(sum);
+	});
+
+	strong.clear();
+}
@@ -0,0 +1,157 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <cppu/cgc/unordered_map.h>
+
+namespace
+{
+	constexpr size_t OBJECTS = 1'000'000;
+	constexpr size_t SESSIONS = 10'000;
+
+	struct Entity
+	{
+		float x, y;
+
+		Entity() : x(0.f), y(0.f) { }
+		Entity(float x, float y) : x(x), y(y) { }
+	};
+
+	// spreads the keys so they don't come in hash order
+	inline size_t key_of(size_t i)
+	{
+		return i * 0x9E3779B97F4A7C15ull;
+	}
+
+	template<typename backend>
+	void map_ops(const char* insertName, const char* findName, const char* iterateName, const char* eraseName)
+	{
+		typedef cppu::cgc::unordered_map<size_t, Entity, cppu::cgc::CLEAN_PROC::DIRECT, backend> container;
+		std::vector<cppu::cgc::strong_ptr<Entity>> pointers(OBJECTS);
+
+		// every rerun starts with a fresh map, so growing the table is part of the insert cost
+		std::unique_ptr<container> map;
+		bench::run_batch(insertName, OBJECTS, [&](size_t calls, bench::stopwatch& sw)
+		{
+			pointers.assign(OBJECTS, nullptr);
+			map = std::make_unique<container>();
+
+			sw.start();
+			for (size_t i = 0; i < calls; ++i)
+				pointers[i] = map->emplace(key_of(i), float(i), 0.f);
+			sw.stop();
+		});
+
+		bench::run(findName, OBJECTS, [&, i = size_t(0)]() mutable
+		{
+			bench::do_not_optimize(map->find(key_of(i++ % OBJECTS)));
+		});
+
+		bench::run_batch(iterateName, OBJECTS, [&](size_t, bench::stopwatch& sw)
+		{
+			float sum = 0.f;
+
+			sw.start();
+			for (auto it = map->begin(); it != map->end(); ++it)
+				sum += (*it).second.x;
+			sw.stop();
+
+			bench::do_not_optimize(sum);
+		});
+
+		// dropping the last pointer removes the element (DIRECT)
+		bench::run_batch(eraseName, OBJECTS, [&](size_t calls, bench::stopwatch& sw)
+		{
+			pointers.assign(OBJECTS, nullptr);
+			for (size_t i = 0; i < calls; ++i)
+				pointers[i] = map->emplace(key_of(i), float(i), 0.f);
+
+			sw.start();
+			for (size_t i = 0; i < calls; ++i)
+				pointers[i] = nullptr;
+			sw.stop();
+		});
+
+		pointers.assign(OBJECTS, nullptr);
+	}
+
+	// threads look up random keys (1 in 16 replaces the object) in a sharded map, reported per call per thread.
+	// EPOCH maps run under an epoch_guard (renewed every 256 calls), Pinned reads through find_pinned() instead of get()
+	template<size_t Shards, cppu::cgc::CLEAN_PROC clean_proc = cppu::cgc::CLEAN_PROC::DIRECT, bool Pinned = false>
+	void sessions(const char* name, size_t threadCount)
+	{
+		typedef cppu::cgc::unordered_map<size_t, Entity, clean_proc, cppu::cgc::map_backend::sharded<Shards>> container;
+		container map;
+		std::vector<cppu::cgc::strong_ptr<Entity>> owners(SESSIONS);
+		for (size_t i = 0; i < SESSIONS; ++i)
+			owners[i] = map.emplace(i, float(i), 0.f);
+
+		bench::run_batch(name, OBJECTS, [&](size_t calls, bench::stopwatch& sw)
+		{
+			std::vector<std::thread> threads;
+
+			sw.start();
+			for (size_t t = 0; t < threadCount; ++t)
+			{
+				threads.emplace_back([&map, t, calls]()
+				{
+					size_t x = t + 1;
+					cppu::cgc::strong_ptr<Entity> keep;
+					auto lookups = [&](size_t count)
+					{
+						for (size_t i = 0; i < count; ++i)
+						{
+							x = x * 6364136223846793005ull + 1442695040888963407ull;
+							const size_t key = (x >> 33) % SESSIONS;
+							if ((x >> 28) % 16 == 0)
+								keep = map.emplace(key, float(key), 1.f);
+							else if constexpr (Pinned)
+								bench::do_not_optimize(map.find_pinned(key));
+							else
+								bench::do_not_optimize(map.get(key));
+						}
+					};
+
+					for (size_t i = 0; i < calls; i += 256)
+					{
+						if constexpr (clean_proc == cppu::cgc::CLEAN_PROC::EPOCH)
+						{
+							cppu::cgc::epoch_guard guard;
+							lookups(std::min<size_t>(256, calls - i));
+						}
+						else
+							lookups(std::min<size_t>(256, calls - i));
+					}
+				});
+			}
+
+			for (std::thread& thread : threads)
+				thread.join();
+			sw.stop();
+
+			// replaced objects wait for their grace period (EPOCH)
+			map.clean_garbage();
+		});
+	}
+}
+
+BENCHMARK(cgc_map)
+{
+	bench::header("cgc unordered_map (node vs flat, sharded lookups)");
+
+	map_ops<cppu::cgc::map_backend::node>("Node emplace", "Node find", "Node iterate", "Node release");
+	bench::empty_line();
+	map_ops<cppu::cgc::map_backend::flat>("Flat emplace", "Flat find", "Flat iterate", "Flat release");
+	bench::empty_line();
+	sessions<1>("1 shard 1", 1);
+	sessions<1>("1 shard 4", 4);
+	sessions<16>("16 shards 1", 1);
+	sessions<16>("16 shards 4", 4);
+	sessions<64>("64 shards 8", 8);
+	bench::empty_line();
+	sessions<16, cppu::cgc::CLEAN_PROC::EPOCH>("16 epoch 1", 1);
+	sessions<16, cppu::cgc::CLEAN_PROC::EPOCH, true>("16 pinned 1", 1);
+	sessions<16, cppu::cgc::CLEAN_PROC::EPOCH>("16 epoch 4", 4);
+	sessions<16, cppu::cgc::CLEAN_PROC::EPOCH, true>("16 pinned 4", 4);
+}
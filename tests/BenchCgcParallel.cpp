@@ -0,0 +1,55 @@
+#include "Benchmark.h"
+
+#include <cppu/cgc/parallel.h>
+
+namespace
+{
+	constexpr size_t OBJECTS = 1'000'000;
+
+	struct Particle
+	{
+		float x = 0.f, vx = 1.f;
+		float pad[6] = {};
+	};
+
+	template<typename S, cppu::cgc::CLEAN_PROC clean_proc>
+	void passes(const char* serialName, const char* parallelName, const char* reduceName)
+	{
+		cppu::cgc::m_array<Particle, S, clean_proc> particles;
+		typename cppu::cgc::m_array<Particle, S, clean_proc>::batch objects = particles.emplace_n(OBJECTS);
+
+		bench::run_batch(serialName, OBJECTS, [&](size_t, bench::stopwatch& sw)
+		{
+			sw.start();
+			particles.for_each([](Particle& p) { p.x += p.vx * 0.016f; });
+			sw.stop();
+		});
+
+		bench::run_batch(parallelName, OBJECTS, [&](size_t, bench::stopwatch& sw)
+		{
+			sw.start();
+			cppu::cgc::parallel_for_each(particles, [](Particle& p) { p.x += p.vx * 0.016f; });
+			sw.stop();
+		});
+
+		bench::run_batch(reduceName, OBJECTS, [&](size_t, bench::stopwatch& sw)
+		{
+			sw.start();
+			float sum = cppu::cgc::parallel_reduce(particles, 0.f, [](float& r, Particle& p) { r += p.x; }, [](float a, float b) { return a + b; });
+			sw.stop();
+			bench::do_not_optimize(sum);
+		});
+
+		bench::do_not_optimize(objects);
+	}
+}
+
+BENCHMARK(cgc_parallel)
+{
+	bench::header("cgc::m_array for_each over all objects (per object)");
+	passes<cppu::cgc::SIZE_64, cppu::cgc::CLEAN_PROC::DIRECT>("Serial 64", "Par. 64", "Reduce 64");
+	bench::empty_line();
+	passes<cppu::cgc::SIZE_1024, cppu::cgc::CLEAN_PROC::DIRECT>("Serial 1024", "Par. 1024", "Reduce 1024");
+	bench::empty_line();
+	passes<cppu::cgc::SIZE_1024, cppu::cgc::CLEAN_PROC::EPOCH>("Serial epoch", "Par. epoch", "Reduce epoch");
+}
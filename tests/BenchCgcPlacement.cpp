@@ -0,0 +1,106 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <cppu/cgc/m_array.h>
+
+#ifdef WIN32
+#include "windows.h"
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+	constexpr size_t THREADS = 4;
+	constexpr size_t OBJECTS = 1'000'000;
+
+	struct Item
+	{
+		float x = 0.f, vx = 1.f;
+		float payload[14] = {};
+	};
+
+	// threads go to cpus spread over the whole machine, so on a multi socket system they end up on different nodes
+	void pin_thread(size_t t)
+	{
+		const size_t cpus = std::max(1u, std::thread::hardware_concurrency());
+		const size_t cpu = (t * cpus / THREADS) % cpus;
+
+#ifdef WIN32
+		SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu);
+#elif defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+	}
+
+	template<class _Func>
+	void on_pinned_threads(_Func&& func)
+	{
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < THREADS; ++t)
+		{
+			threads.emplace_back([&func, t]()
+			{
+				pin_thread(t);
+				func(t);
+			});
+		}
+
+		for (std::thread& thread : threads)
+			thread.join();
+	}
+
+	// every thread emplaces its own objects, then passes over its own objects and over those of a thread half the machine away
+	template<class policy>
+	void placement(const char* ownName, const char* otherName)
+	{
+		typedef cppu::cgc::m_array<Item, cppu::cgc::SIZE_1024, cppu::cgc::CLEAN_PROC::DIRECT, policy> container;
+
+		container items;
+		std::vector<std::vector<cppu::cgc::strong_ptr<Item>>> owned(THREADS);
+		on_pinned_threads([&](size_t t)
+		{
+			owned[t].reserve(OBJECTS / THREADS);
+			for (size_t i = 0; i < OBJECTS / THREADS; ++i)
+				owned[t].push_back(items.emplace());
+		});
+
+		bench::run_batch(ownName, OBJECTS, [&](size_t, bench::stopwatch& sw)
+		{
+			sw.start();
+			on_pinned_threads([&](size_t t)
+			{
+				for (cppu::cgc::strong_ptr<Item>& item : owned[t])
+					item->x += item->vx * 0.016f;
+			});
+			sw.stop();
+		});
+
+		bench::run_batch(otherName, OBJECTS, [&](size_t, bench::stopwatch& sw)
+		{
+			sw.start();
+			on_pinned_threads([&](size_t t)
+			{
+				for (cppu::cgc::strong_ptr<Item>& item : owned[(t + THREADS / 2) % THREADS])
+					item->x += item->vx * 0.016f;
+			});
+			sw.stop();
+		});
+
+		owned.clear();
+	}
+}
+
+BENCHMARK(cgc_placement)
+{
+	bench::header("cgc::m_array block placement, 4 pinned threads (per object)");
+	placement<cppu::cgc::thread_policy::shared>("Shared own", "Shared other");
+	placement<cppu::cgc::thread_policy::per_thread<THREADS>>("Thread own", "Thread other");
+	placement<cppu::cgc::thread_policy::numa<2>>("Numa own", "Numa other");
+}
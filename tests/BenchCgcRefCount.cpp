@@ -0,0 +1,91 @@
+#include "Benchmark.h"
+
+#include <thread>
+#include <cppu/cgc/array.h>
+
+// Build with different CPPU_CGC_REFCOUNT_BITS / CPPU_CGC_REFCOUNT_PACKED / CPPU_CGC_REFCOUNT_PADDED to compare counter layouts
+namespace
+{
+	constexpr size_t COPIES = 1'000'000;
+
+	struct Shared
+	{
+		size_t value = 0;
+	};
+
+	// every thread copies (and drops) strong_ptrs to one object, or to its own object in the same array when `spread`,
+	// reported per copy per thread
+	void copy_across(const char* name, size_t threadCount, bool spread)
+	{
+		cppu::cgc::array<Shared, cppu::cgc::SIZE_64> arr;
+		std::vector<cppu::cgc::strong_ptr<Shared>> objects;
+		for (size_t t = 0; t < threadCount; ++t)
+			objects.push_back(spread || t == 0 ? arr.emplace() : objects[0]);
+
+		bench::run_batch(name, COPIES, [&](size_t calls, bench::stopwatch& sw)
+		{
+			std::vector<std::thread> threads;
+
+			sw.start();
+			for (size_t t = 0; t < threadCount; ++t)
+			{
+				threads.emplace_back([&objects, t, calls]()
+				{
+					const cppu::cgc::strong_ptr<Shared>& source = objects[t];
+					for (size_t i = 0; i < calls; ++i)
+					{
+						cppu::cgc::strong_ptr<Shared> copy = source;
+						bench::do_not_optimize(copy);
+					}
+				});
+			}
+
+			for (std::thread& thread : threads)
+				thread.join();
+			sw.stop();
+		});
+	}
+
+	// thread_policy::local counters, no locked instructions
+	void copy_local(const char* name)
+	{
+		cppu::cgc::array<Shared, cppu::cgc::SIZE_64, cppu::cgc::CLEAN_PROC::DIRECT, cppu::cgc::thread_policy::local> arr;
+		cppu::cgc::strong_ptr<Shared, false> source = arr.emplace();
+
+		bench::run(name, COPIES, [&source]()
+		{
+			cppu::cgc::strong_ptr<Shared, false> copy = source;
+			bench::do_not_optimize(copy);
+		});
+	}
+
+	const char* layout()
+	{
+#if defined(CPPU_CGC_REFCOUNT_PACKED) && defined(CPPU_CGC_REFCOUNT_PADDED)
+		return "packed, padded";
+#elif defined(CPPU_CGC_REFCOUNT_PACKED)
+		return "packed";
+#elif defined(CPPU_CGC_REFCOUNT_PADDED)
+		return "split, padded";
+#else
+		return "split";
+#endif
+	}
+}
+
+BENCHMARK(cgc_refcount)
+{
+	std::string title = "cgc strong_ptr copy contention (" + std::to_string(CPPU_CGC_REFCOUNT_BITS) + " bit, " + layout() + ")";
+	bench::header(title.c_str());
+
+	copy_across("Shared 1", 1, false);
+	copy_across("Shared 2", 2, false);
+	copy_across("Shared 4", 4, false);
+	copy_across("Shared 8", 8, false);
+	bench::empty_line();
+	copy_across("Spread 2", 2, true);
+	copy_across("Spread 4", 4, true);
+	copy_across("Spread 8", 8, true);
+	bench::empty_line();
+	copy_local("Local 1");
+}
@@ -0,0 +1,97 @@
+#include "Benchmark.h"
+
+#include <memory>
+
+#include <cppu/cgc/m_array.h>
+#include <cppu/cgc/huge_page_resource.h>
+
+namespace
+{
+	constexpr size_t OBJECTS = 1'000'000;
+
+	struct Particle
+	{
+		float position[3] = {};
+		float velocity[3] = { 1.f, 1.f, 1.f };
+	};
+
+	typedef cppu::cgc::m_array<Particle, cppu::cgc::SIZE_1024> particles;
+
+	// emplaces calls objects into a fresh container, the pointers keep them alive
+	void fill_run(std::pmr::memory_resource* resource, size_t calls, bench::stopwatch& sw)
+	{
+		std::vector<cppu::cgc::strong_ptr<Particle>> keep;
+		keep.reserve(calls);
+
+		std::unique_ptr<particles> arr(new particles(resource));
+
+		sw.start();
+		for (size_t i = 0; i < calls; ++i)
+			keep.push_back(arr->emplace());
+		sw.stop();
+
+		keep.clear();
+	}
+
+	void walk_run(particles& arr, size_t calls, bench::stopwatch& sw)
+	{
+		float sum = 0.f;
+		size_t visited = 0;
+
+		sw.start();
+		while (visited < calls)
+		{
+			arr.for_each([&sum, &visited](Particle& p)
+			{
+				p.position[0] += p.velocity[0];
+				sum += p.position[0];
+				++visited;
+			});
+		}
+		sw.stop();
+
+		bench::do_not_optimize(sum);
+	}
+}
+
+BENCHMARK(cgc_resource)
+{
+	bench::header("cgc::m_array blocks from the default resource vs huge_page_resource (per object)");
+
+	cppu::cgc::huge_page_resource huge;
+
+	bench::run_batch("Fill new", OBJECTS, [&](size_t calls, bench::stopwatch& sw)
+	{
+		fill_run(std::pmr::get_default_resource(), calls, sw);
+	});
+
+	bench::run_batch("Fill huge", OBJECTS, [&](size_t calls, bench::stopwatch& sw)
+	{
+		fill_run(&huge, calls, sw);
+	});
+
+	bench::empty_line();
+
+	std::vector<cppu::cgc::strong_ptr<Particle>> keep;
+	keep.reserve(2 * OBJECTS);
+
+	particles plain;
+	particles paged(&huge);
+	for (size_t i = 0; i < OBJECTS; ++i)
+	{
+		keep.push_back(plain.emplace());
+		keep.push_back(paged.emplace());
+	}
+
+	bench::run_batch("Walk new", OBJECTS, [&](size_t calls, bench::stopwatch& sw)
+	{
+		walk_run(plain, calls, sw);
+	});
+
+	bench::run_batch("Walk huge", OBJECTS, [&](size_t calls, bench::stopwatch& sw)
+	{
+		walk_run(paged, calls, sw);
+	});
+
+	keep.clear();
+}
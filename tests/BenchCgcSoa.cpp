@@ -0,0 +1,87 @@
+#include "Benchmark.h"
+
+#include <cppu/cgc/m_array.h>
+
+namespace
+{
+	constexpr size_t OBJECTS = 1'000'000;
+
+	// an update pass only touches 2 of its fields
+	struct Body
+	{
+		float x = 0.f, y = 0.f, z = 0.f;
+		float vx = 0.f, vy = 0.f, vz = 0.f;
+		float mass = 1.f, drag = 0.f;
+		float extra[8] = {};
+
+		Body() = default;
+		Body(float x, float vx) : x(x), vx(vx) { }
+	};
+}
+
+template<>
+struct cppu::cgc::soa_fields<Body>
+{
+	static constexpr auto members = std::make_tuple(&Body::x, &Body::y, &Body::z, &Body::vx, &Body::vy, &Body::vz, &Body::mass, &Body::drag, &Body::extra);
+};
+
+namespace
+{
+	template<typename S>
+	void update_passes(const char* iterName, const char* chunkName, const char* soaName)
+	{
+		cppu::cgc::m_array<Body, S> bodies;
+		cppu::cgc::m_array<cppu::cgc::soa<Body>, S> columns;
+		typename cppu::cgc::m_array<Body, S>::batch aos = bodies.emplace_n(OBJECTS, 0.f, 1.f);
+		typename cppu::cgc::m_array<cppu::cgc::soa<Body>, S>::batch soa = columns.emplace_n(OBJECTS, 0.f, 1.f);
+
+		bench::run_batch(iterName, OBJECTS, [&](size_t, bench::stopwatch& sw)
+		{
+			sw.start();
+			for (Body& b : bodies)
+				b.x += b.vx * 0.016f;
+			sw.stop();
+		});
+
+		// whole blocks, free slots are masked out
+		bench::run_batch(chunkName, OBJECTS, [&](size_t, bench::stopwatch& sw)
+		{
+			sw.start();
+			bodies.for_each_chunk([](auto& c)
+			{
+				Body* b = c.data();
+				for (size_t i = 0; i < c.size(); ++i)
+				{
+					if (c.occupied(i))
+						b[i].x += b[i].vx * 0.016f;
+				}
+			});
+			sw.stop();
+		});
+
+		// free slots hold zeroed or stale floats, so the loop runs over the whole column
+		bench::run_batch(soaName, OBJECTS, [&](size_t, bench::stopwatch& sw)
+		{
+			sw.start();
+			columns.for_each_chunk([](auto& c)
+			{
+				cppu::cgc::column<float> x = c.template field<&Body::x>();
+				cppu::cgc::column<float> vx = c.template field<&Body::vx>();
+				for (size_t i = 0; i < c.size(); ++i)
+					x[i] += vx[i] * 0.016f;
+			});
+			sw.stop();
+		});
+
+		bench::do_not_optimize(aos);
+		bench::do_not_optimize(soa);
+	}
+}
+
+BENCHMARK(cgc_soa)
+{
+	bench::header("cgc::m_array update pass over 1 field (per object)");
+	update_passes<cppu::cgc::SIZE_64>("Iterate 64", "Chunk 64", "Soa 64");
+	bench::empty_line();
+	update_passes<cppu::cgc::SIZE_1024>("Iterate 1024", "Chunk 1024", "Soa 1024");
+}
@@ -0,0 +1,99 @@
+#include "Benchmark.h"
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <cppu/delegate.h>
+
+namespace
+{
+	constexpr size_t TARGET_CALLS = 2'000'000;
+	constexpr size_t SUBSCRIBERS[] = { 1, 10, 100, 1000 };
+	constexpr size_t BATCH = 16;
+
+	struct observer
+	{
+		size_t hits = 0;
+
+		BENCH_NOINLINE void on_event(size_t& value)
+		{
+			value += ++hits;
+		}
+	};
+
+	// the usual observer list
+	class std_event
+	{
+	private:
+		std::vector<std::function<void(size_t&)>> targets;
+		mutable std::mutex lock;
+
+	public:
+		void subscribe(std::function<void(size_t&)> target)
+		{
+			std::lock_guard<std::mutex> lk(lock);
+			targets.push_back(std::move(target));
+		}
+
+		void invoke(size_t& value) const
+		{
+			std::lock_guard<std::mutex> lk(lock);
+			for (const std::function<void(size_t&)>& target : targets)
+				target(value);
+		}
+	};
+
+	std::string row(const char* name, size_t subscribers)
+	{
+		return std::string(name) + " " + std::to_string(subscribers);
+	}
+}
+
+BENCHMARK(delegate)
+{
+	bench::header("STD = mutex + std::vector<std::function>, CPPU = cppu::delegate, 1 - 1000 subscribers (per invoke)");
+
+	for (size_t subscribers : SUBSCRIBERS)
+	{
+		const size_t invokes = TARGET_CALLS / subscribers;
+		std::vector<observer> observers(subscribers);
+
+		std_event stdEvent;
+		cppu::delegate<void(size_t&)> event;
+		for (observer& o : observers)
+		{
+			stdEvent.subscribe([&o](size_t& value) { o.on_event(value); });
+			event.subscribe({ &observer::on_event, &o });
+		}
+
+		bench::run(row("STD", subscribers).c_str(), invokes, [&stdEvent]()
+		{
+			size_t value = 0;
+			stdEvent.invoke(value);
+			bench::do_not_optimize(value);
+		});
+
+		bench::run(row("CPPU", subscribers).c_str(), invokes, [&event]()
+		{
+			size_t value = 0;
+			event.invoke(value);
+			bench::do_not_optimize(value);
+		});
+
+		// BATCH values per invoke_batch, counted per value
+		bench::run_batch(row("Batch", subscribers).c_str(), invokes, [&event](size_t calls, bench::stopwatch& sw)
+		{
+			size_t values[BATCH] = {};
+			sw.start();
+			for (size_t i = 0; i < calls; i += BATCH)
+				event.invoke_batch(values, values + BATCH);
+			sw.stop();
+
+			bench::do_not_optimize(values);
+		});
+
+		bench::empty_line();
+	}
+}
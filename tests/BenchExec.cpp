@@ -0,0 +1,174 @@
+#include "Benchmark.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <cppu/exec/scheduler.h>
+
+namespace
+{
+	constexpr size_t TASKS = 200'000;
+	constexpr size_t WORKERS = 4;
+
+	// what a service with its own threads usually looks like: one locked queue of std::function, a condition variable per wake
+	class mutex_pool
+	{
+	private:
+		std::vector<std::thread> threads;
+		std::vector<std::function<void()>> tasks;
+		std::mutex lock;
+		std::condition_variable wake;
+		bool stopping = false;
+
+	public:
+		explicit mutex_pool(size_t count)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				threads.emplace_back([this]()
+				{
+					std::unique_lock<std::mutex> lk(lock);
+					while (true)
+					{
+						wake.wait(lk, [this]() { return stopping || !tasks.empty(); });
+						if (tasks.empty())
+							return;
+
+						std::function<void()> task = std::move(tasks.back());
+						tasks.pop_back();
+						lk.unlock();
+						task();
+						lk.lock();
+					}
+				});
+			}
+		}
+
+		~mutex_pool()
+		{
+			{
+				std::lock_guard<std::mutex> lk(lock);
+				stopping = true;
+			}
+
+			wake.notify_all();
+			for (std::thread& thread : threads)
+				thread.join();
+		}
+
+		void post(std::function<void()> task)
+		{
+			{
+				std::lock_guard<std::mutex> lk(lock);
+				tasks.push_back(std::move(task));
+			}
+
+			wake.notify_one();
+		}
+	};
+
+	void wait_for(std::atomic<size_t>& done, size_t count)
+	{
+		while (done.load() != count)
+			std::this_thread::yield();
+	}
+
+	// splits [begin, end) in halves until single items, every split is a task
+	void split(cppu::exec::scheduler& scheduler, std::atomic<size_t>& done, size_t begin, size_t end)
+	{
+		while (end - begin > 1)
+		{
+			const size_t mid = begin + (end - begin) / 2;
+			scheduler.post([&scheduler, &done, mid, end]() { split(scheduler, done, mid, end); });
+			end = mid;
+		}
+
+		++done;
+	}
+}
+
+BENCHMARK(exec)
+{
+	bench::header("exec::scheduler vs a mutex + condition variable pool, 4 workers (per task)");
+
+	bench::run_batch("Mutex pool", TASKS, [](size_t calls, bench::stopwatch& sw)
+	{
+		std::atomic<size_t> done = 0;
+		mutex_pool pool(WORKERS);
+
+		sw.start();
+		for (size_t i = 0; i < calls; ++i)
+			pool.post([&done]() { ++done; });
+
+		wait_for(done, calls);
+		sw.stop();
+	});
+
+	bench::run_batch("Post", TASKS, [](size_t calls, bench::stopwatch& sw)
+	{
+		std::atomic<size_t> done = 0;
+		cppu::exec::scheduler scheduler(WORKERS);
+
+		sw.start();
+		for (size_t i = 0; i < calls; ++i)
+			scheduler.post([&done]() { ++done; });
+
+		wait_for(done, calls);
+		sw.stop();
+	});
+
+	// one task posts all of them, they go through the workers' own deques and get stolen from there
+	bench::run_batch("Post inner", TASKS, [](size_t calls, bench::stopwatch& sw)
+	{
+		std::atomic<size_t> done = 0;
+		cppu::exec::scheduler scheduler(WORKERS);
+
+		sw.start();
+		scheduler.post([&scheduler, &done, calls]()
+		{
+			for (size_t i = 0; i < calls; ++i)
+				scheduler.post([&done]() { ++done; });
+		});
+
+		wait_for(done, calls);
+		sw.stop();
+	});
+
+	bench::run_batch("Split", TASKS, [](size_t calls, bench::stopwatch& sw)
+	{
+		std::atomic<size_t> done = 0;
+		cppu::exec::scheduler scheduler(WORKERS);
+
+		sw.start();
+		scheduler.post([&scheduler, &done, calls]() { split(scheduler, done, 0, calls); });
+
+		wait_for(done, calls);
+		sw.stop();
+	});
+
+	bench::empty_line();
+
+	// the closure doesn't fit in a task's 48 bytes, it goes to the heap
+	bench::run_batch("Post heap", TASKS, [](size_t calls, bench::stopwatch& sw)
+	{
+		std::atomic<size_t> done = 0;
+		cppu::exec::scheduler scheduler(WORKERS);
+
+		sw.start();
+		scheduler.post([&scheduler, &done, calls]()
+		{
+			for (size_t i = 0; i < calls; ++i)
+			{
+				size_t payload[8] = { i };
+				scheduler.post([&done, payload]() { done += 1 + payload[0] * 0; });
+			}
+		});
+
+		wait_for(done, calls);
+		sw.stop();
+	});
+}
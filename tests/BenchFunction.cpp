@@ -0,0 +1,112 @@
+#include "Benchmark.h"
+
+#include <functional>
+
+#include <cppu/function.h>
+#include <cppu/inplace_function.h>
+
+namespace
+{
+	constexpr size_t CALLS = 10'000'000;
+
+	typedef std::function<void(size_t&)> std_function;
+	typedef cppu::inplace_function<void(size_t&), 48> inplace_function;
+
+	struct target
+	{
+		BENCH_NOINLINE void message(size_t a, size_t b, size_t& out)
+		{
+			out = size_t(this) + a + b;
+		}
+
+		BENCH_NOINLINE static void message_static(size_t a, size_t b, size_t& out)
+		{
+			out = a + b;
+		}
+	};
+
+	// the wrappers next to the raw pointers they're compared with
+	struct functions : target
+	{
+		void(*baseStatic)(size_t, size_t, size_t&) = &target::message_static;
+		void(target::* baseMember)(size_t, size_t, size_t&) = &target::message;
+
+		std::function<void(size_t, size_t, size_t&)> stdStatic, stdMember, stdLambda;
+		cppu::function<void(size_t, size_t, size_t&)> cppuStatic, cppuMember, cppuLambda;
+
+		functions()
+		{
+			stdStatic = &target::message_static;
+			cppuStatic = &target::message_static;
+
+			stdMember = std::bind(&target::message, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+			cppuMember = { &target::message, this };
+
+			auto lambda = [this](size_t a, size_t b, size_t& out) { out = size_t(this) + a + b; };
+			stdLambda = lambda;
+			cppuLambda = lambda;
+		}
+	};
+
+	// a callback capturing N pointers, (re)bound and called once per call
+	template<typename _Function, size_t N>
+	void bind_and_call(size_t calls, bench::stopwatch& sw)
+	{
+		size_t values[N + 1] = {};
+		size_t out = 0;
+
+		sw.start();
+		for (size_t i = 0; i < calls; ++i)
+		{
+			size_t* pointers[N];
+			for (size_t p = 0; p < N; ++p)
+				pointers[p] = values + p + (i & 1);
+
+			_Function func = [pointers](size_t& result) { for (size_t* ptr : pointers) result += *ptr + size_t(ptr); };
+			bench::do_not_optimize(func);
+			func(out);
+		}
+		sw.stop();
+
+		bench::do_not_optimize(out);
+	}
+}
+
+BENCHMARK(function)
+{
+	functions* f = new functions();
+	bench::do_not_optimize(f);
+	size_t out = 0;
+
+	bench::header("std::function vs cppu::function<void(size_t, size_t, size_t&)>, per call");
+
+	bench::run("Base static", CALLS, [f, &out]() { (*f->baseStatic)(1, 2, out); bench::do_not_optimize(out); });
+	bench::run("Base member", CALLS, [f, &out]() { (f->*f->baseMember)(1, 2, out); bench::do_not_optimize(out); });
+	bench::empty_line();
+
+	bench::run("STD static", CALLS, [f, &out]() { f->stdStatic(1, 2, out); bench::do_not_optimize(out); });
+	bench::run("CPPU static", CALLS, [f, &out]() { f->cppuStatic(1, 2, out); bench::do_not_optimize(out); });
+	bench::empty_line();
+
+	bench::run("STD member", CALLS, [f, &out]() { f->stdMember(1, 2, out); bench::do_not_optimize(out); });
+	bench::run("CPPU member", CALLS, [f, &out]() { f->cppuMember(1, 2, out); bench::do_not_optimize(out); });
+	bench::empty_line();
+
+	bench::run("STD lambda", CALLS, [f, &out]() { f->stdLambda(1, 2, out); bench::do_not_optimize(out); });
+	bench::run("CPPU lambda", CALLS, [f, &out]() { f->cppuLambda(1, 2, out); bench::do_not_optimize(out); });
+
+	delete f;
+
+	bench::header("std::function vs cppu::inplace_function<void(size_t&), 48>, bind + call + destroy of a 16 / 32 / 48 byte lambda");
+
+	bench::run_batch("STD 16B", CALLS, bind_and_call<std_function, 2>);
+	bench::run_batch("Inplace 16B", CALLS, bind_and_call<inplace_function, 2>);
+	bench::empty_line();
+
+	bench::run_batch("STD 32B", CALLS, bind_and_call<std_function, 4>);
+	bench::run_batch("Inplace 32B", CALLS, bind_and_call<inplace_function, 4>);
+	bench::empty_line();
+
+	bench::run_batch("STD 48B", CALLS, bind_and_call<std_function, 6>);
+	bench::run_batch("Inplace 48B", CALLS, bind_and_call<inplace_function, 6>);
+}
@@ -0,0 +1,64 @@
+#include "Benchmark.h"
+
+#include <vector>
+
+#include <cppu/half.h>
+
+namespace
+{
+	constexpr size_t VALUES = 4096;
+	constexpr size_t CALLS = 10'000'000;
+
+	using half_float::half;
+}
+
+BENCHMARK(half)
+{
+	std::vector<float> floats(VALUES);
+	std::vector<half> halves(VALUES);
+	for (size_t i = 0; i < VALUES; ++i)
+	{
+		floats[i] = (float(i) - VALUES / 2) * 0.37f;
+		halves[i] = half(floats[i]);
+	}
+
+	bench::header("half_float::half conversions and arithmetic over 4096 values (per value)");
+
+	bench::run_batch("To half", CALLS, [&](size_t calls, bench::stopwatch& sw)
+	{
+		sw.start();
+		for (size_t i = 0; i < calls; i += VALUES)
+		{
+			for (size_t v = 0; v < VALUES; ++v)
+				halves[v] = half(floats[v]);
+			bench::do_not_optimize(halves.data());
+		}
+		sw.stop();
+	});
+
+	bench::run_batch("To float", CALLS, [&](size_t calls, bench::stopwatch& sw)
+	{
+		sw.start();
+		for (size_t i = 0; i < calls; i += VALUES)
+		{
+			for (size_t v = 0; v < VALUES; ++v)
+				floats[v] = float(halves[v]);
+			bench::do_not_optimize(floats.data());
+		}
+		sw.stop();
+	});
+
+	bench::run_batch("Multiply", CALLS, [&](size_t calls, bench::stopwatch& sw)
+	{
+		const half scale(0.5f);
+
+		sw.start();
+		for (size_t i = 0; i < calls; i += VALUES)
+		{
+			for (size_t v = 0; v < VALUES; ++v)
+				halves[v] = halves[v] * scale + scale;
+			bench::do_not_optimize(halves.data());
+		}
+		sw.stop();
+	});
+}
@@ -0,0 +1,59 @@
+#include "Benchmark.h"
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+#include <cppu/hash.h>
+#include <cppu/hash_tuple.h>
+
+namespace
+{
+	constexpr size_t CALLS = 10'000'000;
+	constexpr size_t SIZES[] = { 16, 256 };
+
+	std::string row(const char* name, size_t size)
+	{
+		return std::string(name) + " " + std::to_string(size) + "B";
+	}
+}
+
+BENCHMARK(hash)
+{
+	bench::header("STD = std::hash<std::string_view>, CPPU = cppu::hash() on runtime strings (per string)");
+
+	for (size_t size : SIZES)
+	{
+		std::string text(size, '\0');
+		for (size_t i = 0; i < size; ++i)
+			text[i] = char('a' + i % 26);
+
+		std::string_view view = text;
+
+		bench::run(row("STD", size).c_str(), CALLS, [&view]()
+		{
+			bench::do_not_optimize(view);
+			size_t hash = std::hash<std::string_view>()(view);
+			bench::do_not_optimize(hash);
+		});
+
+		bench::run(row("CPPU", size).c_str(), CALLS, [&view]()
+		{
+			bench::do_not_optimize(view);
+			cppu::hash_t hash = cppu::hash(view);
+			bench::do_not_optimize(hash);
+		});
+
+		bench::empty_line();
+	}
+
+	// hash_tuple.h, the boost hash_combine over the elements
+	std::tuple<int, float, std::string> tuple(42, 1.5f, "tuple");
+	bench::run("Tuple", CALLS, [&tuple]()
+	{
+		bench::do_not_optimize(tuple);
+		size_t hash = std::hash<std::tuple<int, float, std::string>>()(tuple);
+		bench::do_not_optimize(hash);
+	});
+}
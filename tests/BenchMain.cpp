@@ -0,0 +1,7 @@
+#include "Benchmark.h"
+
+// Runs the registered benchmarks, pass (part of) suite names as arguments to run a selection, see bench::run_all() for the options
+int main(int argc, char** argv)
+{
+	return bench::run_all(argc, argv);
+}
@@ -0,0 +1,132 @@
+#include "Benchmark.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <cppu/serial/Serializer.h>
+
+namespace
+{
+	using namespace cppu::serial;
+
+	constexpr size_t ARCHIVES = 100'000;
+	constexpr size_t ITEMS = 16;
+
+	enum key : Key
+	{
+		KEY_ID,
+		KEY_NAME,
+		KEY_POSITION,
+		KEY_ITEMS,
+		KEY_COUNT
+	};
+
+	struct position
+	{
+		float x, y, z;
+	};
+
+	struct item
+	{
+		uint32_t id = 0;
+		float weight = 0;
+		std::string name;
+
+		void Serialize(ArchiveWriter& writer) const
+		{
+			writer << id << weight << name;
+		}
+
+		void DeSerialize(ArchiveReader& reader)
+		{
+			reader.Read(id);
+			reader.Read(weight);
+			reader.Read(name);
+		}
+	};
+
+	// a small game object, written through the vtable
+	struct player
+	{
+		uint64_t id = 0;
+		std::string name;
+		position pos = {};
+		std::vector<item> items;
+
+		void write(ArchiveWriter& writer) const
+		{
+			writer.Serialize(KEY_ID, id);
+			writer.Serialize(KEY_NAME, name);
+			writer.Serialize(KEY_POSITION, pos);
+			writer.Serialize(KEY_ITEMS, items);
+		}
+
+		void read(ArchiveReader& reader)
+		{
+			reader.DeSerialize(KEY_ID, id);
+			reader.DeSerialize(KEY_NAME, name);
+			reader.DeSerialize(KEY_POSITION, pos);
+			reader.DeSerialize(KEY_ITEMS, items);
+		}
+	};
+
+	player make_player()
+	{
+		player p;
+		p.id = 1234567;
+		p.name = "player one";
+		p.pos = { 1.f, 2.f, 3.f };
+		for (uint32_t i = 0; i < ITEMS; ++i)
+			p.items.push_back({ i, float(i) * 0.5f, "item" });
+
+		return p;
+	}
+
+	// the lower bound, the fixed fields copied into a buffer
+	struct flat
+	{
+		uint64_t id;
+		position pos;
+		struct { uint32_t id; float weight; } items[ITEMS];
+	};
+}
+
+BENCHMARK(serializer)
+{
+	const player source = make_player();
+	ArchiveWriter archive(KEY_COUNT, 1);
+	source.write(archive);
+	const std::string bytes(archive.Finish());
+
+	bench::header("cppu::serial archive of a player with 16 items (per archive)");
+
+	bench::run("Memcpy", ARCHIVES, [&source]()
+	{
+		flat f;
+		f.id = source.id;
+		f.pos = source.pos;
+		for (size_t i = 0; i < ITEMS; ++i)
+			f.items[i] = { source.items[i].id, source.items[i].weight };
+
+		char buffer[sizeof(flat)];
+		std::memcpy(buffer, &f, sizeof(flat));
+		bench::do_not_optimize(buffer);
+	});
+
+	bench::run("Write", ARCHIVES, [&source]()
+	{
+		ArchiveWriter writer(KEY_COUNT, 1);
+		source.write(writer);
+		std::string_view out = writer.Finish();
+		bench::do_not_optimize(out);
+	});
+
+	bench::run("Read", ARCHIVES, [&bytes]()
+	{
+		ArchiveReader reader(bytes);
+		player p;
+		p.read(reader);
+		bench::do_not_optimize(p);
+	});
+}
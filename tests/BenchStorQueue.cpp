@@ -0,0 +1,187 @@
+#include "Benchmark.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cppu/stor/lock/queue.h>
+#include <cppu/stor/lockfree/bounded_queue.h>
+#include <cppu/stor/lockfree/queue.h>
+
+namespace
+{
+	constexpr size_t OPERATIONS = 1'000'000;
+	constexpr size_t BATCH = 16;
+	constexpr size_t THREAD_COUNTS[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+	// pushed and popped values of a thread, counted and summed
+	struct totals
+	{
+		size_t pushed = 0, pushedSum = 0;
+		size_t popped = 0, poppedSum = 0;
+
+		inline void push(size_t value) { ++pushed; pushedSum += value; }
+		inline void pop(size_t value) { ++popped; poppedSum += value; }
+	};
+
+	// unique per thread and call, so a value popped twice (and one lost) doesn't cancel out in the sums
+	inline size_t value_of(size_t t, size_t i)
+	{
+		return (t << 32) + i;
+	}
+
+	// every thread pushes a value and pops one, calls is split over the threads. Time runs from the go signal until all joined.
+	// Afterwards drain(totals&) pops what's left, every pushed value has to be popped exactly once
+	template<class _Pair, class _Drain>
+	void contended_run(size_t threadCount, size_t calls, bench::stopwatch& sw, _Pair&& pair, _Drain&& drain)
+	{
+		std::atomic<size_t> ready = 0;
+		std::atomic<bool> go = false;
+
+		std::vector<totals> counted(threadCount);
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < threadCount; ++t)
+		{
+			threads.emplace_back([&, t]()
+			{
+				const size_t count = calls * (t + 1) / threadCount - calls * t / threadCount;
+				++ready;
+				while (!go.load())
+					std::this_thread::yield();
+
+				pair(t, count, counted[t]);
+			});
+		}
+
+		while (ready.load() != threadCount)
+			std::this_thread::yield();
+
+		sw.start();
+		go.store(true);
+		for (std::thread& thread : threads)
+			thread.join();
+		sw.stop();
+
+		totals all;
+		for (const totals& c : counted)
+		{
+			all.pushed += c.pushed;
+			all.pushedSum += c.pushedSum;
+			all.popped += c.popped;
+			all.poppedSum += c.poppedSum;
+		}
+
+		drain(all);
+		bench::check(all.pushed == all.popped, "popped a different amount of values than pushed");
+		bench::check(all.pushedSum == all.poppedSum, "popped other values than pushed");
+	}
+
+	std::string row(const char* name, size_t threads)
+	{
+		return std::string(name) + " " + std::to_string(threads);
+	}
+}
+
+BENCHMARK(stor_queue)
+{
+	bench::header("stor::lock::queue vs stor::lockfree queues, push + pop per call, 1 - 64 threads");
+
+	for (size_t threads : THREAD_COUNTS)
+	{
+		bench::run_batch(row("Mutex", threads).c_str(), OPERATIONS, [&](size_t calls, bench::stopwatch& sw)
+		{
+			cppu::stor::lock::queue<size_t> q;
+			contended_run(threads, calls, sw, [&q](size_t t, size_t count, totals& counted)
+			{
+				size_t value;
+				for (size_t i = 0; i < count; ++i)
+				{
+					q.push(value_of(t, i));
+					counted.push(value_of(t, i));
+					if (q.pop(value))
+						counted.pop(value);
+				}
+			},
+			[&q](totals& counted)
+			{
+				for (size_t value; q.pop(value);)
+					counted.pop(value);
+			});
+		});
+
+		bench::run_batch(row("Bounded", threads).c_str(), OPERATIONS, [&](size_t calls, bench::stopwatch& sw)
+		{
+			cppu::stor::lockfree::bounded_queue<size_t> q(1024);
+			contended_run(threads, calls, sw, [&q](size_t t, size_t count, totals& counted)
+			{
+				size_t value;
+				for (size_t i = 0; i < count; ++i)
+				{
+					while (!q.try_push(value_of(t, i)))
+						std::this_thread::yield();
+
+					counted.push(value_of(t, i));
+					if (q.try_pop(value))
+						counted.pop(value);
+				}
+			},
+			[&q](totals& counted)
+			{
+				for (size_t value; q.try_pop(value);)
+					counted.pop(value);
+			});
+		});
+
+		bench::run_batch(row("Unbounded", threads).c_str(), OPERATIONS, [&](size_t calls, bench::stopwatch& sw)
+		{
+			cppu::stor::lockfree::queue<size_t> q;
+			contended_run(threads, calls, sw, [&q](size_t t, size_t count, totals& counted)
+			{
+				size_t value;
+				for (size_t i = 0; i < count; ++i)
+				{
+					q.push(value_of(t, i));
+					counted.push(value_of(t, i));
+					if (q.try_pop(value))
+						counted.pop(value);
+				}
+			},
+			[&q](totals& counted)
+			{
+				for (size_t value; q.try_pop(value);)
+					counted.pop(value);
+			});
+		});
+
+		// BATCH values per push and pop, counted per value
+		bench::run_batch(row("Batch", threads).c_str(), OPERATIONS, [&](size_t calls, bench::stopwatch& sw)
+		{
+			cppu::stor::lockfree::queue<size_t> q;
+			contended_run(threads, calls, sw, [&q](size_t t, size_t count, totals& counted)
+			{
+				size_t values[BATCH];
+				for (size_t i = 0; i < count; i += BATCH)
+				{
+					for (size_t b = 0; b < BATCH; ++b)
+						values[b] = value_of(t, i + b);
+
+					const size_t pushed = q.try_push_n(values, BATCH);
+					for (size_t b = 0; b < pushed; ++b)
+						counted.push(values[b]);
+
+					const size_t popped = q.try_pop_n(values, BATCH);
+					for (size_t b = 0; b < popped; ++b)
+						counted.pop(values[b]);
+				}
+			},
+			[&q](totals& counted)
+			{
+				for (size_t value; q.try_pop(value);)
+					counted.pop(value);
+			});
+		});
+
+		bench::empty_line();
+	}
+}
@@ -0,0 +1,220 @@
+#include "Benchmark.h"
+
+#include <thread>
+#include <vector>
+
+#include <cppu/stor/lock/queue.h>
+#include <cppu/stor/spsc_ring.h>
+#include <cppu/stor/mpsc_queue.h>
+
+namespace
+{
+	constexpr size_t VALUES = 1'000'000;
+	constexpr size_t ROUND_TRIPS = 100'000;
+	constexpr size_t BATCH = 32;
+	constexpr size_t PRODUCERS = 4;
+
+	// adapters, so one loop drives every queue
+	template<class Q>
+	struct ops
+	{
+		static bool push(Q& q, size_t value) { return q.try_push(value); }
+		static bool pop(Q& q, size_t& value) { return q.try_pop(value); }
+	};
+
+	template<>
+	struct ops<cppu::stor::lock::queue<size_t>>
+	{
+		static bool push(cppu::stor::lock::queue<size_t>& q, size_t value) { q.push(value); return true; }
+		static bool pop(cppu::stor::lock::queue<size_t>& q, size_t& value) { return q.pop(value); }
+	};
+
+	template<bool B, size_t S>
+	struct ops<cppu::stor::mpsc_queue<size_t, B, S>>
+	{
+		static bool push(cppu::stor::mpsc_queue<size_t, B, S>& q, size_t value) { q.push(value); return true; }
+		static bool pop(cppu::stor::mpsc_queue<size_t, B, S>& q, size_t& value) { return q.try_pop(value); }
+	};
+
+	// values 0 .. calls - 1 are pushed once each, the consumer has to end up with exactly their sum and an empty queue
+	template<class Q>
+	void check_received(Q& q, size_t calls, size_t received, size_t sum)
+	{
+		size_t value;
+		bench::check(received == calls && !ops<Q>::pop(q, value), "popped a different amount of values than pushed");
+		bench::check(sum == calls * (calls - 1) / 2, "popped other values than pushed");
+	}
+
+	// producers push calls values in total, the calling thread pops them all
+	template<class Q>
+	void throughput_run(size_t producers, size_t calls, bench::stopwatch& sw)
+	{
+		Q q;
+		sw.start();
+
+		std::vector<std::thread> threads;
+		for (size_t p = 0; p < producers; ++p)
+		{
+			threads.emplace_back([&q, producers, calls, p]()
+			{
+				for (size_t i = calls * p / producers; i < calls * (p + 1) / producers; ++i)
+				{
+					while (!ops<Q>::push(q, i))
+						std::this_thread::yield();
+				}
+			});
+		}
+
+		size_t value, sum = 0, received = 0;
+		while (received < calls)
+		{
+			if (ops<Q>::pop(q, value))
+			{
+				sum += value;
+				++received;
+			}
+			else
+				std::this_thread::yield();
+		}
+
+		for (std::thread& thread : threads)
+			thread.join();
+
+		sw.stop();
+		check_received(q, calls, received, sum);
+	}
+
+	// same, BATCH values per push and consume
+	template<class Q, class _Push>
+	void batch_run(size_t producers, size_t calls, bench::stopwatch& sw, _Push&& push)
+	{
+		Q q;
+		sw.start();
+
+		std::vector<std::thread> threads;
+		for (size_t p = 0; p < producers; ++p)
+		{
+			threads.emplace_back([&q, &push, producers, calls, p]()
+			{
+				size_t values[BATCH];
+				const size_t end = calls * (p + 1) / producers;
+				for (size_t i = calls * p / producers; i < end;)
+				{
+					const size_t n = end - i < BATCH ? end - i : BATCH;
+					for (size_t b = 0; b < n; ++b)
+						values[b] = i + b;
+
+					for (size_t pushed = 0; pushed < n;)
+					{
+						const size_t added = push(q, values + pushed, n - pushed);
+						if (added == 0)
+							std::this_thread::yield();
+
+						pushed += added;
+					}
+
+					i += n;
+				}
+			});
+		}
+
+		size_t sum = 0, received = 0;
+		while (received < calls)
+		{
+			const size_t n = q.consume([&sum](size_t& value) { sum += value; }, BATCH);
+			if (n == 0)
+				std::this_thread::yield();
+
+			received += n;
+		}
+
+		for (std::thread& thread : threads)
+			thread.join();
+
+		sw.stop();
+		check_received(q, calls, received, sum);
+	}
+
+	// a value goes to the other thread and back, per round trip. Every value has to come back, in order
+	template<class Q, class _Send, class _Receive>
+	void round_trip_run(size_t calls, bench::stopwatch& sw, _Send&& send, _Receive&& receive)
+	{
+		Q there, back;
+
+		std::thread echo([&]()
+		{
+			for (size_t i = 0; i < calls; ++i)
+				send(back, receive(there));
+		});
+
+		size_t lost = 0;
+		sw.start();
+		for (size_t i = 0; i < calls; ++i)
+		{
+			send(there, i);
+			lost += receive(back) != i;
+		}
+		sw.stop();
+
+		echo.join();
+		bench::check(lost == 0, "a round trip came back with another value");
+	}
+
+	template<class Q>
+	void polling_round_trip(size_t calls, bench::stopwatch& sw)
+	{
+		round_trip_run<Q>(calls, sw,
+			[](Q& q, size_t value) { while (!ops<Q>::push(q, value)) std::this_thread::yield(); },
+			[](Q& q) { size_t value = 0; while (!ops<Q>::pop(q, value)) std::this_thread::yield(); return value; });
+	}
+}
+
+BENCHMARK(stor_ring)
+{
+	typedef cppu::stor::lock::queue<size_t> mutex_queue;
+	typedef cppu::stor::spsc_ring<size_t, 1024> ring;
+	typedef cppu::stor::spsc_ring<size_t, 1024, true> blocking_ring;
+	typedef cppu::stor::mpsc_queue<size_t> mpsc;
+	typedef cppu::stor::mpsc_queue<size_t, true> blocking_mpsc;
+
+	bench::header("stor::spsc_ring / stor::mpsc_queue throughput (per value)");
+
+	bench::run_batch("Mutex", VALUES, [](size_t calls, bench::stopwatch& sw) { throughput_run<mutex_queue>(1, calls, sw); });
+	bench::run_batch("SPSC", VALUES, [](size_t calls, bench::stopwatch& sw) { throughput_run<ring>(1, calls, sw); });
+	bench::run_batch("SPSC batch", VALUES, [](size_t calls, bench::stopwatch& sw)
+	{
+		batch_run<ring>(1, calls, sw, [](ring& q, size_t* values, size_t n) { return q.try_push_n(values, n); });
+	});
+	bench::run_batch("MPSC", VALUES, [](size_t calls, bench::stopwatch& sw) { throughput_run<mpsc>(1, calls, sw); });
+	bench::run_batch("MPSC batch", VALUES, [](size_t calls, bench::stopwatch& sw)
+	{
+		batch_run<mpsc>(1, calls, sw, [](mpsc& q, size_t* values, size_t n) { q.push_n(values, n); return n; });
+	});
+
+	bench::empty_line();
+
+	bench::run_batch("Mutex 4p", VALUES, [](size_t calls, bench::stopwatch& sw) { throughput_run<mutex_queue>(PRODUCERS, calls, sw); });
+	bench::run_batch("MPSC 4p", VALUES, [](size_t calls, bench::stopwatch& sw) { throughput_run<mpsc>(PRODUCERS, calls, sw); });
+
+	bench::header("stor::spsc_ring / stor::mpsc_queue latency (per round trip)");
+
+	bench::run_batch("Mutex", ROUND_TRIPS, [](size_t calls, bench::stopwatch& sw) { polling_round_trip<mutex_queue>(calls, sw); });
+	bench::run_batch("SPSC", ROUND_TRIPS, [](size_t calls, bench::stopwatch& sw) { polling_round_trip<ring>(calls, sw); });
+	bench::run_batch("MPSC", ROUND_TRIPS, [](size_t calls, bench::stopwatch& sw) { polling_round_trip<mpsc>(calls, sw); });
+
+	bench::empty_line();
+
+	// sleeping instead of polling
+	bench::run_batch("SPSC wait", ROUND_TRIPS, [](size_t calls, bench::stopwatch& sw)
+	{
+		round_trip_run<blocking_ring>(calls, sw,
+			[](blocking_ring& q, size_t value) { q.push_wait(value); },
+			[](blocking_ring& q) { size_t value = 0; q.pop_wait(value); return value; });
+	});
+	bench::run_batch("MPSC wait", ROUND_TRIPS, [](size_t calls, bench::stopwatch& sw)
+	{
+		round_trip_run<blocking_mpsc>(calls, sw,
+			[](blocking_mpsc& q, size_t value) { q.push(value); },
+			[](blocking_mpsc& q) { size_t value = 0; q.pop_wait(value); return value; });
+	});
+}
@@ -0,0 +1,80 @@
+#include "Benchmark.h"
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <cppu/stor/vector.h>
+
+namespace
+{
+	constexpr size_t VALUES = 1'000'000;
+	constexpr size_t FILL = 1'000;
+
+	template<typename T>
+	T make(size_t v)
+	{
+		if constexpr (std::is_same_v<T, std::string>)
+			return std::string(8, char('a' + (v & 15))); // fits the small string buffer, moves are copies
+		else
+			return T(v);
+	}
+
+	// fills a fresh vector, counted per element
+	template<class V, typename T>
+	void fill(size_t calls, bench::stopwatch& sw)
+	{
+		size_t out = 0;
+
+		sw.start();
+		for (size_t i = 0; i < calls; i += FILL)
+		{
+			V values;
+			for (size_t v = 0; v < FILL; ++v)
+				values.emplace_back(make<T>(v));
+
+			out += values.size();
+			bench::do_not_optimize(values);
+		}
+		sw.stop();
+
+		bench::do_not_optimize(out);
+	}
+
+	template<class V>
+	void iterate(size_t calls, bench::stopwatch& sw)
+	{
+		V values;
+		for (size_t v = 0; v < FILL; ++v)
+			values.emplace_back(v);
+
+		size_t out = 0;
+
+		sw.start();
+		for (size_t i = 0; i < calls; i += FILL)
+		{
+			bench::do_not_optimize(values);
+			for (size_t v = 0; v < FILL; ++v)
+				out += values[v];
+		}
+		sw.stop();
+
+		bench::do_not_optimize(out);
+	}
+}
+
+BENCHMARK(stor_vector)
+{
+	bench::header("STD = std::vector, CPPU = cppu::stor::vector, 1000 elements per vector (per element)");
+
+	bench::run_batch("STD fill", VALUES, fill<std::vector<size_t>, size_t>);
+	bench::run_batch("CPPU fill", VALUES, fill<cppu::stor::vector<size_t>, size_t>);
+	bench::empty_line();
+
+	bench::run_batch("STD string", VALUES, fill<std::vector<std::string>, std::string>);
+	bench::run_batch("CPPU string", VALUES, fill<cppu::stor::vector<std::string>, std::string>);
+	bench::empty_line();
+
+	bench::run_batch("STD iterate", VALUES, iterate<std::vector<size_t>>);
+	bench::run_batch("CPPU iterate", VALUES, iterate<cppu::stor::vector<size_t>>);
+}
@@ -0,0 +1,371 @@
+#pragma once
+
+#include <array>
+#include <cstdlib>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <functional>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+#ifdef _MSC_VER
+#define BENCH_NOINLINE __declspec(noinline)
+#define BENCH_FORCEINLINE __forceinline
+#else
+#define BENCH_NOINLINE __attribute__((noinline))
+#define BENCH_FORCEINLINE inline __attribute__((always_inline))
+#endif
+
+// Small benchmark harness, prints the same table as the cppu::function benchmark (see BENCHMARK.md)
+namespace bench
+{
+	constexpr size_t RERUNS = 9;
+
+	// keeps the compiler from optimizing a value (and the work leading up to it) away
+	template<typename T>
+	BENCH_FORCEINLINE void do_not_optimize(T&& value)
+	{
+#ifdef _MSC_VER
+		static volatile const void* sink;
+		sink = &value;
+#else
+		asm volatile("" : : "r,m"(value) : "memory");
+#endif
+	}
+
+	struct stopwatch
+	{
+		std::chrono::high_resolution_clock::time_point begin;
+		double elapsed = 0;
+
+		BENCH_FORCEINLINE void start()
+		{
+			begin = std::chrono::high_resolution_clock::now();
+		}
+
+		BENCH_FORCEINLINE void stop()
+		{
+			elapsed += std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - begin).count();
+		}
+	};
+
+	struct result
+	{
+		std::string suite;
+		std::string name;
+		size_t calls;
+		std::array<double, RERUNS> runs; // ns per call, sorted
+		double average;
+
+		double min() const { return runs[0]; }
+		double first_quartile() const { return runs[RERUNS / 4]; }
+		double median() const { return runs[RERUNS / 2]; }
+		double third_quartile() const { return runs[RERUNS - 1 - (RERUNS / 4)]; }
+		double max() const { return runs[RERUNS - 1]; }
+	};
+
+	inline std::vector<result>& results() { static std::vector<result> v; return v; }
+
+	// the suite being run, stored with its results
+	inline std::string& current_suite() { static std::string s; return s; }
+
+	// for runs that check their own results: a lost or doubled value aborts the bench, a broken queue isn't worth timing
+	inline void check(bool ok, const char* what)
+	{
+		if (!ok)
+		{
+			std::cerr << "check failed in " << current_suite() << ": " << what << '\n';
+			std::abort();
+		}
+	}
+
+	inline void empty_line()
+	{
+		std::cout << ' ' << std::setfill('-') << std::right << std::setw(13) << " |";
+		for (size_t i = 0; i < 6; ++i)
+			std::cout << ' ' << std::setw(15) << " |";
+		std::cout << '\n' << std::setfill(' ');
+	}
+
+	inline void header(const char* title)
+	{
+		std::cout << "\n## " << title << "\n";
+		std::cout << std::left << std::setw(12) << "Test" << " |" << std::right;
+		for (auto& name : { "Min", "1st Quartile", "Median", "3rd Quartile", "Max", "Average" })
+			std::cout << std::setw(14) << name << " |";
+		std::cout << '\n';
+		empty_line();
+	}
+
+	inline void report(const char* name, std::array<double, RERUNS> runs, size_t calls)
+	{
+		std::sort(runs.begin(), runs.end());
+
+		double total = 0;
+		for (double& run : runs)
+			total += run /= calls;
+
+		results().push_back({ current_suite(), name, calls, runs, total / RERUNS });
+		const result& r = results().back();
+
+		std::cout << std::fixed << std::setprecision(6);
+		std::cout << std::left << std::setw(12) << name << " |" << std::right;
+		std::cout << std::setw(14) << r.min() << " |";
+		std::cout << std::setw(14) << r.first_quartile() << " |";
+		std::cout << std::setw(14) << r.median() << " |";
+		std::cout << std::setw(14) << r.third_quartile() << " |";
+		std::cout << std::setw(14) << r.max() << " |";
+		std::cout << std::setw(14) << r.average << " |\n";
+	}
+
+	// times `calls` invocations of func()
+	template<typename _Func>
+	BENCH_NOINLINE void run(const char* name, size_t calls, _Func&& func)
+	{
+		std::array<double, RERUNS> runs;
+		for (size_t c = 0; c < RERUNS; ++c)
+		{
+			stopwatch sw;
+			sw.start();
+			for (size_t i = 0; i < calls; ++i)
+				func();
+			sw.stop();
+
+			runs[c] = sw.elapsed;
+		}
+
+		report(name, runs, calls);
+	}
+
+	// func(calls, stopwatch&) does its own loop and only times the parts between start() and stop()
+	template<typename _Func>
+	BENCH_NOINLINE void run_batch(const char* name, size_t calls, _Func&& func)
+	{
+		std::array<double, RERUNS> runs;
+		for (size_t c = 0; c < RERUNS; ++c)
+		{
+			stopwatch sw;
+			func(calls, sw);
+			runs[c] = sw.elapsed;
+		}
+
+		report(name, runs, calls);
+	}
+
+	struct suite
+	{
+		const char* name;
+		void(*func)();
+	};
+
+	inline std::vector<suite>& suites() { static std::vector<suite> v; return v; }
+
+	struct registrar
+	{
+		registrar(const char* name, void(*func)())
+		{
+			suites().push_back({ name, func });
+		}
+	};
+
+	inline const char* compiler()
+	{
+#if defined(__clang__)
+		return "Clang " __clang_version__;
+#elif defined(__GNUC__)
+		return "GCC " __VERSION__;
+#elif defined(_MSC_VER)
+		static const std::string name = "MSVC " + std::to_string(_MSC_FULL_VER);
+		return name.c_str();
+#else
+		return "unknown";
+#endif
+	}
+
+	inline std::string escape(const std::string& text)
+	{
+		std::string out;
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+				out += '\\';
+			out += c;
+		}
+
+		return out;
+	}
+
+	// one object per result, times in ns per call
+	inline void write_json(std::ostream& out)
+	{
+		out << std::fixed << std::setprecision(6);
+		out << "{\"compiler\":\"" << escape(compiler()) << "\",\"reruns\":" << RERUNS << ",\"results\":[";
+
+		for (size_t i = 0; i < results().size(); ++i)
+		{
+			const result& r = results()[i];
+			out << (i > 0 ? ",\n" : "\n") << "{\"suite\":\"" << escape(r.suite) << "\",\"name\":\"" << escape(r.name) << "\",\"calls\":" << r.calls
+				<< ",\"min\":" << r.min() << ",\"q1\":" << r.first_quartile() << ",\"median\":" << r.median()
+				<< ",\"q3\":" << r.third_quartile() << ",\"max\":" << r.max() << ",\"average\":" << r.average << ",\"runs\":[";
+
+			for (size_t run = 0; run < RERUNS; ++run)
+				out << (run > 0 ? "," : "") << r.runs[run];
+
+			out << "]}";
+		}
+
+		out << "\n]}\n";
+	}
+
+	inline void write_csv(std::ostream& out)
+	{
+		out << std::fixed << std::setprecision(6);
+		out << "suite,name,calls,min,q1,median,q3,max,average\n";
+
+		for (const result& r : results())
+		{
+			out << r.suite << ",\"" << r.name << "\"," << r.calls << ',' << r.min() << ',' << r.first_quartile() << ',' << r.median()
+				<< ',' << r.third_quartile() << ',' << r.max() << ',' << r.average << '\n';
+		}
+	}
+
+	// medians of an earlier --csv file by "suite/name"
+	inline std::map<std::string, double> read_medians(std::istream& in)
+	{
+		std::map<std::string, double> medians;
+		std::string line;
+		std::getline(in, line); // header
+
+		while (std::getline(in, line))
+		{
+			const size_t nameBegin = line.find(",\"");
+			const size_t nameEnd = line.find("\",", nameBegin + 2);
+			if (nameBegin == std::string::npos || nameEnd == std::string::npos)
+				continue;
+
+			// calls, min, q1, median
+			std::istringstream values(line.substr(nameEnd + 2));
+			std::string value;
+			for (size_t i = 0; i < 4 && std::getline(values, value, ','); ++i) { }
+
+			medians[line.substr(0, nameBegin) + "/" + line.substr(nameBegin + 2, nameEnd - nameBegin - 2)] = std::stod(value);
+		}
+
+		return medians;
+	}
+
+	// the median of every result next to the baseline's, a positive change is slower
+	inline void compare(const std::map<std::string, double>& baseline)
+	{
+		std::cout << "\n## Median compared to the baseline\n" << std::fixed << std::setprecision(6);
+		std::cout << std::left << std::setw(32) << "Test" << " |" << std::right;
+		for (auto& name : { "Baseline", "Median", "Change" })
+			std::cout << std::setw(14) << name << " |";
+		std::cout << '\n';
+
+		for (const result& r : results())
+		{
+			auto found = baseline.find(r.suite + "/" + r.name);
+			if (found == baseline.end())
+				continue;
+
+			std::cout << std::left << std::setw(32) << (r.suite + "/" + r.name) << " |" << std::right;
+			std::cout << std::setw(14) << found->second << " |" << std::setw(14) << r.median() << " |";
+			std::cout << std::setprecision(1) << std::showpos << std::setw(13) << (r.median() / found->second - 1) * 100 << "% |\n";
+			std::cout << std::noshowpos << std::setprecision(6);
+		}
+	}
+
+	// runs all registered suites, or only those whose name contains one of the arguments.
+	// --json <file> and --csv <file> also write every result to a file ("-" for stdout), --compare <file> shows the change of
+	// every median against an earlier --csv file, --list prints the suites
+	inline int run_all(int argc, char** argv)
+	{
+		std::vector<std::string> filters;
+		std::string jsonPath, csvPath, baselinePath;
+
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			if ((arg == "--json" || arg == "--csv" || arg == "--compare") && i + 1 < argc)
+				(arg == "--json" ? jsonPath : arg == "--csv" ? csvPath : baselinePath) = argv[++i];
+			else if (arg == "--list")
+			{
+				for (const suite& s : suites())
+					std::cout << s.name << '\n';
+				return 0;
+			}
+			else if (arg.compare(0, 2, "--") == 0)
+			{
+				std::cerr << "usage: " << argv[0] << " [--json <file>] [--csv <file>] [--compare <file>] [--list] [suite ...]\n";
+				return 1;
+			}
+			else
+				filters.push_back(arg);
+		}
+
+		std::map<std::string, double> baseline;
+		if (!baselinePath.empty())
+		{
+			std::ifstream file(baselinePath);
+			if (!file)
+			{
+				std::cerr << "can't read " << baselinePath << '\n';
+				return 1;
+			}
+
+			baseline = read_medians(file);
+		}
+
+		std::cout << "# " << compiler() << '\n';
+
+		for (const suite& s : suites())
+		{
+			bool selected = filters.empty();
+			for (size_t i = 0; i < filters.size() && !selected; ++i)
+				selected = std::string(s.name).find(filters[i]) != std::string::npos;
+
+			if (selected)
+			{
+				current_suite() = s.name;
+				s.func();
+			}
+		}
+
+		if (!baselinePath.empty())
+			compare(baseline);
+
+		for (const std::string* path : { &jsonPath, &csvPath })
+		{
+			if (path->empty())
+				continue;
+
+			void(*write)(std::ostream&) = path == &jsonPath ? &write_json : &write_csv;
+			if (*path == "-")
+				write(std::cout);
+			else
+			{
+				std::ofstream file(*path);
+				if (!file)
+				{
+					std::cerr << "can't write " << *path << '\n';
+					return 1;
+				}
+
+				write(file);
+			}
+		}
+
+		return 0;
+	}
+}
+
+#define BENCHMARK(NAME) \
+	static void bench_##NAME(); \
+	static bench::registrar bench_registrar_##NAME(#NAME, &bench_##NAME); \
+	static void bench_##NAME()